@@ -56,7 +56,7 @@ typedef union {
 
 // Slow path variables
 VerilatedMutex Verilated::m_mutex;
-VerilatedVoidCb Verilated::s_flushCb = NULL;
+VerilatedVoidCb Verilated::s_flushCbs[Verilated::FLUSH_CBS_MAX] = {};
 
 // Keep below together in one cache line
 Verilated::Serialized Verilated::s_s;
@@ -242,11 +242,15 @@ Verilated::NonSerialized::NonSerialized() {
     s_profThreadsStart = 1;
     s_profThreadsWindow = 2;
     s_profThreadsFilenamep = strdup("profile_threads.dat");
+    s_threadsAffinityp = strdup("");
 }
 Verilated::NonSerialized::~NonSerialized() {
     if (s_profThreadsFilenamep) {
         free(const_cast<char*>(s_profThreadsFilenamep)); s_profThreadsFilenamep=NULL;
     }
+    if (s_threadsAffinityp) {
+        free(const_cast<char*>(s_threadsAffinityp)); s_threadsAffinityp=NULL;
+    }
 }
 
 //===========================================================================
@@ -1958,8 +1962,13 @@ Verilated::ThreadLocal::ThreadLocal()
 #ifdef VL_THREADED
     t_mtaskId(0),
     t_endOfEvalReqd(0),
+    t_threadNum(0),
 #endif
     t_dpiScopep(NULL), t_dpiFilename(0), t_dpiLineno(0) {
+#ifdef VL_THREADED
+    static std::atomic<vluint32_t> s_nextThreadNum(0);
+    t_threadNum = s_nextThreadNum.fetch_add(1, std::memory_order_relaxed);
+#endif
 }
 Verilated::ThreadLocal::~ThreadLocal() {
 }
@@ -2027,6 +2036,11 @@ void Verilated::profThreadsFilenamep(const char* flagp) VL_MT_SAFE {
     if (s_ns.s_profThreadsFilenamep) free(const_cast<char*>(s_ns.s_profThreadsFilenamep));
     s_ns.s_profThreadsFilenamep = strdup(flagp);
 }
+void Verilated::threadsAffinity(const char* cpusp) VL_MT_SAFE {
+    VerilatedLockGuard lock(m_mutex);
+    if (s_ns.s_threadsAffinityp) free(const_cast<char*>(s_ns.s_threadsAffinityp));
+    s_ns.s_threadsAffinityp = strdup(cpusp);
+}
 
 
 const char* Verilated::catName(const char* n1, const char* n2, const char* delimiter) VL_MT_SAFE {
@@ -2048,18 +2062,17 @@ const char* Verilated::catName(const char* n1, const char* n2, const char* delim
 
 void Verilated::flushCb(VerilatedVoidCb cb) VL_MT_SAFE {
     VerilatedLockGuard lock(m_mutex);
-    if (s_flushCb == cb) {}  // Ok - don't duplicate
-    else if (!s_flushCb) { s_flushCb=cb; }
-    else {  // LCOV_EXCL_LINE
-        // Someday we may allow multiple callbacks ala atexit(), but until then
-        VL_FATAL_MT("unknown", 0, "",  // LCOV_EXCL_LINE
-                    "Verilated::flushCb called twice with different callbacks");
+    for (int i = 0; i < FLUSH_CBS_MAX; ++i) {
+        if (s_flushCbs[i] == cb) return;  // Ok - don't duplicate
+        if (!s_flushCbs[i]) { s_flushCbs[i] = cb; return; }
     }
+    VL_FATAL_MT("unknown", 0, "",  // LCOV_EXCL_LINE
+                "Verilated::flushCb called with too many different callbacks");
 }
 
 void Verilated::flushCall() VL_MT_SAFE {
     VerilatedLockGuard lock(m_mutex);
-    if (s_flushCb) (*s_flushCb)();
+    for (int i = 0; i < FLUSH_CBS_MAX && s_flushCbs[i]; ++i) (*s_flushCbs[i])();
     fflush(stderr);
     fflush(stdout);
 }
@@ -2214,6 +2227,9 @@ void VerilatedImp::commandArgVl(const std::string& arg) {
         else if (commandArgVlValue(arg, "+verilator+seed+", value/*ref*/)) {
             Verilated::randSeed(atoi(value.c_str()));
         }
+        else if (commandArgVlValue(arg, "+verilator+threads+affinity+", value/*ref*/)) {
+            Verilated::threadsAffinity(value.c_str());
+        }
         else if (arg == "+verilator+noassert") {
             Verilated::assertOn(false);
         }
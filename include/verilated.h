@@ -355,7 +355,8 @@ class Verilated {
     // Slow path variables
     static VerilatedMutex m_mutex;  ///< Mutex for s_s/s_ns members, when VL_THREADED
 
-    static VerilatedVoidCb s_flushCb;  ///< Flush callback function
+    enum { FLUSH_CBS_MAX = 4 };  ///< Number of flush callbacks, one per trace format
+    static VerilatedVoidCb s_flushCbs[FLUSH_CBS_MAX];  ///< Flush callback functions
 
     static struct Serialized {  // All these members serialized/deserialized
         // Fast path
@@ -380,6 +381,7 @@ class Verilated {
         vluint32_t s_profThreadsWindow;  ///< +prof+threads window size
         // Slow path
         const char* s_profThreadsFilenamep;  ///< +prof+threads filename
+        const char* s_threadsAffinityp;  ///< +threads+affinity CPU list
         NonSerialized();
         ~NonSerialized();
     } s_ns;
@@ -399,6 +401,7 @@ class Verilated {
 #ifdef VL_THREADED
         vluint32_t t_mtaskId;  ///< Current mtask# executing on this thread
         vluint32_t t_endOfEvalReqd;  ///< Messages may be pending, thread needs endOf-eval calls
+        vluint32_t t_threadNum;  ///< Sequence number of this thread, for per-thread data
 #endif
         const VerilatedScope* t_dpiScopep;  ///< DPI context scope
         const char* t_dpiFilename;  ///< DPI context filename
@@ -466,8 +469,14 @@ public:
     static vluint32_t profThreadsWindow() VL_MT_SAFE { return s_ns.s_profThreadsWindow; }
     static void profThreadsFilenamep(const char* flagp) VL_MT_SAFE;
     static const char* profThreadsFilenamep() VL_MT_SAFE { return s_ns.s_profThreadsFilenamep; }
-
-    /// Flush callback for VCD waves
+    /// --threads worker placement: "" to not pin threads, "numa" to pin
+    /// to the eval thread's NUMA node, or a CPU list such as "0,2,4-7" for
+    /// the eval thread then each worker.  Must be set before constructing
+    /// the model.
+    static void threadsAffinity(const char* cpusp) VL_MT_SAFE;
+    static const char* threadsAffinity() VL_MT_SAFE { return s_ns.s_threadsAffinityp; }
+
+    /// Flush callback for VCD and other trace waves; each distinct callback is called once
     static void flushCb(VerilatedVoidCb cb) VL_MT_SAFE;
     static void flushCall() VL_MT_SAFE;
 
@@ -533,6 +542,9 @@ public:
     /// Set the mtaskId, called when an mtask starts
     static void mtaskId(vluint32_t id) VL_MT_SAFE { t_s.t_mtaskId = id; }
     static vluint32_t mtaskId() VL_MT_SAFE { return t_s.t_mtaskId; }
+    /// Sequence number of this thread, in order of first use of Verilated
+    /// by each thread; used to select a shard of per-thread data
+    static vluint32_t threadNum() VL_MT_SAFE { return t_s.t_threadNum; }
     static void endOfEvalReqdInc() VL_MT_SAFE { ++t_s.t_endOfEvalReqd; }
     static void endOfEvalReqdDec() VL_MT_SAFE { --t_s.t_endOfEvalReqd; }
 
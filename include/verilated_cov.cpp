@@ -78,6 +78,32 @@ public:
     virtual ~VerilatedCoverItemSpec() VL_OVERRIDE {}
 };
 
+//=============================================================================
+/// VerilatedCoverItemSpec for a count split into per-thread shards, which are
+/// summed when the count is read.
+
+template <class T> class VerilatedCoverShardedItemSpec : public VerilatedCovImpItem {
+private:
+    // MEMBERS
+    T*  m_countp;  ///< Count value of first shard
+    int m_shards;  ///< Number of shards
+    size_t m_stride;  ///< Elements from one shard's count to the next
+public:
+    // METHODS
+    virtual vluint64_t count() const VL_OVERRIDE {
+        vluint64_t sum = 0;
+        for (int i = 0; i < m_shards; ++i) sum += m_countp[i * m_stride];
+        return sum;
+    }
+    virtual void zero() const VL_OVERRIDE {
+        for (int i = 0; i < m_shards; ++i) m_countp[i * m_stride] = 0;
+    }
+    // CONSTRUCTORS
+    VerilatedCoverShardedItemSpec(T* countp, int shards, size_t stride)
+        : m_countp(countp), m_shards(shards), m_stride(stride) { zero(); }
+    virtual ~VerilatedCoverShardedItemSpec() VL_OVERRIDE {}
+};
+
 //=============================================================================
 // VerilatedCovImp
 /// Implementation class for VerilatedCov.  See that class for public method information.
@@ -325,7 +351,13 @@ public:
         m_insertp = NULL;
     }
 
-    void write(const char* filename) VL_EXCLUDES(m_mutex) {
+    static void putBinary(std::ostream& os, vluint64_t value, int bytes) VL_MT_SAFE {
+        char buf[8];
+        for (int i = 0; i < bytes; ++i) buf[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        os.write(buf, bytes);
+    }
+
+    void write(const char* filename, bool binary) VL_EXCLUDES(m_mutex) {
         Verilated::quiesce();
         VerilatedLockGuard lock(m_mutex);
 #ifndef VM_COVERAGE
@@ -333,13 +365,13 @@ public:
 #endif
         selftest();
 
-        std::ofstream os(filename);
+        std::ofstream os(filename, binary ? (std::ios::out | std::ios::binary) : std::ios::out);
         if (os.fail()) {
             std::string msg = std::string("%Error: Can't write '")+filename+"'";
             VL_FATAL_MT("", 0, "", msg.c_str());
             return;
         }
-        os << "# SystemC::Coverage-3\n";
+        if (!binary) os << "# SystemC::Coverage-3\n";
 
         // Build list of events; totalize if collapsing hierarchy
         typedef std::map<std::string,std::pair<std::string,vluint64_t> > EventMap;
@@ -386,6 +418,29 @@ public:
             }
         }
 
+        if (binary) {
+            std::string names;
+            for (EventMap::const_iterator it=eventCounts.begin(); it!=eventCounts.end(); ++it) {
+                names += it->first;
+                if (!it->second.first.empty()) {
+                    names += keyValueFormatter(VL_CIK_HIER, it->second.first);
+                }
+                names += '\0';
+            }
+            os.write(VL_COV_BIN_MAGIC, VL_COV_BIN_MAGIC_BYTES);
+            putBinary(os, eventCounts.size(), 4);
+            putBinary(os, eventCounts.size(), 4);
+            putBinary(os, names.size(), 8);
+            os.write(names.data(), names.size());
+            vluint32_t index = 0;
+            for (EventMap::const_iterator it=eventCounts.begin(); it!=eventCounts.end(); ++it) {
+                putBinary(os, index++, 4);
+                putBinary(os, 0, 4);
+                putBinary(os, it->second.second, 8);
+            }
+            return;
+        }
+
         // Output body
         for (EventMap::const_iterator it=eventCounts.begin(); it!=eventCounts.end(); ++it) {
             os<<"C '"<<std::dec;
@@ -410,7 +465,10 @@ void VerilatedCov::zero() VL_MT_SAFE {
     VerilatedCovImp::imp().zero();
 }
 void VerilatedCov::write(const char* filenamep) VL_MT_SAFE {
-    VerilatedCovImp::imp().write(filenamep);
+    VerilatedCovImp::imp().write(filenamep, false);
+}
+void VerilatedCov::writeBinary(const char* filenamep) VL_MT_SAFE {
+    VerilatedCovImp::imp().write(filenamep, true);
 }
 void VerilatedCov::_inserti(vluint32_t* itemp) VL_MT_SAFE {
     VerilatedCovImp::imp().inserti(new VerilatedCoverItemSpec<vluint32_t>(itemp));
@@ -418,6 +476,10 @@ void VerilatedCov::_inserti(vluint32_t* itemp) VL_MT_SAFE {
 void VerilatedCov::_inserti(vluint64_t* itemp) VL_MT_SAFE {
     VerilatedCovImp::imp().inserti(new VerilatedCoverItemSpec<vluint64_t>(itemp));
 }
+void VerilatedCov::_inserti(vluint32_t* itemp, int shards, size_t stride) VL_MT_SAFE {
+    VerilatedCovImp::imp().inserti(
+        new VerilatedCoverShardedItemSpec<vluint32_t>(itemp, shards, stride));
+}
 void VerilatedCov::_insertf(const char* filename, int lineno) VL_MT_SAFE {
     VerilatedCovImp::imp().insertf(filename, lineno);
 }
@@ -24,6 +24,9 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#ifdef VL_THREADED
+# include <atomic>
+#endif
 
 //=============================================================================
 /// Conditionally compile coverage code
@@ -67,6 +70,24 @@
                 VerilatedCov::_insertf(__FILE__, __LINE__); \
                 VerilatedCov::_insertp("hier", name(), __VA_ARGS__))
 
+/// Insert a item whose count is split into per-thread shards.
+/// As with VL_COVER_INSERT, but the count is the sum of the 'shards' counts
+/// at countp, countp+stride, countp+2*stride, etc.
+
+#define VL_COVER_INSERT_SHARDED(countp,shards,stride,...) \
+    VL_IF_COVER(VerilatedCov::_inserti(countp, shards, stride); \
+                VerilatedCov::_insertf(__FILE__, __LINE__); \
+                VerilatedCov::_insertp("hier", name(), __VA_ARGS__))
+
+#ifdef VL_THREADED
+/// Increment a count in a per-thread shard.  Threads normally have their
+/// own shard, so this needs no atomic read-modify-write; but should two
+/// threads share a shard, a count may be lost, which is harmless.
+inline void vlCovShardInc(std::atomic<vluint32_t>& count) VL_MT_SAFE {
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+#endif
+
 //=============================================================================
 /// Convert VL_COVER_INSERT value arguments to strings
 
@@ -89,6 +110,11 @@ public:
     static const char* defaultFilename() VL_PURE { return "coverage.dat"; }
     /// Write all coverage data to a file
     static void write(const char* filenamep = defaultFilename()) VL_MT_SAFE;
+    /// Return default binary filename
+    static const char* defaultBinaryFilename() VL_PURE { return "coverage.bin"; }
+    /// Write all coverage data to a file, in the compact binary format read
+    /// by verilator_coverage
+    static void writeBinary(const char* filenamep = defaultBinaryFilename()) VL_MT_SAFE;
     /// Insert a coverage item
     /// We accept from 1-30 key/value pairs, all as strings.
     /// Call _insert1, followed by _insert2 and _insert3
@@ -96,6 +122,7 @@ public:
     // _insert1: Remember item pointer with count.  (Not const, as may add zeroing function)
     static void _inserti(vluint32_t* itemp) VL_MT_SAFE;
     static void _inserti(vluint64_t* itemp) VL_MT_SAFE;
+    static void _inserti(vluint32_t* itemp, int shards, size_t stride) VL_MT_SAFE;
     // _insert2: Set default filename and line number
     static void _insertf(const char* filename, int lineno) VL_MT_SAFE;
     // _insert3: Set parameters
@@ -23,6 +23,24 @@
 
 #include <string>
 
+//=============================================================================
+// Binary coverage data file format, written by VerilatedCov::writeBinary
+// and read by verilator_coverage.  All integers are little endian.
+//
+//   char[8]  VL_COV_BIN_MAGIC
+//   u32      Number of names
+//   u32      Number of points
+//   u64      Bytes of names
+//   Names, each the text between the quotes of a coverage.dat "C" line,
+//   followed by a NUL.  Files written by the same model have identical
+//   names, so readers may reuse their lookup of a previous file's names.
+//   Points, each a u32 index into the names, u32 zero, and u64 count
+
+#define VL_COV_BIN_MAGIC "VLCOVB1\n"  ///< Binary coverage file magic, 1 is the version
+#define VL_COV_BIN_MAGIC_BYTES 8  ///< Bytes in VL_COV_BIN_MAGIC
+#define VL_COV_BIN_HEADER_BYTES 24  ///< Bytes in magic through bytes of names
+#define VL_COV_BIN_POINT_BYTES 16  ///< Bytes in each point record
+
 //=============================================================================
 // Data used to edit below file, using vlcovgen
 
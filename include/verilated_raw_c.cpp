@@ -0,0 +1,319 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//=============================================================================
+//
+// THIS MODULE IS PUBLICLY LICENSED
+//
+// Copyright 2001-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//=============================================================================
+///
+/// \file
+/// \brief C++ Tracing in raw change log format
+///
+//=============================================================================
+// SPDIFF_OFF
+
+#include "verilatedos.h"
+#include "verilated.h"
+#include "verilated_raw_c.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+// SPDIFF_ON
+
+#ifndef O_LARGEFILE  // For example on WIN32
+# define O_LARGEFILE 0
+#endif
+#ifndef O_BINARY  // Not needed except on WIN32
+# define O_BINARY 0
+#endif
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+//=============================================================================
+// VerilatedRawSingleton
+/// Open raw traces, so an early exit can flush them
+
+class VerilatedRawSingleton {
+private:
+    typedef std::vector<VerilatedRaw*> RawVec;
+    struct Singleton {
+        VerilatedMutex s_rawMutex;  ///< Protect the singleton
+        RawVec s_rawVec VL_GUARDED_BY(s_rawMutex);  ///< List of all open traces
+    };
+    static Singleton& singleton() { static Singleton s; return s; }
+public:
+    static void pushRaw(VerilatedRaw* rawp) VL_EXCLUDES(singleton().s_rawMutex) {
+        VerilatedLockGuard lock(singleton().s_rawMutex);
+        singleton().s_rawVec.push_back(rawp);
+    }
+    static void removeRaw(const VerilatedRaw* rawp) VL_EXCLUDES(singleton().s_rawMutex) {
+        VerilatedLockGuard lock(singleton().s_rawMutex);
+        RawVec::iterator pos = find(singleton().s_rawVec.begin(),
+                                    singleton().s_rawVec.end(), rawp);
+        if (pos != singleton().s_rawVec.end()) { singleton().s_rawVec.erase(pos); }
+    }
+    static void flush_all() VL_EXCLUDES(singleton().s_rawMutex) VL_MT_UNSAFE_ONE {
+        VerilatedLockGuard lock(singleton().s_rawMutex);
+        for (RawVec::const_iterator it = singleton().s_rawVec.begin();
+             it != singleton().s_rawVec.end(); ++it) {
+            (*it)->flush();
+        }
+    }
+};
+
+//=============================================================================
+// VerilatedRawCallInfo
+/// Internal callback routines for each module being traced.
+
+class VerilatedRawCallInfo {
+protected:
+    friend class VerilatedRaw;
+    VerilatedRawCallback_t m_initcb;  ///< Initialization Callback function
+    VerilatedRawCallback_t m_fullcb;  ///< Full Dumping Callback function
+    VerilatedRawCallback_t m_changecb;  ///< Incremental Dumping Callback function
+    void* m_userthis;  ///< Fake "this" for caller
+    vluint32_t m_code;  ///< Starting code number (set later by open)
+    // CONSTRUCTORS
+    VerilatedRawCallInfo(VerilatedRawCallback_t icb, VerilatedRawCallback_t fcb,
+                         VerilatedRawCallback_t changecb, void* ut)
+        : m_initcb(icb)
+        , m_fullcb(fcb)
+        , m_changecb(changecb)
+        , m_userthis(ut)
+        , m_code(1) {}
+    ~VerilatedRawCallInfo() {}
+};
+
+//=============================================================================
+//=============================================================================
+//=============================================================================
+// Opening/Closing
+
+VerilatedRaw::VerilatedRaw()
+    : m_fd(-1)
+    , m_isOpen(false)
+    , m_scopeEscape('.')
+    , m_fullDump(true)
+    , m_nextCode(1)
+    , m_timeRes("1ns") {
+    m_wrChunkSize = 8*1024;
+    m_wrBufp = new vluint32_t [m_wrChunkSize*8];
+    m_wrFlushp = m_wrBufp + m_wrChunkSize * 6;
+    m_writep = m_wrBufp;
+    m_sigs_oldvalp = NULL;
+}
+
+VerilatedRaw::~VerilatedRaw() {
+    close();
+    if (m_wrBufp) { delete[] m_wrBufp; m_wrBufp = NULL; }
+    if (m_sigs_oldvalp) { delete[] m_sigs_oldvalp; m_sigs_oldvalp = NULL; }
+    for (CallbackVec::const_iterator it = m_callbacks.begin(); it != m_callbacks.end(); ++it) {
+        delete (*it);
+    }
+    m_callbacks.clear();
+    VerilatedRawSingleton::removeRaw(this);
+}
+
+void VerilatedRaw::open(const char* filename) VL_MT_UNSAFE_ONE {
+    m_assertOne.check();
+    if (isOpen()) return;
+
+    m_filename = filename;
+    m_fd = ::open(m_filename.c_str(),
+                  O_CREAT|O_WRONLY|O_TRUNC|O_LARGEFILE|O_BINARY|O_CLOEXEC, 0666);
+    if (m_fd < 0) return;  // User code can check isOpen()
+    m_isOpen = true;
+    m_fullDump = true;  // First dump must be full
+    VerilatedRawSingleton::pushRaw(this);
+    // Set callback so an early exit will flush us
+    Verilated::flushCb(&flush_all);
+
+    // Callbacks will call decl* which update m_nextCode and m_decls
+    m_nextCode = 1;
+    m_decls = "";
+    for (vluint32_t ent = 0; ent < m_callbacks.size(); ++ent) {
+        VerilatedRawCallInfo* cip = m_callbacks[ent];
+        cip->m_code = m_nextCode;
+        (cip->m_initcb)(this, cip->m_userthis, cip->m_code);
+    }
+    writeStr("VLRAW 1\n");
+    writeStr("timescale " + m_timeRes + "\n");
+    writeStr(m_decls);
+    writeStr("data\n");
+    m_decls = "";
+
+    // Allocate space now we know the number of codes
+    if (!m_sigs_oldvalp) {
+        m_sigs_oldvalp = new vluint32_t [m_nextCode+10];
+    }
+}
+
+void VerilatedRaw::close() VL_MT_UNSAFE_ONE {
+    m_assertOne.check();
+    if (!isOpen()) return;
+    VerilatedRawSingleton::removeRaw(this);
+    bufferFlush();
+    m_isOpen = false;
+    ::close(m_fd);
+}
+
+void VerilatedRaw::flush_all() VL_MT_UNSAFE_ONE {
+    VerilatedRawSingleton::flush_all();
+}
+
+void VerilatedRaw::bufferResize(vluint64_t minsize) {
+    // minsize is size of largest record.  We buffer at least 8 times as much data,
+    // writing when we are 3/4 full (with thus 2*minsize remaining free)
+    if (VL_UNLIKELY(minsize > m_wrChunkSize)) {
+        vluint32_t* oldbufp = m_wrBufp;
+        m_wrChunkSize = minsize*2;
+        m_wrBufp = new vluint32_t [m_wrChunkSize * 8];
+        memcpy(m_wrBufp, oldbufp, (m_writep - oldbufp) * sizeof(vluint32_t));
+        m_writep = m_wrBufp + (m_writep - oldbufp);
+        m_wrFlushp = m_wrBufp + m_wrChunkSize * 6;
+        delete [] oldbufp; oldbufp=NULL;
+    }
+}
+
+void VerilatedRaw::bufferFlush() VL_MT_UNSAFE_ONE {
+    // This function is on the flush() call path
+    m_assertOne.check();
+    if (VL_UNLIKELY(!isOpen())) return;
+    const char* wp = reinterpret_cast<const char*>(m_wrBufp);
+    const char* endp = reinterpret_cast<const char*>(m_writep);
+    while (wp < endp) {
+        errno = 0;
+        ssize_t got = ::write(m_fd, wp, endp - wp);
+        if (got > 0) {
+            wp += got;
+        } else if (got < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                // write failed, presume error (perhaps out of disk space)
+                std::string msg = std::string("VerilatedRaw::bufferFlush: ")+strerror(errno);
+                VL_FATAL_MT("", 0, "", msg.c_str());
+                m_isOpen = false;
+                ::close(m_fd);  // May get error, just ignore it
+                break;
+            }
+        }
+    }
+    // Reset buffer
+    m_writep = m_wrBufp;
+}
+
+void VerilatedRaw::writeStr(const std::string& str) {
+    // Header text bypasses the record buffer, so records stay word aligned
+    bufferFlush();
+    const char* wp = str.c_str();
+    const char* endp = wp + str.length();
+    while (isOpen() && wp < endp) {
+        ssize_t got = ::write(m_fd, wp, endp - wp);
+        if (got > 0) {
+            wp += got;
+        } else if (got < 0 && errno != EAGAIN && errno != EINTR) {
+            std::string msg = std::string("VerilatedRaw::writeStr: ")+strerror(errno);
+            VL_FATAL_MT("", 0, "", msg.c_str());
+            m_isOpen = false;
+            ::close(m_fd);
+        }
+    }
+}
+
+//=============================================================================
+// Definitions
+
+void VerilatedRaw::declare(vluint32_t code, const char* name, const char* kindp,
+                           bool array, int arraynum, int msb, int lsb) {
+    if (!code) { VL_FATAL_MT(__FILE__, __LINE__, "",
+                             "Internal: internal trace problem, code 0 is illegal"); }
+
+    int bits = ((msb > lsb) ? (msb - lsb) : (lsb - msb)) + 1;
+    // Same code spacing as VerilatedVcd, as Verilated code is shared
+    m_nextCode = std::max(m_nextCode, code + 1 + static_cast<vluint32_t>(bits / 32));
+
+    // Make sure write buffer is large enough for a record
+    bufferResize(VL_WORDS_I(bits) + 3);
+
+    // Split name into scopes and basename, the same way as VerilatedVcd:
+    // Space separates each level of scope, tab separates final scope from
+    // signal name
+    std::string nameasstr = name;
+    if (!m_modName.empty()) {
+        nameasstr = m_modName+m_scopeEscape+nameasstr;  // Optional ->module prefix
+    }
+    std::string hiername;
+    std::string basename;
+    for (const char* cp=nameasstr.c_str(); *cp; cp++) {
+        if (isScopeEscape(*cp)) {
+            // Ahh, we've just read a scope, not a basename
+            if (!hiername.empty()) hiername += " ";
+            hiername += basename;
+            basename = "";
+        } else {
+            basename += *cp;
+        }
+    }
+    hiername += "\t"+basename;
+
+    char buf[1000];
+    VL_SNPRINTF(buf, sizeof(buf), "var %u %s %d %d %d ",
+                code, kindp, msb, lsb, array ? arraynum : -1);
+    m_decls += buf;
+    m_decls += hiername;
+    m_decls += "\n";
+}
+
+//=============================================================================
+// Callbacks
+
+void VerilatedRaw::addCallback(VerilatedRawCallback_t initcb, VerilatedRawCallback_t fullcb,
+                               VerilatedRawCallback_t changecb, void* userthis) VL_MT_UNSAFE_ONE {
+    m_assertOne.check();
+    if (VL_UNLIKELY(isOpen())) {
+        std::string msg = std::string("Internal: ") + __FILE__ + "::" + __FUNCTION__
+                          + " called with already open file";
+        VL_FATAL_MT(__FILE__, __LINE__, "", msg.c_str());
+    }
+    VerilatedRawCallInfo* cip = new VerilatedRawCallInfo(initcb, fullcb, changecb, userthis);
+    m_callbacks.push_back(cip);
+}
+
+//=============================================================================
+// Dumping
+
+void VerilatedRaw::dump(vluint64_t timeui) {
+    m_assertOne.check();
+    if (!isOpen()) return;
+    *m_writep++ = 0;  // Time record
+    *m_writep++ = static_cast<vluint32_t>(timeui);
+    *m_writep++ = static_cast<vluint32_t>(timeui >> VL_ULL(32));
+    bufferCheck();
+    Verilated::quiesce();
+    if (VL_UNLIKELY(m_fullDump)) {
+        m_fullDump = false;  // No more need for next dump to be full
+        for (vluint32_t ent = 0; ent < m_callbacks.size(); ++ent) {
+            VerilatedRawCallInfo* cip = m_callbacks[ent];
+            (cip->m_fullcb)(this, cip->m_userthis, cip->m_code);
+        }
+        return;
+    }
+    for (vluint32_t ent = 0; ent < m_callbacks.size(); ++ent) {
+        VerilatedRawCallInfo* cip = m_callbacks[ent];
+        (cip->m_changecb)(this, cip->m_userthis, cip->m_code);
+    }
+}
@@ -0,0 +1,286 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//=============================================================================
+//
+// THIS MODULE IS PUBLICLY LICENSED
+//
+// Copyright 2001-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//=============================================================================
+///
+/// \file
+/// \brief C++ Tracing in raw change log format
+///
+/// The raw format has no encoding cost at simulation time; each change is
+/// appended as the signal's code followed by its value words.  Convert it
+/// to VCD or FST afterwards using verilator_rawtrace.
+///
+/// File format: A text header, starting with "VLRAW 1", with one "var"
+/// line per signal, ending with a "data" line.  Then binary records of
+/// host-order 32-bit words: either a code, followed by that signal's value
+/// words, or a 0, followed by the low and high words of a new time.
+///
+//=============================================================================
+// SPDIFF_OFF
+
+#ifndef _VERILATED_RAW_C_H_
+#define _VERILATED_RAW_C_H_ 1
+
+#include "verilatedos.h"
+#include "verilated.h"
+
+#include <string>
+#include <vector>
+
+class VerilatedRaw;
+class VerilatedRawCallInfo;
+
+// SPDIFF_ON
+//=============================================================================
+
+typedef void (*VerilatedRawCallback_t)(VerilatedRaw* vcdp, void* userthis, vluint32_t code);
+
+//=============================================================================
+// VerilatedRaw
+/// Base class to create a Verilator raw change log dump.  The declaration
+/// and dumping routines match VerilatedVcd, so Verilated code may call either.
+/// This is an internally used class - see VerilatedRawC for what to call from applications
+
+class VerilatedRaw {
+private:
+    int                 m_fd;           ///< File descriptor we're writing to
+    bool                m_isOpen;       ///< True indicates open file
+    std::string         m_filename;     ///< Filename we're writing to (if open)
+    char                m_scopeEscape;  ///< Character to separate scope components
+    bool                m_fullDump;     ///< True indicates dump ignoring if changed
+    vluint32_t          m_nextCode;     ///< Next code number to assign
+    std::string         m_modName;      ///< Module name being traced now
+    std::string         m_timeRes;      ///< Time resolution (ns/ms etc)
+
+    vluint32_t*         m_wrBufp;       ///< Output buffer
+    vluint32_t*         m_wrFlushp;     ///< Output buffer flush trigger location
+    vluint32_t*         m_writep;       ///< Write pointer into output buffer
+    vluint64_t          m_wrChunkSize;  ///< Output buffer size, in words
+
+    vluint32_t*         m_sigs_oldvalp; ///< Pointer to old signal values
+    typedef std::vector<VerilatedRawCallInfo*> CallbackVec;
+    CallbackVec m_callbacks;  ///< Routines to perform dumping
+    std::string m_decls;  ///< Header "var" lines, built by decl*()
+
+    VerilatedAssertOneThread m_assertOne;  ///< Assert only called from single thread
+
+    void bufferResize(vluint64_t minsize);
+    void bufferFlush() VL_MT_UNSAFE_ONE;
+    inline void bufferCheck() {
+        // Flush the write buffer if there's not enough space left for new information
+        // We only call this once per vector, so we need enough slop for a very wide record
+        if (VL_UNLIKELY(m_writep > m_wrFlushp)) { bufferFlush(); }
+    }
+    void writeStr(const std::string& str);
+    void declare(vluint32_t code, const char* name, const char* kindp, bool array, int arraynum,
+                 int msb, int lsb);
+
+    // CONSTRUCTORS
+    VL_UNCOPYABLE(VerilatedRaw);
+public:
+    VerilatedRaw();
+    ~VerilatedRaw();
+    /// Routines can only be called from one thread; allow next call from different thread
+    void changeThread() { m_assertOne.changeThread(); }
+
+    // ACCESSORS
+    /// Is file open?
+    bool isOpen() const { return m_isOpen; }
+    /// Change character that splits scopes.  Note whitespace are ALWAYS escapes.
+    void scopeEscape(char flag) { m_scopeEscape = flag; }
+    /// Is this an escape?
+    inline bool isScopeEscape(char c) { return isspace(c) || c == m_scopeEscape; }
+
+    // METHODS
+    void open(const char* filename) VL_MT_UNSAFE_ONE;  ///< Open the file; call isOpen() to see if errors
+    void close() VL_MT_UNSAFE_ONE;  ///< Close the file
+    /// Flush any remaining data to this file
+    void flush() VL_MT_UNSAFE_ONE { bufferFlush(); }
+    /// Flush any remaining data from all files
+    static void flush_all() VL_MT_UNSAFE_ONE;
+
+    void set_time_unit(const char*) {}  ///< Ignored; as with VCD only resolution is recorded
+    /// Set time resolution (s/ms, defaults to ns)
+    void set_time_resolution(const char* unitp) { m_timeRes = unitp; }
+
+    /// Inside dumping routines, called each cycle to make the dump
+    void dump(vluint64_t timeui);
+
+    /// Inside dumping routines, declare callbacks for tracings
+    void addCallback(VerilatedRawCallback_t initcb, VerilatedRawCallback_t fullcb,
+                     VerilatedRawCallback_t changecb,
+                     void* userthis) VL_MT_UNSAFE_ONE;
+
+    /// Inside dumping routines, declare a module
+    void module(const std::string& name) { m_assertOne.check(); m_modName = name; }
+    /// Inside dumping routines, declare a signal
+    void declBit(vluint32_t code, const char* name, bool array, int arraynum) {
+        declare(code, name, "bit", array, arraynum, 0, 0);
+    }
+    void declBus(vluint32_t code, const char* name, bool array, int arraynum, int msb, int lsb) {
+        declare(code, name, "bus", array, arraynum, msb, lsb);
+    }
+    void declQuad(vluint32_t code, const char* name, bool array, int arraynum, int msb, int lsb) {
+        declare(code, name, "quad", array, arraynum, msb, lsb);
+    }
+    void declArray(vluint32_t code, const char* name, bool array, int arraynum,
+                   int msb, int lsb) {
+        declare(code, name, "array", array, arraynum, msb, lsb);
+    }
+    void declDouble(vluint32_t code, const char* name, bool array, int arraynum) {
+        declare(code, name, "double", array, arraynum, 63, 0);
+    }
+    void declFloat(vluint32_t code, const char* name, bool array, int arraynum) {
+        declare(code, name, "float", array, arraynum, 31, 0);
+    }
+
+    //=========================================================================
+    // Inside dumping routines, dump one signal, faster when not inlined
+    // due to code size reduction.
+    void fullBit(vluint32_t code, const vluint32_t newval) {
+        m_sigs_oldvalp[code] = newval;
+        *m_writep++ = code; *m_writep++ = newval;
+        bufferCheck();
+    }
+    void fullBus(vluint32_t code, const vluint32_t newval, int bits) {
+        m_sigs_oldvalp[code] = newval;
+        *m_writep++ = code; *m_writep++ = newval;
+        bufferCheck();
+    }
+    void fullQuad(vluint32_t code, const vluint64_t newval, int bits) {
+        (*(reinterpret_cast<vluint64_t*>(&m_sigs_oldvalp[code]))) = newval;
+        *m_writep++ = code;
+        *m_writep++ = static_cast<vluint32_t>(newval);
+        *m_writep++ = static_cast<vluint32_t>(newval >> VL_ULL(32));
+        bufferCheck();
+    }
+    void fullArray(vluint32_t code, const vluint32_t* newval, int bits) {
+        *m_writep++ = code;
+        for (int word = 0; word < VL_WORDS_I(bits); ++word) {
+            m_sigs_oldvalp[code + word] = newval[word];
+            *m_writep++ = newval[word];
+        }
+        bufferCheck();
+    }
+    void fullArray(vluint32_t code, const vluint64_t* newval, int bits) {
+        *m_writep++ = code;
+        for (int word = 0; word < VL_WORDS_I(bits); ++word) {
+            vluint32_t part = static_cast<vluint32_t>(newval[word / 2] >> ((word & 1) * 32));
+            m_sigs_oldvalp[code + word] = part;
+            *m_writep++ = part;
+        }
+        bufferCheck();
+    }
+    void fullDouble(vluint32_t code, const double newval) {
+        // cppcheck-suppress invalidPointerCast
+        (*(reinterpret_cast<double*>(&m_sigs_oldvalp[code]))) = newval;
+        *m_writep++ = code;
+        memcpy(m_writep, &newval, sizeof(double));
+        m_writep += sizeof(double) / sizeof(vluint32_t);
+        bufferCheck();
+    }
+    void fullFloat(vluint32_t code, const float newval) {
+        // cppcheck-suppress invalidPointerCast
+        (*(reinterpret_cast<float*>(&m_sigs_oldvalp[code]))) = newval;
+        *m_writep++ = code;
+        memcpy(m_writep, &newval, sizeof(float));
+        m_writep += sizeof(float) / sizeof(vluint32_t);
+        bufferCheck();
+    }
+
+    /// Inside dumping routines, dump one signal if it has changed
+    inline void chgBit(vluint32_t code, const vluint32_t newval) {
+        if (VL_UNLIKELY(m_sigs_oldvalp[code] != newval)) fullBit(code, newval);
+    }
+    inline void chgBus(vluint32_t code, const vluint32_t newval, int bits) {
+        if (VL_UNLIKELY(m_sigs_oldvalp[code] != newval)) fullBus(code, newval, bits);
+    }
+    inline void chgQuad(vluint32_t code, const vluint64_t newval, int bits) {
+        if (VL_UNLIKELY((*(reinterpret_cast<vluint64_t*>(&m_sigs_oldvalp[code]))) != newval)) {
+            fullQuad(code, newval, bits);
+        }
+    }
+    inline void chgArray(vluint32_t code, const vluint32_t* newval, int bits) {
+        for (int word = 0; word < VL_WORDS_I(bits); ++word) {
+            if (VL_UNLIKELY(m_sigs_oldvalp[code + word] != newval[word])) {
+                fullArray(code, newval, bits);
+                return;
+            }
+        }
+    }
+    inline void chgArray(vluint32_t code, const vluint64_t* newval, int bits) {
+        for (int word = 0; word < VL_WORDS_I(bits); ++word) {
+            if (VL_UNLIKELY(m_sigs_oldvalp[code + word]
+                            != static_cast<vluint32_t>(newval[word / 2] >> ((word & 1) * 32)))) {
+                fullArray(code, newval, bits);
+                return;
+            }
+        }
+    }
+    inline void chgDouble(vluint32_t code, const double newval) {
+        // cppcheck-suppress invalidPointerCast
+        if (VL_UNLIKELY((*(reinterpret_cast<double*>(&m_sigs_oldvalp[code]))) != newval)) {
+            fullDouble(code, newval);
+        }
+    }
+    inline void chgFloat(vluint32_t code, const float newval) {
+        // cppcheck-suppress invalidPointerCast
+        if (VL_UNLIKELY((*(reinterpret_cast<float*>(&m_sigs_oldvalp[code]))) != newval)) {
+            fullFloat(code, newval);
+        }
+    }
+};
+
+//=============================================================================
+// VerilatedRawC
+/// Create a raw change log dump file in C standalone (no SystemC) simulations.
+/// Thread safety: Unless otherwise indicated, every function is VL_MT_UNSAFE_ONE
+
+class VerilatedRawC {
+    VerilatedRaw m_sptrace;  ///< Trace file being created
+
+    // CONSTRUCTORS
+    VL_UNCOPYABLE(VerilatedRawC);
+public:
+    VerilatedRawC() {}
+    ~VerilatedRawC() { close(); }
+    /// Routines can only be called from one thread; allow next call from different thread
+    void changeThread() { spTrace()->changeThread(); }
+public:
+    // ACCESSORS
+    /// Is file open?
+    bool isOpen() const { return m_sptrace.isOpen(); }
+    // METHODS
+    /// Open a new raw file
+    void open(const char* filename) VL_MT_UNSAFE_ONE { m_sptrace.open(filename); }
+    /// Close dump
+    void close() VL_MT_UNSAFE_ONE { m_sptrace.close(); }
+    /// Flush dump
+    void flush() VL_MT_UNSAFE_ONE { m_sptrace.flush(); }
+    /// Write one cycle of dump data
+    void dump(vluint64_t timeui) { m_sptrace.dump(timeui); }
+    /// Write one cycle of dump data - backward compatible and to reduce
+    /// conversion warnings.  It's better to use a vluint64_t time instead.
+    void dump(double timestamp) { dump(static_cast<vluint64_t>(timestamp)); }
+    void dump(vluint32_t timestamp) { dump(static_cast<vluint64_t>(timestamp)); }
+    void dump(int timestamp) { dump(static_cast<vluint64_t>(timestamp)); }
+    /// Set time units (s/ms, defaults to ns)
+    void set_time_unit(const char* unit) { m_sptrace.set_time_unit(unit); }
+    void set_time_unit(const std::string& unit) { set_time_unit(unit.c_str()); }
+    /// Set time resolution (s/ms, defaults to ns)
+    void set_time_resolution(const char* unit) { m_sptrace.set_time_resolution(unit); }
+    void set_time_resolution(const std::string& unit) { set_time_resolution(unit.c_str()); }
+
+    /// Internal class access
+    inline VerilatedRaw* spTrace() { return &m_sptrace; }
+};
+
+#endif  // guard
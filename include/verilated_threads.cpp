@@ -17,11 +17,17 @@
 #include "verilatedos.h"
 #include "verilated_threads.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <fstream>
+#include <sstream>
 
 std::atomic<vluint64_t> VlMTaskVertex::s_yields;
 
 VL_THREAD_LOCAL VlThreadPool::ProfileTrace* VlThreadPool::t_profilep = NULL;
+VL_THREAD_LOCAL VlWorkDeque* VlThreadPool::t_dequep = NULL;
+VL_THREAD_LOCAL VlThreadPool* VlThreadPool::t_evalPoolp = NULL;
+VlThreadPool* VlThreadPool::s_sharedp = NULL;
 
 //=============================================================================
 // VlMTaskVertex
@@ -32,12 +38,27 @@ VlMTaskVertex::VlMTaskVertex(vluint32_t upstreamDepCount)
     assert(atomic_is_lock_free(&m_upstreamDepsDone));
 }
 
+//=============================================================================
+// VlWorkDeque
+
+VlWorkDeque::VlWorkDeque(vluint32_t capacity)
+    : m_top(0)
+    , m_bottom(0) {
+    vlsint64_t size = 1;
+    while (size < capacity) size <<= 1;
+    m_slotsp = new Slot[size];
+    m_mask = size - 1;
+}
+
 //=============================================================================
 // VlWorkerThread
 
-VlWorkerThread::VlWorkerThread(VlThreadPool* poolp, bool profiling)
-    : m_ready_size(0)
+VlWorkerThread::VlWorkerThread(VlThreadPool* poolp, VlWorkDeque* dequep, bool profiling)
+    : m_head(0)
+    , m_tail(0)
+    , m_waiting(false)
     , m_poolp(poolp)
+    , m_dequep(dequep)
     , m_profiling(profiling)
     , m_exiting(false)
       // Must init this last -- after setting up fields that it might read:
@@ -54,6 +75,10 @@ void VlWorkerThread::workerLoop() {
     if (VL_UNLIKELY(m_profiling)) {
         m_poolp->setupProfilingClientThread();
     }
+    VlThreadPool::t_dequep = m_dequep;
+    // Any static eval on our pool is waiting on us, so one nested in a
+    // task we run must not wait on the pool
+    VlThreadPool::t_evalPoolp = m_poolp;
 
     ExecRec work;
     work.m_fnp = NULL;
@@ -78,6 +103,10 @@ void VlWorkerThread::workerLoop() {
     }
 }
 
+bool VlWorkerThread::pinToCpu(unsigned cpu) {
+    return VlThreadPool::pinThread(m_cthread.native_handle(), cpu);
+}
+
 void VlWorkerThread::startWorker(VlWorkerThread* workerp) {
     workerp->workerLoop();
 }
@@ -85,21 +114,37 @@ void VlWorkerThread::startWorker(VlWorkerThread* workerp) {
 //=============================================================================
 // VlThreadPool
 
-VlThreadPool::VlThreadPool(int nThreads, bool profiling)
-    : m_profiling(profiling) {
+VlThreadPool::VlThreadPool(int nThreads, bool profiling, vluint32_t dequeCapacity,
+                           int evalThreads)
+    : m_profiling(profiling)
+    , m_evalDequeBusyp(NULL)
+    , m_dynRuns(0)
+    , m_shared(false)
+    , m_staticEvals(0)
+    , m_evalPrevp(NULL) {
     // --threads N passes nThreads=N-1, as the "main" threads counts as 1
     unsigned cpus = std::thread::hardware_concurrency();
     if (cpus < nThreads+1) {
-        static int warnedOnce = 0;
-        if (!warnedOnce++) {
+        static std::atomic<bool> s_warned(false);
+        if (!s_warned.exchange(true)) {
             VL_PRINTF_MT("%%Warning: System has %u CPUs but model Verilated with"
                          " --threads %d; may run slow.\n", cpus, nThreads+1);
         }
     }
     // Create'em
+    if (dequeCapacity) {
+        // One per worker, plus one per eval thread
+        for (int i = 0; i < nThreads + evalThreads; ++i) {
+            m_deques.push_back(new VlWorkDeque(dequeCapacity));
+        }
+        m_evalDequeBusyp = new std::atomic<bool>[evalThreads];
+        for (int i = 0; i < evalThreads; ++i) m_evalDequeBusyp[i] = false;
+    }
     for (int i=0; i<nThreads; ++i) {
-        m_workers.push_back(new VlWorkerThread(this, profiling));
+        m_workers.push_back(new VlWorkerThread(this, dequeCapacity ? m_deques[i] : NULL,
+                                               profiling));
     }
+    if (Verilated::threadsAffinity()[0]) setupAffinity(Verilated::threadsAffinity());
     // Set up a profile buffer for the current thread too -- on the
     // assumption that it's the same thread that calls eval and may be
     // donated to run mtasks during the eval.
@@ -113,11 +158,292 @@ VlThreadPool::~VlThreadPool() {
         // Each ~WorkerThread will wait for its thread to exit.
         delete m_workers[i];
     }
+    for (size_t i = 0; i < m_deques.size(); ++i) delete m_deques[i];
+    delete[] m_evalDequeBusyp;
+    if (s_sharedp == this) s_sharedp = NULL;
     if (VL_UNLIKELY(m_profiling)) {
         tearDownProfilingClientThread();
     }
 }
 
+bool VlThreadPool::dynamicRunOne(size_t* victimp) {
+    VlWorkDeque::Task task;
+    bool found = t_dequep->pop(&task);
+    // Otherwise steal, round-robin from where we last succeeded
+    for (size_t i = 0; !found && i < m_deques.size(); ++i) {
+        VlWorkDeque* victimDequep = m_deques[*victimp];
+        if (victimDequep != t_dequep) found = victimDequep->steal(&task);
+        if (!found && ++*victimp >= m_deques.size()) *victimp = 0;
+    }
+    if (!found) return false;
+    task.m_fnp(task.m_evenCycle, task.m_sym);
+    return true;
+}
+
+void VlThreadPool::dynamicWorker(bool, VlThrSymTab poolp) {
+    VlThreadPool* selfp = static_cast<VlThreadPool*>(poolp);
+    size_t victim = 0;
+    unsigned ct = 0;
+    // Keep helping until no eval thread is waiting on a graph. We may have
+    // been recruited late and overlap the next dynamicRun; that's
+    // harmless, we just help with that one too. Static evals take
+    // priority: their tasks are queued behind us and wait on each other,
+    // while dynamic runs complete without us.
+    while (selfp->m_dynRuns.load(std::memory_order_acquire) > 0
+           && !selfp->m_staticEvals.load(std::memory_order_acquire)) {
+        if (selfp->dynamicRunOne(&victim)) {
+            ct = 0;
+        } else {
+            VL_CPU_RELAX();
+            if (VL_UNLIKELY(++ct > VL_LOCK_SPINS)) {
+                ct = 0;
+                VlMTaskVertex::yieldThread();
+            }
+        }
+    }
+}
+
+void VlThreadPool::dynamicRun(const VlExecFnp* rootsp, size_t nRoots, VlThrSymTab sym,
+                              const VlMTaskVertex* finalp, bool evenCycle) {
+    assert(!m_deques.empty());
+    // Claim a deque for this thread, unless it already owns one (it's a
+    // worker of this pool, e.g. a DPI call from an mtask evaluating another
+    // model that shares the pool)
+    VlWorkDeque* const prevDequep = t_dequep;
+    if (prevDequep
+        && std::find(m_deques.begin(), m_deques.end(), prevDequep) == m_deques.end()) {
+        t_dequep = NULL;  // Owned in some other pool
+    }
+    size_t claimed = m_deques.size();
+    while (!t_dequep) {
+        for (size_t i = m_workers.size(); i < m_deques.size(); ++i) {
+            bool expected = false;
+            if (m_evalDequeBusyp[i - m_workers.size()].compare_exchange_strong(expected, true)) {
+                claimed = i;
+                t_dequep = m_deques[i];
+                break;
+            }
+        }
+        // More eval threads than the pool was constructed for; wait
+        if (!t_dequep) VlMTaskVertex::yieldThread();
+    }
+    for (size_t i = 0; i < nRoots; ++i) dynamicPush(rootsp[i], evenCycle, sym);
+
+    m_dynRuns.fetch_add(1, std::memory_order_release);
+    // When shared, the workers may be busy with a static eval, perhaps
+    // one this thread is inside of; they're not needed for progress, so
+    // don't wait for them
+    if (!m_shared
+        || (t_evalPoolp != this && !m_staticEvals.load(std::memory_order_acquire)
+            && m_evalMutex.try_lock())) {
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            // A worker that has yet to start an earlier recruitment will
+            // help with this run when it does
+            if (!m_workers[i]->pendingWork()) {
+                m_workers[i]->addTask(dynamicWorker, evenCycle, this);
+            }
+        }
+        if (m_shared) m_evalMutex.unlock();
+    }
+    size_t victim = 0;
+    unsigned ct = 0;
+    while (!finalp->areUpstreamDepsDone(evenCycle)) {
+        if (dynamicRunOne(&victim)) {
+            ct = 0;
+        } else {
+            VL_CPU_RELAX();
+            if (VL_UNLIKELY(++ct > VL_LOCK_SPINS)) {
+                ct = 0;
+                VlMTaskVertex::yieldThread();
+            }
+        }
+    }
+    // All our tasks are complete, so our deque is empty
+    m_dynRuns.fetch_sub(1, std::memory_order_release);
+    t_dequep = prevDequep;
+    if (claimed < m_deques.size()) {
+        m_evalDequeBusyp[claimed - m_workers.size()].store(false, std::memory_order_release);
+    }
+}
+
+namespace {
+// One parallelFor call; lives on the caller's stack
+struct VlParallelForJob {
+    VlThreadPool::ParallelFnp m_fnp;
+    void* m_userp;
+    int m_n;
+    std::atomic<int> m_next;  // Next index to claim
+    std::atomic<int> m_helpers;  // Workers yet to finish helping
+    void runAll() {
+        for (int i; (i = m_next.fetch_add(1, std::memory_order_relaxed)) < m_n;) {
+            m_fnp(m_userp, i);
+        }
+    }
+};
+}  // namespace
+
+void VlThreadPool::parallelForWorker(bool, VlThrSymTab jobp) {
+    VlParallelForJob* selfp = static_cast<VlParallelForJob*>(jobp);
+    selfp->runAll();
+    // Caller may return and destroy the job once this reaches zero
+    selfp->m_helpers.fetch_sub(1, std::memory_order_release);
+}
+
+void VlThreadPool::parallelFor(ParallelFnp fnp, void* userp, int n) {
+    VlParallelForJob job;
+    job.m_fnp = fnp;
+    job.m_userp = userp;
+    job.m_n = n;
+    job.m_next = 0;
+    int helpers = std::min(n - 1, static_cast<int>(m_workers.size()));
+    if (helpers < 0) helpers = 0;
+    if (staticBegin()) {
+        job.m_helpers = helpers;
+        for (int i = 0; i < helpers; ++i) {
+            m_workers[i]->addTask(parallelForWorker, false, &job);
+        }
+        staticEnd();
+    } else {
+        job.m_helpers = 0;  // Nested in a static eval, run it all here
+    }
+    job.runAll();
+    unsigned ct = 0;
+    while (job.m_helpers.load(std::memory_order_acquire)) {
+        VL_CPU_RELAX();
+        if (VL_UNLIKELY(++ct > VL_LOCK_SPINS)) {
+            ct = 0;
+            VlMTaskVertex::yieldThread();
+        }
+    }
+}
+
+void VlThreadPool::shared(VlThreadPool* poolp) {
+    if (s_sharedp) s_sharedp->m_shared = false;
+    s_sharedp = poolp;
+    if (poolp) poolp->m_shared = true;
+}
+
+VlThreadPool* VlThreadPool::acquire(int nThreads, bool profiling, vluint32_t dequeCapacity) {
+    if (VlThreadPool* sharedp = s_sharedp) {
+        // Profiling needs per-thread setup in every eval thread, so
+        // profiled models always get their own pool
+        bool ok = !profiling && !sharedp->m_profiling
+                  && (dequeCapacity ? !sharedp->m_deques.empty()
+                                    : sharedp->numThreads() >= nThreads);
+        if (VL_LIKELY(ok)) return sharedp;
+        static std::atomic<bool> s_warned(false);
+        if (!s_warned.exchange(true)) {
+            VL_PRINTF_MT("%%Warning: Shared thread pool cannot run a model Verilated with"
+                         " --threads %d%s%s; model will use its own threads\n",
+                         nThreads + 1, profiling ? " --prof-threads" : "",
+                         dequeCapacity ? " --threads-schedule dynamic" : "");
+        }
+    }
+    return new VlThreadPool(nThreads, profiling, dequeCapacity);
+}
+
+void VlThreadPool::release(VlThreadPool* poolp) {
+    if (poolp && !poolp->m_shared) delete poolp;
+}
+
+bool VlThreadPool::pinThread(std::thread::native_handle_type handle, unsigned cpu) {
+#if defined(__linux)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return 0 == pthread_setaffinity_np(handle, sizeof(cpuset), &cpuset);
+#else
+    return false;
+#endif
+}
+
+std::vector<unsigned> VlThreadPool::parseCpuList(const std::string& cpus) {
+    // Linux cpulist format, e.g. "0,2,4-7"; empty result on error
+    std::vector<unsigned> result;
+    std::istringstream is(cpus);
+    std::string item;
+    while (std::getline(is, item, ',')) {
+        unsigned first;
+        unsigned last;
+        char dash;
+        std::istringstream iis(item);
+        if (!(iis >> first)) return std::vector<unsigned>();
+        if (iis >> dash) {
+            if (dash != '-' || !(iis >> last) || last < first) return std::vector<unsigned>();
+        } else {
+            last = first;
+        }
+        for (unsigned cpu = first; cpu <= last; ++cpu) result.push_back(cpu);
+    }
+    return result;
+}
+
+std::vector<unsigned> VlThreadPool::numaNodeCpus(unsigned cpu) {
+    // Return the CPUs sharing a NUMA node with the given CPU, starting
+    // with that CPU; empty if unknown
+    std::vector<unsigned> result;
+#if defined(__linux)
+    for (int node = 0;; ++node) {
+        std::ostringstream filename;
+        filename << "/sys/devices/system/node/node" << node << "/cpulist";
+        std::ifstream ifs(filename.str().c_str());
+        if (!ifs) break;
+        std::string line;
+        std::getline(ifs, line);
+        std::vector<unsigned> nodeCpus = parseCpuList(line);
+        for (size_t i = 0; i < nodeCpus.size(); ++i) {
+            if (nodeCpus[i] != cpu) continue;
+            // Rotate so the given CPU comes first, then those after it
+            result.insert(result.end(), nodeCpus.begin() + i, nodeCpus.end());
+            result.insert(result.end(), nodeCpus.begin(), nodeCpus.begin() + i);
+            return result;
+        }
+    }
+#endif
+    return result;
+}
+
+void VlThreadPool::setupAffinity(const std::string& affinity) {
+#if !defined(__linux)
+    VL_PRINTF_MT("%%Warning: +verilator+threads+affinity+%s: Thread affinity is not"
+                 " supported on this system\n", affinity.c_str());
+#else
+    // The constructing thread is the eval thread, it gets the first CPU
+    std::vector<unsigned> cpus;
+    if (affinity == "numa") {
+        int cpu = VlProfileRec::getcpu();
+        if (cpu >= 0) cpus = numaNodeCpus(cpu);
+        if (cpus.empty()) {
+            VL_PRINTF_MT("%%Warning: +verilator+threads+affinity+numa: NUMA topology unknown;"
+                         " threads not pinned\n");
+            return;
+        }
+    } else {
+        cpus = parseCpuList(affinity);
+        if (cpus.empty()) {
+            VL_PRINTF_MT("%%Warning: Bad CPU list in +verilator+threads+affinity+%s;"
+                         " threads not pinned\n", affinity.c_str());
+            return;
+        }
+    }
+    if (cpus.size() < m_workers.size() + 1) {
+        // With NUMA, we'd rather share CPUs than spill onto another node
+        VL_PRINTF_MT("%%Warning: +verilator+threads+affinity+%s lists %d CPUs, but"
+                     " the model uses %d threads; CPUs will be shared\n",
+                     affinity.c_str(), static_cast<int>(cpus.size()),
+                     static_cast<int>(m_workers.size() + 1));
+    }
+    bool ok = pinThread(pthread_self(), cpus[0]);
+    for (size_t i = 0; ok && i < m_workers.size(); ++i) {
+        ok = m_workers[i]->pinToCpu(cpus[(i + 1) % cpus.size()]);
+    }
+    if (!ok) {
+        VL_PRINTF_MT("%%Warning: +verilator+threads+affinity+%s: Unable to set thread"
+                     " affinity\n", affinity.c_str());
+    }
+#endif
+}
+
 void VlThreadPool::tearDownProfilingClientThread() {
     assert(t_profilep);
     delete t_profilep;
@@ -164,6 +490,10 @@ void VlThreadPool::profileDump(const char* filenamep, vluint64_t ticksElapsed) {
             Verilated::profThreadsStart());
     fprintf(fp, "VLPROF arg +verilator+prof+threads+window+%u\n",
             Verilated::profThreadsWindow());
+    if (Verilated::threadsAffinity()[0]) {
+        fprintf(fp, "VLPROF arg +verilator+threads+affinity+%s\n",
+                Verilated::threadsAffinity());
+    }
     fprintf(fp, "VLPROF stat yields %" VL_PRI64 "u\n",
             VlMTaskVertex::yields());
 
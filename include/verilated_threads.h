@@ -81,15 +81,18 @@ public:
     // Upstream mtasks must call this when they complete.
     // Returns true when the current MTaskVertex becomes ready to execute,
     // false while it's still waiting on more dependencies.
+    // (Acquire as well as release, as with dynamic scheduling the last
+    // upstream mtask to complete is the one that dispatches this mtask,
+    // which must observe the results of all the other upstream mtasks.)
     inline bool signalUpstreamDone(bool evenCycle) {
         if (evenCycle) {
             vluint32_t upstreamDepsDone
-                = 1 + m_upstreamDepsDone.fetch_add(1, std::memory_order_release);
+                = 1 + m_upstreamDepsDone.fetch_add(1, std::memory_order_acq_rel);
             assert(upstreamDepsDone <= m_upstreamDepCount);
             return (upstreamDepsDone == m_upstreamDepCount);
         } else {
             vluint32_t upstreamDepsDone_prev
-                = m_upstreamDepsDone.fetch_sub(1, std::memory_order_release);
+                = m_upstreamDepsDone.fetch_sub(1, std::memory_order_acq_rel);
             assert(upstreamDepsDone_prev > 0);
             return (upstreamDepsDone_prev == 1);
         }
@@ -166,6 +169,97 @@ public:
 
 class VlThreadPool;
 
+/// Fixed capacity work-stealing deque, used when the model was Verilated
+/// with --threads-schedule dynamic.  This is the Chase-Lev deque (see Le
+/// et al., "Correct and Efficient Work-Stealing for Weak Memory Models"),
+/// minus the growable buffer: only the owning thread may push() or pop()
+/// at the bottom, any other thread may steal() from the top.  push()
+/// returns false when full, in which case the owner should run the task
+/// itself.
+class VlWorkDeque {
+public:
+    // TYPES
+    struct Task {
+        VlExecFnp m_fnp;  // Function to execute
+        VlThrSymTab m_sym;  // Symbol table to execute
+        bool m_evenCycle;  // Even/odd for flag alternation
+    };
+private:
+    // Slot fields are atomic only so a steal() racing with a push() into a
+    // recycled slot is well defined; the loser of the race on m_top
+    // discards what it read, so relaxed ordering suffices.
+    struct Slot {
+        std::atomic<VlExecFnp> m_fnp;
+        std::atomic<VlThrSymTab> m_sym;
+        std::atomic<bool> m_evenCycle;
+    };
+
+    // MEMBERS
+    // Thieves contend on m_top, the owner alone writes m_bottom; keep them
+    // on separate cache lines.
+    std::atomic<vlsint64_t> m_top;
+    char m_pad1[VL_CACHE_LINE_BYTES];
+    std::atomic<vlsint64_t> m_bottom;
+    char m_pad2[VL_CACHE_LINE_BYTES];
+    Slot* m_slotsp;  // Circular buffer, m_mask+1 entries
+    vlsint64_t m_mask;  // Capacity-1; capacity is a power of 2
+
+    VL_UNCOPYABLE(VlWorkDeque);
+
+public:
+    // CONSTRUCTORS
+    // Capacity is rounded up to a power of two
+    explicit VlWorkDeque(vluint32_t capacity);
+    ~VlWorkDeque() { delete[] m_slotsp; }
+
+    // METHODS
+    inline bool push(VlExecFnp fnp, bool evenCycle, VlThrSymTab sym) {
+        vlsint64_t b = m_bottom.load(std::memory_order_relaxed);
+        vlsint64_t t = m_top.load(std::memory_order_acquire);
+        if (VL_UNLIKELY(b - t > m_mask)) return false;  // Full
+        Slot& slot = m_slotsp[b & m_mask];
+        slot.m_fnp.store(fnp, std::memory_order_relaxed);
+        slot.m_sym.store(sym, std::memory_order_relaxed);
+        slot.m_evenCycle.store(evenCycle, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+    inline bool pop(Task* taskp) {
+        vlsint64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        vlsint64_t t = m_top.load(std::memory_order_relaxed);
+        if (t > b) {  // Empty
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        read(b, taskp);
+        if (t != b) return true;  // More than one element, no thief can interfere
+        // Last element; race against thieves for it
+        bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    inline bool steal(Task* taskp) {
+        vlsint64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        vlsint64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;  // Empty
+        read(t, taskp);
+        return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+    }
+private:
+    inline void read(vlsint64_t index, Task* taskp) const {
+        const Slot& slot = m_slotsp[index & m_mask];
+        taskp->m_fnp = slot.m_fnp.load(std::memory_order_relaxed);
+        taskp->m_sym = slot.m_sym.load(std::memory_order_relaxed);
+        taskp->m_evenCycle = slot.m_evenCycle.load(std::memory_order_relaxed);
+    }
+};
+
 class VlWorkerThread {
 private:
     // TYPES
@@ -178,20 +272,28 @@ private:
             : m_fnp(fnp), m_sym(sym), m_evenCycle(evenCycle) {}
     };
 
+    // Each eval() hands each worker at most one task (its static thread
+    // root, or a dynamic scheduling recruitment), so a few slots give the
+    // worker slack to fall a couple of evals behind.
+    enum { RING_SIZE = 4 };  // Power of 2
+
     // MEMBERS
+    // Single-producer (the eval thread), single-consumer (this worker)
+    // ring buffer. The producer only writes m_tail, the consumer only
+    // writes m_head, so no lock is needed unless the worker goes to sleep.
+    ExecRec m_ring[RING_SIZE];
+    std::atomic<vluint32_t> m_head;  // Next slot to consume
+    char m_pad[VL_CACHE_LINE_BYTES];
+    std::atomic<vluint32_t> m_tail;  // Next slot to produce
+
+    // Sleeping, after spinning on an empty ring for a while
     VerilatedMutex m_mutex;
     std::condition_variable_any m_cv;
     // Only notify the condition_variable if the worker is waiting
-    bool m_waiting VL_GUARDED_BY(m_mutex);
-
-    // Why a vector? We expect the pending list to be very short, typically
-    // 0 or 1 or 2, so popping from the front shouldn't be
-    // expensive. Revisit if we ever have longer queues...
-    std::vector<ExecRec> m_ready VL_GUARDED_BY(m_mutex);
-    // Store the size atomically, so we can spin wait
-    std::atomic<size_t> m_ready_size;
+    std::atomic<bool> m_waiting;
 
     VlThreadPool* m_poolp;  // Our associated thread pool
+    VlWorkDeque* m_dequep;  // Our work-stealing deque, or NULL if static scheduling
 
     bool m_profiling;  // Is profiling enabled?
     std::atomic<bool> m_exiting;  // Worker thread should exit
@@ -201,46 +303,56 @@ private:
 
 public:
     // CONSTRUCTORS
-    explicit VlWorkerThread(VlThreadPool* poolp, bool profiling);
+    VlWorkerThread(VlThreadPool* poolp, VlWorkDeque* dequep, bool profiling);
     ~VlWorkerThread();
 
     // METHODS
     inline void dequeWork(ExecRec* workp) {
+        vluint32_t head = m_head.load(std::memory_order_relaxed);
         // Spin for a while, waiting for new data
         for (int i = 0; i < VL_LOCK_SPINS; ++i) {
-            if (VL_LIKELY(m_ready_size.load(std::memory_order_relaxed))) {
-                break;
-            }
+            if (VL_LIKELY(m_tail.load(std::memory_order_acquire) != head)) break;
             VL_CPU_RELAX();
         }
-        VerilatedLockGuard lk(m_mutex);
-        while (m_ready.empty()) {
-            m_waiting = true;
-            m_cv.wait(lk);
+        if (VL_UNLIKELY(m_tail.load(std::memory_order_acquire) == head)) {
+            // Still nothing; sleep. Setting m_waiting before rechecking the
+            // tail pairs with addTask's tail store before checking
+            // m_waiting, so one of us sees the other (both are seq_cst).
+            VerilatedLockGuard lk(m_mutex);
+            m_waiting.store(true);
+            while (m_tail.load() == head) m_cv.wait(lk);
+            m_waiting.store(false, std::memory_order_relaxed);
         }
-        m_waiting = false;
-        // As noted above this is inefficient if our ready list is ever
-        // long (but it shouldn't be)
-        *workp = m_ready.front();
-        m_ready.erase(m_ready.begin());
-        m_ready_size.fetch_sub(1, std::memory_order_relaxed);
+        *workp = m_ring[head & (RING_SIZE - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+    }
+    // True if a task has been added that the worker has not yet started
+    inline bool pendingWork() const {
+        return m_tail.load(std::memory_order_relaxed) != m_head.load(std::memory_order_acquire);
     }
     inline void wakeUp() { addTask(nullptr, false, nullptr); }
     inline void addTask(VlExecFnp fnp, bool evenCycle, VlThrSymTab sym) {
-        bool notify;
-        {
-            VerilatedLockGuard lk(m_mutex);
-            m_ready.emplace_back(fnp, evenCycle, sym);
-            m_ready_size.fetch_add(1, std::memory_order_relaxed);
-            notify = m_waiting;
+        vluint32_t tail = m_tail.load(std::memory_order_relaxed);
+        // Full only if this worker is several evals behind; wait for it
+        while (VL_UNLIKELY(tail - m_head.load(std::memory_order_acquire) >= RING_SIZE)) {
+            VlMTaskVertex::yieldThread();
+        }
+        m_ring[tail & (RING_SIZE - 1)] = ExecRec(fnp, evenCycle, sym);
+        m_tail.store(tail + 1);
+        if (VL_UNLIKELY(m_waiting.load())) {
+            // Taking the lock ensures the worker is inside m_cv.wait
+            { VerilatedLockGuard lk(m_mutex); }
+            m_cv.notify_one();
         }
-        if (notify) m_cv.notify_one();
     }
+    // Restrict this worker to run only on the given CPU
+    bool pinToCpu(unsigned cpu);
     void workerLoop();
     static void startWorker(VlWorkerThread* workerp);
 };
 
 class VlThreadPool {
+    friend class VlWorkerThread;
     // TYPES
     typedef std::vector<VlProfileRec> ProfileTrace;
     typedef std::set<ProfileTrace*> ProfileSet;
@@ -259,14 +371,46 @@ class VlThreadPool {
     ProfileSet m_allProfiles VL_GUARDED_BY(m_mutex);
     VerilatedMutex m_mutex;
 
+    // Dynamic scheduling support. Each worker owns one deque, followed by
+    // one deque for each thread that may be in dynamicRun concurrently.
+    std::vector<VlWorkDeque*> m_deques;
+    std::atomic<bool>* m_evalDequeBusyp;  // Which eval thread deques are claimed
+    std::atomic<int> m_dynRuns;  // Number of dynamicRun() in progress
+    static VL_THREAD_LOCAL VlWorkDeque* t_dequep;  // Deque owned by this thread
+
+    // Sharing between models
+    static VlThreadPool* s_sharedp;  // Pool for new models to use, or NULL
+    bool m_shared;  // Models may call eval() concurrently on separate threads
+    VerilatedMutex m_evalMutex;  // When m_shared, held while dispatching to workers
+    std::atomic<int> m_staticEvals;  // Static evals waiting for or holding m_evalMutex
+    VlThreadPool* m_evalPrevp;  // t_evalPoolp before the static eval holding m_evalMutex
+    static VL_THREAD_LOCAL VlThreadPool* t_evalPoolp;  // Pool this thread runs a static eval on
+
 public:
     // CONSTRUCTORS
     // Construct a thread pool with 'nThreads' dedicated threads. The thread
     // pool will create these threads and make them available to execute tasks
     // via this->workerp(index)->addTask(...)
-    VlThreadPool(int nThreads, bool profiling);
+    // If 'dequeCapacity' is non-zero, also enable dynamic scheduling via
+    // dynamicRun, with each thread able to hold that many ready tasks, and
+    // up to 'evalThreads' threads in dynamicRun at once.
+    VlThreadPool(int nThreads, bool profiling, vluint32_t dequeCapacity = 0,
+                 int evalThreads = 1);
     ~VlThreadPool();
 
+    // Sharing a pool between models. Models constructed after a pool is
+    // passed to shared() use that pool rather than creating their own, if
+    // it is suitable (see acquire). The caller retains ownership of the
+    // pool, and must not delete it until all models using it are deleted.
+    // Pass NULL to go back to each model creating its own pool.
+    static void shared(VlThreadPool* poolp);
+    static VlThreadPool* shared() { return s_sharedp; }
+    // Called by the model constructor: Return the shared pool if it can
+    // run this model, else construct a new pool for the model alone.
+    static VlThreadPool* acquire(int nThreads, bool profiling, vluint32_t dequeCapacity);
+    // Called by the model destructor: Delete the pool unless shared
+    static void release(VlThreadPool* poolp);
+
     // METHODS
     inline int numThreads() const { return m_workers.size(); }
     inline VlWorkerThread* workerp(int index) {
@@ -278,14 +422,61 @@ public:
         t_profilep->emplace_back();
         return &(t_profilep->back());
     }
+    // Static scheduling: Bracket handing tasks to workers and waiting for
+    // them. Statically scheduled tasks wait on each other, so evals of
+    // models sharing a pool must not interleave on the workers. Returns
+    // false, without needing staticEnd(), if this thread is already
+    // running a static eval on this pool (e.g. a DPI call made from an
+    // mtask); the caller must then do its work serially.
+    inline bool staticBegin() {
+        if (VL_LIKELY(!m_shared)) return true;
+        if (VL_UNLIKELY(t_evalPoolp == this)) return false;
+        // Workers leave dynamic runs once they see this, see dynamicWorker
+        m_staticEvals.fetch_add(1, std::memory_order_release);
+        m_evalMutex.lock();
+        m_evalPrevp = t_evalPoolp;
+        t_evalPoolp = this;
+        return true;
+    }
+    inline void staticEnd() {
+        if (VL_LIKELY(!m_shared)) return;
+        t_evalPoolp = m_evalPrevp;
+        m_evalMutex.unlock();
+        m_staticEvals.fetch_sub(1, std::memory_order_release);
+    }
+    // Dynamic scheduling: Make a ready task available to any thread.
+    // Called by each mtask for the downstream mtasks it made ready.
+    inline void dynamicPush(VlExecFnp fnp, bool evenCycle, VlThrSymTab sym) {
+        if (VL_UNLIKELY(!t_dequep->push(fnp, evenCycle, sym))) {
+            fnp(evenCycle, sym);  // Full; just run it ourselves
+        }
+    }
+    // Dynamic scheduling: Push the 'nRoots' initial tasks, then recruit
+    // the workers and run tasks on the calling thread too, until 'finalp'
+    // is done.
+    void dynamicRun(const VlExecFnp* rootsp, size_t nRoots, VlThrSymTab sym,
+                    const VlMTaskVertex* finalp, bool evenCycle);
+    // Call fnp(userp, i) for each i in [0, n), spread across the workers
+    // and the calling thread. Returns when all calls have completed.
+    typedef void (*ParallelFnp)(void* userp, int index);
+    void parallelFor(ParallelFnp fnp, void* userp, int n);
     void profileAppendAll(const VlProfileRec& rec);
     void profileDump(const char* filenamep, vluint64_t ticksElapsed);
+    // Restrict a thread to run only on the given CPU, returns false if
+    // unsupported or failed.
+    static bool pinThread(std::thread::native_handle_type handle, unsigned cpu);
     // In profiling mode, each executing thread must call
     // this once to setup profiling state:
     void setupProfilingClientThread();
     void tearDownProfilingClientThread();
 private:
     VL_UNCOPYABLE(VlThreadPool);
+    bool dynamicRunOne(size_t* victimp);
+    void setupAffinity(const std::string& affinity);
+    static std::vector<unsigned> parseCpuList(const std::string& cpus);
+    static std::vector<unsigned> numaNodeCpus(unsigned cpu);
+    static void dynamicWorker(bool evenCycle, VlThrSymTab poolp);
+    static void parallelForWorker(bool, VlThrSymTab jobp);
 };
 
 #endif
@@ -27,6 +27,17 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#ifdef VL_TRACE_THREADED
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+#endif
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+# define VL_VCD_SIMD_X86 1  // SSE2 always, AVX2 if the running CPU has it
+# include <immintrin.h>
+#endif
+
 #if defined(_WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
 # include <io.h>
 #else
@@ -109,6 +120,299 @@ protected:
     ~VerilatedVcdCallInfo() {}
 };
 
+#ifdef VL_TRACE_THREADED
+//=============================================================================
+// VerilatedVcdWriter
+/// Thread formatting and writing filled output buffers.  The simulation
+/// thread only buffers compact records of changed values (see
+/// VerilatedVcd::RecTag) among any plain VCD text, and this thread turns
+/// them into VCD text.  Input is double buffered: while one buffer is
+/// formatted and written, the simulation fills the other, and they are
+/// swapped when it is full.
+/// This is an internally used class
+
+class VerilatedVcdWriter {
+    VerilatedVcdFile* m_filep;  ///< File we're writing to
+    std::mutex m_mutex;  ///< Protects below
+    std::condition_variable m_cv;  ///< Signaled when m_pendp is filled or emptied
+    char* m_pendp;  ///< Buffer to write, or NULL if idle
+    size_t m_pendLen;  ///< Bytes of m_pendp to write
+    vluint64_t m_pendSize;  ///< Allocated size of m_pendp
+    std::string m_reopenName;  ///< After writing m_pendp, open this file, if non-empty
+    char* m_donep;  ///< Buffer that was written, for reuse
+    vluint64_t m_doneSize;  ///< Allocated size of m_donep
+    vluint64_t m_fileBytes;  ///< Bytes written to this file, as of the last buffer
+    std::string m_error;  ///< Write error, to be reported by simulation thread
+    bool m_failed;  ///< File closed due to error, discard output
+    bool m_exit;  ///< Thread should exit
+    // Only used by the writer thread
+    char* m_outBufp;  ///< Formatted text
+    char* m_outp;  ///< Write pointer into m_outBufp
+    size_t m_outSize;  ///< Allocated size of m_outBufp
+    vluint64_t m_wroteBytes;  ///< Bytes written to this file
+    std::thread m_thread;  ///< The writer thread
+
+    void write(const char* bufp, size_t len) {
+        const char* wp = bufp;
+        while (!m_failed) {
+            ssize_t remaining = (bufp + len - wp);
+            if (remaining == 0) break;
+            errno = 0;
+            ssize_t got = m_filep->write(wp, remaining);
+            if (got > 0) {
+                wp += got;
+                m_wroteBytes += got;
+            } else if (got < 0) {
+                if (errno != EAGAIN && errno != EINTR) {
+                    // write failed, presume error (perhaps out of disk space)
+                    m_error = std::string("VerilatedVcd::bufferFlush: ") + strerror(errno);
+                    m_failed = true;
+                    m_filep->close();  // May get error, just ignore it
+                }
+            }
+        }
+    }
+    void outFlush() {
+        write(m_outBufp, m_outp - m_outBufp);
+        m_outp = m_outBufp;
+    }
+    /// Make room for 'len' more characters of text
+    inline void outReserve(size_t len) {
+        if (VL_LIKELY(m_outp + len <= m_outBufp + m_outSize)) return;
+        outFlush();
+        if (len > m_outSize) {
+            delete[] m_outBufp;
+            m_outSize = len * 2;
+            m_outBufp = new char[m_outSize];
+            m_outp = m_outBufp;
+        }
+    }
+    inline void outCode(vluint32_t code) {
+        *m_outp++ = static_cast<char>('!' + code % 94);
+        code /= 94;
+        while (code) {
+            code--;
+            *m_outp++ = static_cast<char>('!' + code % 94);
+            code /= 94;
+        }
+    }
+    template <class T> static inline T recGet(const char*& rp) {
+        T value;
+        memcpy(&value, rp, sizeof(T));
+        rp += sizeof(T);
+        return value;
+    }
+    /// Format one record, return the following byte
+    const char* formatRec(const char* rp) {
+        const char tag = *rp++;
+        const vluint32_t code = recGet<vluint32_t>(rp);
+        // Enough for the value, a code (at most 5 characters), and punctuation
+        static const size_t SLOP = 40;
+        switch (tag) {
+        case VerilatedVcd::REC_BIT: {
+            outReserve(SLOP);
+            *m_outp++ = '0' + recGet<vluint8_t>(rp);
+            break;
+        }
+        case VerilatedVcd::REC_TRI_BIT: {
+            outReserve(SLOP);
+            *m_outp++ = "01zz"[recGet<vluint8_t>(rp) & 3];
+            break;
+        }
+        case VerilatedVcd::REC_BUS: {
+            const int bits = recGet<vluint8_t>(rp);
+            const vluint32_t value = recGet<vluint32_t>(rp);
+            outReserve(bits + SLOP);
+            *m_outp++ = 'b';
+            for (int bit = bits - 1; bit >= 0; --bit) *m_outp++ = '0' + ((value >> bit) & 1);
+            *m_outp++ = ' ';
+            break;
+        }
+        case VerilatedVcd::REC_QUAD: {
+            const int bits = recGet<vluint8_t>(rp);
+            const vluint64_t value = recGet<vluint64_t>(rp);
+            outReserve(bits + SLOP);
+            *m_outp++ = 'b';
+            for (int bit = bits - 1; bit >= 0; --bit) *m_outp++ = '0' + ((value >> bit) & 1);
+            *m_outp++ = ' ';
+            break;
+        }
+        case VerilatedVcd::REC_ARRAY: {
+            const int bits = recGet<vluint32_t>(rp);
+            outReserve(bits + SLOP);
+            *m_outp++ = 'b';
+            const char* const wordsp = rp;
+            for (int word = (bits - 1) / 32; word >= 0; --word) {
+                rp = wordsp + word * sizeof(vluint32_t);
+                const vluint32_t value = recGet<vluint32_t>(rp);
+                for (int bit = std::min(bits - word * 32, 32) - 1; bit >= 0; --bit) {
+                    *m_outp++ = '0' + ((value >> bit) & 1);
+                }
+            }
+            rp = wordsp + (((bits - 1) / 32) + 1) * sizeof(vluint32_t);
+            *m_outp++ = ' ';
+            break;
+        }
+        case VerilatedVcd::REC_TRI_BUS: {
+            const int bits = recGet<vluint8_t>(rp);
+            const vluint32_t value = recGet<vluint32_t>(rp);
+            const vluint32_t tri = recGet<vluint32_t>(rp);
+            outReserve(bits + SLOP);
+            *m_outp++ = 'b';
+            for (int bit = bits - 1; bit >= 0; --bit) {
+                *m_outp++ = "01zz"[((value >> bit) & 1) | (((tri >> bit) & 1) << 1)];
+            }
+            *m_outp++ = ' ';
+            break;
+        }
+        case VerilatedVcd::REC_TRI_ARRAY: {
+            const int bits = recGet<vluint32_t>(rp);
+            outReserve(bits + SLOP);
+            *m_outp++ = 'b';
+            const char* const wordsp = rp;
+            for (int word = (bits - 1) / 32; word >= 0; --word) {
+                rp = wordsp + word * 2 * sizeof(vluint32_t);
+                const vluint32_t value = recGet<vluint32_t>(rp);
+                const vluint32_t tri = recGet<vluint32_t>(rp);
+                for (int bit = std::min(bits - word * 32, 32) - 1; bit >= 0; --bit) {
+                    *m_outp++ = "01zz"[((value >> bit) & 1) | (((tri >> bit) & 1) << 1)];
+                }
+            }
+            rp = wordsp + (((bits - 1) / 32) + 1) * 2 * sizeof(vluint32_t);
+            *m_outp++ = ' ';
+            break;
+        }
+        case VerilatedVcd::REC_DOUBLE: {
+            const double value = recGet<double>(rp);
+            outReserve(SLOP);
+            sprintf(m_outp, "r%.16g", value);
+            m_outp += strlen(m_outp);
+            *m_outp++ = ' ';
+            break;
+        }
+        default:
+            VL_FATAL_MT(__FILE__, __LINE__, "", "Internal: Bad VCD trace record");
+        }
+        outCode(code);
+        *m_outp++ = '\n';
+        return rp;
+    }
+    /// Format a buffer of text and records, writing the text as it fills
+    void format(const char* bufp, size_t len) {
+        const char* rp = bufp;
+        const char* const endp = bufp + len;
+        while (rp < endp && !m_failed) {
+            // Copy plain text up to the next record
+            const char* textp = rp;
+            while (rp < endp && static_cast<unsigned char>(*rp) > VerilatedVcd::REC_DOUBLE) ++rp;
+            if (rp != textp) {
+                outReserve(rp - textp);
+                memcpy(m_outp, textp, rp - textp);
+                m_outp += rp - textp;
+            }
+            if (rp < endp) rp = formatRec(rp);
+        }
+        outFlush();
+    }
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            while (!m_pendp && !m_exit) m_cv.wait(lock);
+            if (!m_pendp) return;  // m_exit, and nothing left to write
+            // Format and write without the lock, so the simulation thread
+            // can keep working
+            lock.unlock();
+            format(m_pendp, m_pendLen);
+            if (!m_reopenName.empty() && !m_failed) {
+                m_filep->close();
+                m_wroteBytes = 0;
+                // Not an error message; like VerilatedVcd::openNext the
+                // simulation thread sees the file as closed
+                if (!m_filep->open(m_reopenName)) m_failed = true;
+            }
+            lock.lock();
+            m_donep = m_pendp;
+            m_doneSize = m_pendSize;
+            m_fileBytes = m_wroteBytes;
+            m_pendp = NULL;
+            m_cv.notify_all();
+        }
+    }
+    static void startThread(VerilatedVcdWriter* selfp) { selfp->run(); }
+
+public:
+    // CONSTRUCTORS
+    explicit VerilatedVcdWriter(VerilatedVcdFile* filep)
+        : m_filep(filep)
+        , m_pendp(NULL)
+        , m_pendLen(0)
+        , m_pendSize(0)
+        , m_donep(NULL)
+        , m_doneSize(0)
+        , m_fileBytes(0)
+        , m_failed(false)
+        , m_exit(false)
+        , m_outSize(64 * 1024)
+        , m_wroteBytes(0) {
+        m_outBufp = new char[m_outSize];
+        m_outp = m_outBufp;
+        // Start last, once the members it uses are set
+        m_thread = std::thread(startThread, this);
+    }
+    ~VerilatedVcdWriter() {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_exit = true;
+            m_cv.notify_all();
+        }
+        m_thread.join();
+        if (m_donep) { delete[] m_donep; m_donep = NULL; }
+        delete[] m_outBufp; m_outBufp = NULL;
+    }
+
+    // METHODS
+    /// Wait for any buffer to be written
+    void drain() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_pendp) m_cv.wait(lock);
+    }
+    /// Give the thread a buffer to write, then optionally a file to reopen.
+    /// Return a previously written buffer, or NULL, with its size in
+    /// doneSize, and the bytes written to the file so far in fileBytes.
+    char* swap(char* bufp, vluint64_t bufSize, size_t len, const std::string& reopenName,
+               vluint64_t& doneSize, vluint64_t& fileBytes) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_pendp) m_cv.wait(lock);
+        char* donep = m_donep;
+        doneSize = m_doneSize;
+        fileBytes = m_fileBytes;
+        m_donep = NULL;
+        m_pendp = bufp;
+        m_pendLen = len;
+        m_pendSize = bufSize;
+        m_reopenName = reopenName;
+        m_cv.notify_all();
+        return donep;
+    }
+    /// After a drain() or swap(), did the file close due to an error?
+    /// If so return the error, if any, for reporting.
+    bool failed(std::string& error) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        error = m_error;
+        m_error = "";
+        return m_failed;
+    }
+    /// File was reopened by the simulation thread; resume writing
+    void reset() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_pendp) m_cv.wait(lock);  // Discard any output for the failed file
+        m_failed = false;
+        m_wroteBytes = 0;
+        m_fileBytes = 0;
+    }
+};
+#endif  // VL_TRACE_THREADED
+
 //=============================================================================
 //=============================================================================
 //=============================================================================
@@ -152,6 +456,8 @@ VerilatedVcd::VerilatedVcd(VerilatedVcdFile* filep)
     m_wrFlushp = m_wrBufp + m_wrChunkSize * 6;
     m_writep = m_wrBufp;
     m_wroteBytes = 0;
+    m_writerp = NULL;
+    m_isShard = false;
 }
 
 void VerilatedVcd::open(const char* filename) {
@@ -166,6 +472,10 @@ void VerilatedVcd::open(const char* filename) {
     // Set callback so an early exit will flush us
     Verilated::flushCb(&flush_all);
 
+#ifdef VL_TRACE_THREADED
+    if (!m_writerp) m_writerp = new VerilatedVcdWriter(m_filep);
+#endif
+
     // SPDIFF_ON
     openNext(m_rolloverMB!=0);
     if (!isOpen()) return;
@@ -187,7 +497,6 @@ void VerilatedVcd::openNext(bool incFilename) {
     // Open next filename in concat sequence, mangle filename if
     // incFilename is true.
     m_assertOne.check();
-    closePrev();  // Close existing
     if (incFilename) {
         // Find _0000.{ext} in filename
         std::string name = m_filename;
@@ -213,6 +522,23 @@ void VerilatedVcd::openNext(bool incFilename) {
         }
         m_filename = name;
     }
+#ifdef VL_TRACE_THREADED
+    if (m_writerp && isOpen() && m_filename[0] != '|') {
+        // Rollover; the writer thread finishes the old file then opens this
+        // one.  Wait for that, so failing to open is seen here, as below.
+        bufferHandoff(m_filename);
+        if (!isOpen()) return;
+        writerDrain();
+        if (!isOpen()) return;
+        m_fullDump = true;  // First dump must be full
+        m_wroteBytes = 0;
+        return;
+    }
+#endif
+    closePrev();  // Close existing
+#ifdef VL_TRACE_THREADED
+    if (m_writerp) m_writerp->reset();
+#endif
     if (m_filename[0]=='|') {
         assert(0);  // Not supported yet.
     } else {
@@ -270,6 +596,14 @@ void VerilatedVcd::deleteNameMap() {
 
 VerilatedVcd::~VerilatedVcd() {
     close();
+#ifdef VL_TRACE_THREADED
+    if (m_writerp) { delete m_writerp; m_writerp = NULL; }
+#endif
+    for (ShardVec::const_iterator it = m_shards.begin(); it != m_shards.end(); ++it) {
+        (*it)->m_sigs_oldvalp = NULL;  // Owned by us
+        delete (*it);
+    }
+    m_shards.clear();
     if (m_wrBufp) { delete[] m_wrBufp; m_wrBufp=NULL; }
     if (m_sigs_oldvalp) { delete[] m_sigs_oldvalp; m_sigs_oldvalp=NULL; }
     deleteNameMap();
@@ -285,7 +619,8 @@ void VerilatedVcd::closePrev() {
     // This function is on the flush() call path
     if (!isOpen()) return;
 
-    bufferFlush();
+    flush();
+    if (!isOpen()) return;  // Writer thread failed, and closed the file
     m_isOpen = false;
     m_filep->close();
 }
@@ -361,8 +696,23 @@ void VerilatedVcd::bufferFlush() VL_MT_UNSAFE_ONE {
     // We add output data to m_writep.
     // When it gets nearly full we dump it using this routine which calls write()
     // This is much faster than using buffered I/O
+    if (VL_UNLIKELY(m_isShard)) {
+        // Nowhere to write; keep everything until merged, so grow instead
+        vluint64_t used = m_writep - m_wrBufp;
+        vluint64_t size = (m_wrFlushp - m_wrBufp) * 2 + m_wrChunkSize * 2;
+        char* newbufp = new char [size];
+        memcpy(newbufp, m_wrBufp, used);
+        delete [] m_wrBufp;
+        m_wrBufp = newbufp;
+        m_writep = m_wrBufp + used;
+        m_wrFlushp = m_wrBufp + size - m_wrChunkSize * 2;
+        return;
+    }
     m_assertOne.check();
     if (VL_UNLIKELY(!isOpen())) return;
+#ifdef VL_TRACE_THREADED
+    if (m_writerp) { bufferHandoff(""); return; }
+#endif
     char* wp = m_wrBufp;
     while (1) {
         ssize_t remaining = (m_writep - wp);
@@ -387,6 +737,139 @@ void VerilatedVcd::bufferFlush() VL_MT_UNSAFE_ONE {
     m_writep = m_wrBufp;
 }
 
+void VerilatedVcd::bufferHandoff(const std::string& reopenName) VL_MT_UNSAFE_ONE {
+#ifdef VL_TRACE_THREADED
+    // Give the filled buffer to the writer thread, and continue with the
+    // buffer it finished writing
+    vluint64_t bufSize = m_wrChunkSize * 8;
+    vluint64_t doneSize = 0;
+    size_t len = m_writep - m_wrBufp;
+    // The writer's count lags by this buffer, which is close enough for rollover
+    char* donep = m_writerp->swap(m_wrBufp, bufSize, len, reopenName, doneSize, m_wroteBytes);
+    if (donep && doneSize != bufSize) { delete[] donep; donep = NULL; }  // Was resized
+    if (!donep) donep = new char [bufSize];
+    m_wrBufp = donep;
+    m_writep = m_wrBufp;
+    m_wrFlushp = m_wrBufp + m_wrChunkSize * 6;
+    std::string error;
+    if (VL_UNLIKELY(m_writerp->failed(error))) {
+        if (!error.empty()) VL_FATAL_MT("", 0, "", error.c_str());
+        m_isOpen = false;  // Writer thread closed the file
+    }
+#endif
+}
+
+void VerilatedVcd::writerDrain() VL_MT_UNSAFE_ONE {
+#ifdef VL_TRACE_THREADED
+    // Wait for the writer thread to finish what it was given
+    if (m_writerp && isOpen()) {
+        m_writerp->drain();
+        std::string error;
+        if (VL_UNLIKELY(m_writerp->failed(error))) {
+            if (!error.empty()) VL_FATAL_MT("", 0, "", error.c_str());
+            m_isOpen = false;  // Writer thread closed the file
+        }
+    }
+#endif
+}
+
+void VerilatedVcd::flush() VL_MT_UNSAFE_ONE {
+    bufferFlush();
+    writerDrain();
+}
+
+void VerilatedVcd::shardsReserve(int count) VL_MT_UNSAFE_ONE {
+    m_assertOne.check();
+    while (static_cast<int>(m_shards.size()) < count) {
+        VerilatedVcd* shardp = new VerilatedVcd;
+        shardp->m_isShard = true;
+        shardp->m_evcd = m_evcd;
+        shardp->m_sigs_oldvalp = m_sigs_oldvalp;
+        shardp->bufferResize(m_wrChunkSize);
+        m_shards.push_back(shardp);
+    }
+}
+
+void VerilatedVcd::shardsMerge(int count) VL_MT_UNSAFE_ONE {
+    m_assertOne.check();
+    for (int i = 0; i < count; ++i) {
+        VerilatedVcd* shardp = m_shards[i];
+        const char* rp = shardp->m_wrBufp;
+        while (rp < shardp->m_writep) {
+            // No more than a chunk between checks, so we stay inside our slop
+            size_t len = std::min(static_cast<vluint64_t>(shardp->m_writep - rp),
+                                  m_wrChunkSize);
+            memcpy(m_writep, rp, len);
+            m_writep += len;
+            rp += len;
+            bufferCheck();
+        }
+        shardp->m_writep = shardp->m_wrBufp;
+    }
+}
+
+//=============================================================================
+// Change detection
+// Wide signals, e.g. memory words, rarely change, so compare a block of
+// words at a time and only look at single words for the remaining tail.
+
+#ifndef VL_VCD_SIMD_X86
+static bool vcdArrayDiffersScalar(const vluint32_t* oldp, const vluint32_t* newp, int words) {
+    int word = 0;
+    for (; word + 4 <= words; word += 4) {
+        if ((oldp[word] ^ newp[word]) | (oldp[word + 1] ^ newp[word + 1])
+            | (oldp[word + 2] ^ newp[word + 2]) | (oldp[word + 3] ^ newp[word + 3])) return true;
+    }
+    for (; word < words; ++word) {
+        if (oldp[word] ^ newp[word]) return true;
+    }
+    return false;
+}
+#else
+static bool vcdArrayDiffersSse2(const vluint32_t* oldp, const vluint32_t* newp, int words) {
+    int word = 0;
+    for (; word + 4 <= words; word += 4) {
+        __m128i oldv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(oldp + word));
+        __m128i newv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(newp + word));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(oldv, newv)) != 0xffff) return true;
+    }
+    for (; word < words; ++word) {
+        if (oldp[word] ^ newp[word]) return true;
+    }
+    return false;
+}
+
+__attribute__((target("avx2")))
+static bool vcdArrayDiffersAvx2(const vluint32_t* oldp, const vluint32_t* newp, int words) {
+    int word = 0;
+    for (; word + 8 <= words; word += 8) {
+        __m256i oldv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(oldp + word));
+        __m256i newv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(newp + word));
+        __m256i diff = _mm256_xor_si256(oldv, newv);
+        if (!_mm256_testz_si256(diff, diff)) return true;
+    }
+    return vcdArrayDiffersSse2(oldp + word, newp + word, words - word);
+}
+#endif
+
+typedef bool (*VerilatedVcdDiffers_t)(const vluint32_t* oldp, const vluint32_t* newp, int words);
+
+static VerilatedVcdDiffers_t vcdArrayDiffersSelect() {
+#ifdef VL_VCD_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return &vcdArrayDiffersAvx2;
+    return &vcdArrayDiffersSse2;
+#else
+    return &vcdArrayDiffersScalar;
+#endif
+}
+
+bool VerilatedVcd::arrayDiffers(const vluint32_t* oldp, const vluint32_t* newp,
+                                int words) VL_MT_SAFE {
+    static const VerilatedVcdDiffers_t s_differsp = vcdArrayDiffersSelect();
+    return s_differsp(oldp, newp, words);
+}
+
 //=============================================================================
 // Simple methods
 
@@ -643,19 +1126,29 @@ void VerilatedVcd::declDouble(vluint32_t code, const char* name, bool array, int
 void VerilatedVcd::fullDouble(vluint32_t code, const double newval) {
     // cppcheck-suppress invalidPointerCast
     (*(reinterpret_cast<double*>(&m_sigs_oldvalp[code]))) = newval;
+#ifdef VL_TRACE_THREADED
+    recBegin(REC_DOUBLE, code);
+    recPut(newval);
+#else
     // Buffer can't overflow before sprintf; we sized during declaration
     sprintf(m_writep, "r%.16g", newval);
     m_writep += strlen(m_writep);
     *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
     bufferCheck();
 }
 void VerilatedVcd::fullFloat(vluint32_t code, const float newval) {
     // cppcheck-suppress invalidPointerCast
     (*(reinterpret_cast<float*>(&m_sigs_oldvalp[code]))) = newval;
+#ifdef VL_TRACE_THREADED
+    recBegin(REC_DOUBLE, code);
+    recPut(static_cast<double>(newval));
+#else
     // Buffer can't overflow before sprintf; we sized during declaration
     sprintf(m_writep, "r%.16g", static_cast<double>(newval));
     m_writep += strlen(m_writep);
     *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
     bufferCheck();
 }
 
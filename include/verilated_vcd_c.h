@@ -29,6 +29,7 @@
 
 class VerilatedVcd;
 class VerilatedVcdCallInfo;
+class VerilatedVcdWriter;
 
 // SPDIFF_ON
 //=============================================================================
@@ -75,6 +76,7 @@ typedef void (*VerilatedVcdCallback_t)(VerilatedVcd* vcdp, void* userthis, vluin
 
 class VerilatedVcd {
 private:
+    friend class VerilatedVcdWriter;
     VerilatedVcdFile*   m_filep;        ///< File we're writing to
     bool                m_fileNewed;    ///< m_filep needs destruction
     bool                m_isOpen;       ///< True indicates open file
@@ -95,6 +97,7 @@ private:
     char*               m_writep;       ///< Write pointer into output buffer
     vluint64_t          m_wrChunkSize;  ///< Output buffer size
     vluint64_t          m_wroteBytes;   ///< Number of bytes written to this file
+    VerilatedVcdWriter* m_writerp;      ///< Thread formatting and writing, with VL_TRACE_THREADED
 
     vluint32_t*         m_sigs_oldvalp; ///< Pointer to old signal values
     typedef std::vector<VerilatedVcdSig>  SigVec;
@@ -103,11 +106,16 @@ private:
     CallbackVec m_callbacks;  ///< Routines to perform dumping
     typedef std::map<std::string,std::string>  NameMap;
     NameMap* m_namemapp;  ///< List of names for the header
+    typedef std::vector<VerilatedVcd*>  ShardVec;
+    ShardVec m_shards;  ///< Buffers for collecting changes in parallel
+    bool m_isShard;  ///< Is one of another file's m_shards
 
     VerilatedAssertOneThread m_assertOne;  ///< Assert only called from single thread
 
     void bufferResize(vluint64_t minsize);
     void bufferFlush() VL_MT_UNSAFE_ONE;
+    void bufferHandoff(const std::string& reopenName) VL_MT_UNSAFE_ONE;
+    void writerDrain() VL_MT_UNSAFE_ONE;
     inline void bufferCheck() {
         // Flush the write buffer if there's not enough space left for new information
         // We only call this once per vector, so we need enough slop for a very wide "b###" line
@@ -125,6 +133,13 @@ private:
     void declare(vluint32_t code, const char* name, const char* wirep, bool array, int arraynum,
                  bool tri, bool bussed, int msb, int lsb);
 
+    // Arrays at least this many words wide are compared by arrayDiffers,
+    // narrower ones are cheaper to compare inline
+    enum { WIDE_ARRAY_WORDS = 8 };
+    /// Return true if any of the words differ; uses SIMD where the CPU supports it
+    static bool arrayDiffers(const vluint32_t* oldp, const vluint32_t* newp,
+                             int words) VL_MT_SAFE;
+
     void dumpHeader();
     void dumpPrep(vluint64_t timeui);
     void dumpFull(vluint64_t timeui);
@@ -139,6 +154,27 @@ private:
             code /= 94;
         }
     }
+    // With VL_TRACE_THREADED, value changes are buffered as a tag byte,
+    // the code, then the value, for the writer thread to format.  VCD text
+    // never contains these bytes, so records and text may be mixed.
+    enum RecTag {
+        REC_BIT = 1,  // vluint8_t value
+        REC_BUS,  // vluint8_t bits, vluint32_t value
+        REC_QUAD,  // vluint8_t bits, vluint64_t value
+        REC_ARRAY,  // vluint32_t bits, vluint32_t value words
+        REC_TRI_BIT,  // vluint8_t value | tri << 1
+        REC_TRI_BUS,  // vluint8_t bits, vluint32_t value, vluint32_t tri
+        REC_TRI_ARRAY,  // vluint32_t bits, vluint32_t value and tri word pairs
+        REC_DOUBLE  // double value
+    };
+    inline void recBegin(RecTag tag, vluint32_t code) {
+        *m_writep++ = static_cast<char>(tag);
+        recPut(code);
+    }
+    template <class T> inline void recPut(T value) {
+        memcpy(m_writep, &value, sizeof(T));
+        m_writep += sizeof(T);
+    }
     static std::string stringCode(vluint32_t code) VL_PURE {
         std::string out;
         out += static_cast<char>('!' + code % 94);
@@ -174,7 +210,7 @@ public:
     void openNext(bool incFilename);  ///< Open next data-only file
     void close() VL_MT_UNSAFE_ONE;  ///< Close the file
     /// Flush any remaining data to this file
-    void flush() VL_MT_UNSAFE_ONE { bufferFlush(); }
+    void flush() VL_MT_UNSAFE_ONE;
     /// Flush any remaining data from all files
     static void flush_all() VL_MT_UNSAFE_ONE;
 
@@ -192,6 +228,16 @@ public:
     /// Call dump with a absolute unscaled time in seconds
     void dumpSeconds(double secs) { dump(static_cast<vluint64_t>(secs * m_timeRes)); }
 
+    /// Inside dumping routines, make at least 'count' shards available.
+    /// A shard shares this file's signal state, but buffers its output, so
+    /// shards may each dump a disjoint set of codes on different threads.
+    void shardsReserve(int count) VL_MT_UNSAFE_ONE;
+    /// Inside dumping routines, return a shard made by shardsReserve()
+    VerilatedVcd* shardp(int index) const { return m_shards[index]; }
+    /// Inside dumping routines, output then empty the first 'count' shards,
+    /// in index order
+    void shardsMerge(int count) VL_MT_UNSAFE_ONE;
+
     /// Inside dumping routines, declare callbacks for tracings
     void addCallback(VerilatedVcdCallback_t initcb, VerilatedVcdCallback_t fullcb,
                      VerilatedVcdCallback_t changecb,
@@ -213,81 +259,135 @@ public:
     //  ... other module_start for submodules (based on cell name)
 
     /// Inside dumping routines, dump one signal
+    /// With VL_TRACE_THREADED these buffer a compact record (see RecTag)
+    /// that the writer thread formats, rather than the VCD text itself
     void fullBit(vluint32_t code, const vluint32_t newval) {
         // Note the &1, so we don't require clean input -- makes more common no change case faster
         m_sigs_oldvalp[code] = newval;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_BIT, code);
+        recPut(static_cast<vluint8_t>(newval & 1));
+#else
         *m_writep++=('0'+static_cast<char>(newval&1)); printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullBus(vluint32_t code, const vluint32_t newval, int bits) {
         m_sigs_oldvalp[code] = newval;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_BUS, code);
+        recPut(static_cast<vluint8_t>(bits));
+        recPut(newval);
+#else
         *m_writep++='b';
         for (int bit=bits-1; bit>=0; --bit) {
             *m_writep++=((newval&(1L<<bit))?'1':'0');
         }
         *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullQuad(vluint32_t code, const vluint64_t newval, int bits) {
         (*(reinterpret_cast<vluint64_t*>(&m_sigs_oldvalp[code]))) = newval;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_QUAD, code);
+        recPut(static_cast<vluint8_t>(bits));
+        recPut(newval);
+#else
         *m_writep++='b';
         for (int bit=bits-1; bit>=0; --bit) {
             *m_writep++ = ((newval & (VL_ULL(1) << bit)) ? '1' : '0');
         }
         *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullArray(vluint32_t code, const vluint32_t* newval, int bits) {
         for (int word = 0; word < (((bits - 1) / 32) + 1); ++word) {
             m_sigs_oldvalp[code + word] = newval[word];
         }
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_ARRAY, code);
+        recPut(static_cast<vluint32_t>(bits));
+        for (int word = 0; word < (((bits - 1) / 32) + 1); ++word) recPut(newval[word]);
+#else
         *m_writep++ = 'b';
         for (int bit = bits - 1; bit >= 0; --bit) {
             *m_writep++ = ((newval[(bit / 32)] & (1L << (bit & 0x1f))) ? '1' : '0');
         }
         *m_writep ++= ' '; printCode(code); *m_writep ++= '\n';
+#endif
         bufferCheck();
     }
     void fullArray(vluint32_t code, const vluint64_t* newval, int bits) {
         for (int word = 0; word < (((bits - 1) / 64) + 1); ++word) {
             m_sigs_oldvalp[code + word] = newval[word];
         }
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_ARRAY, code);
+        recPut(static_cast<vluint32_t>(bits));
+        for (int word = 0; word < (((bits - 1) / 32) + 1); ++word) {
+            recPut(static_cast<vluint32_t>(newval[word / 2] >> ((word & 1) * 32)));
+        }
+#else
         *m_writep ++= 'b';
         for (int bit = bits - 1; bit >= 0; --bit) {
             *m_writep++ = ((newval[(bit / 64)] & (VL_ULL(1) << (bit & 0x3f))) ? '1' : '0');
         }
         *m_writep ++= ' '; printCode(code); *m_writep ++= '\n';
+#endif
         bufferCheck();
     }
     void fullTriBit(vluint32_t code, const vluint32_t newval, const vluint32_t newtri) {
         m_sigs_oldvalp[code]   = newval;
         m_sigs_oldvalp[code+1] = newtri;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_TRI_BIT, code);
+        recPut(static_cast<vluint8_t>(newval | (newtri << 1)));
+#else
         *m_writep++ = "01zz"[m_sigs_oldvalp[code]
                              | (m_sigs_oldvalp[code+1]<<1)];
         printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullTriBus(vluint32_t code, const vluint32_t newval, const vluint32_t newtri, int bits) {
         m_sigs_oldvalp[code] = newval;
         m_sigs_oldvalp[code+1] = newtri;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_TRI_BUS, code);
+        recPut(static_cast<vluint8_t>(bits));
+        recPut(newval);
+        recPut(newtri);
+#else
         *m_writep++='b';
         for (int bit=bits-1; bit>=0; --bit) {
             *m_writep++ = "01zz"[((newval >> bit)&1)
                                  | (((newtri >> bit)&1)<<1)];
         }
         *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullTriQuad(vluint32_t code, const vluint64_t newval,
                      const vluint32_t newtri, int bits) {
         (*(reinterpret_cast<vluint64_t*>(&m_sigs_oldvalp[code]))) = newval;
         (*(reinterpret_cast<vluint64_t*>(&m_sigs_oldvalp[code+1]))) = newtri;
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_TRI_ARRAY, code);
+        recPut(static_cast<vluint32_t>(bits));
+        recPut(static_cast<vluint32_t>(newval));
+        recPut(newtri);
+        recPut(static_cast<vluint32_t>(newval >> 32));
+        recPut(static_cast<vluint32_t>(0));
+#else
         *m_writep++='b';
         for (int bit=bits-1; bit>=0; --bit) {
             *m_writep++ = "01zz"[((newval >> bit) & VL_ULL(1))
                                  | (((newtri >> bit) & VL_ULL(1)) << VL_ULL(1))];
         }
         *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullTriArray(vluint32_t code, const vluint32_t* newvalp,
@@ -296,6 +396,14 @@ public:
             m_sigs_oldvalp[code+word*2]   = newvalp[word];
             m_sigs_oldvalp[code+word*2+1] = newtrip[word];
         }
+#ifdef VL_TRACE_THREADED
+        recBegin(REC_TRI_ARRAY, code);
+        recPut(static_cast<vluint32_t>(bits));
+        for (int word=0; word<(((bits-1)/32)+1); ++word) {
+            recPut(newvalp[word]);
+            recPut(newtrip[word]);
+        }
+#else
         *m_writep++='b';
         for (int bit=bits-1; bit>=0; --bit) {
             vluint32_t valbit = (newvalp[(bit/32)]>>(bit&0x1f)) & 1;
@@ -303,6 +411,7 @@ public:
             *m_writep++ = "01zz"[valbit | (tribit<<1)];
         }
         *m_writep++=' '; printCode(code); *m_writep++='\n';
+#endif
         bufferCheck();
     }
     void fullDouble(vluint32_t code, const double newval);
@@ -355,7 +464,14 @@ public:
         }
     }
     inline void chgArray(vluint32_t code, const vluint32_t* newval, int bits) {
-        for (int word = 0; word < (((bits - 1) / 32) + 1); ++word) {
+        const int words = ((bits - 1) / 32) + 1;
+        if (words >= WIDE_ARRAY_WORDS) {
+            if (VL_UNLIKELY(arrayDiffers(m_sigs_oldvalp + code, newval, words))) {
+                fullArray(code, newval, bits);
+            }
+            return;
+        }
+        for (int word = 0; word < words; ++word) {
             if (VL_UNLIKELY(m_sigs_oldvalp[code + word] ^ newval[word])) {
                 fullArray(code, newval, bits);
                 return;
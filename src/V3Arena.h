@@ -0,0 +1,90 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Slab allocator for small, numerous objects
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#ifndef _V3ARENA_H_
+#define _V3ARENA_H_ 1
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include <new>
+#include <vector>
+
+//============================================================================
+
+class V3Arena {
+    // Allocator for AstNodes and FileLines.  Objects are carved out of
+    // large chunks, so objects made together sit together in memory, and
+    // there is no per-object malloc overhead.  Each size class (rounded
+    // to ALIGN bytes) has a free list, so memory of deleted objects is
+    // reused by the next object of the same size.  Chunks are never
+    // returned; the whole arena is released when the process exits.
+    // Not thread safe.
+    enum { ALIGN = 8,  // Alignment and size class granularity
+           MAX_SIZE = 1024,  // Larger objects use the global operator new
+           CHUNK_SIZE = 1024 * 1024 };  // Bytes per chunk
+    struct FreeEnt { FreeEnt* m_nextp; };
+    // MEMBERS
+    FreeEnt* m_freeps[MAX_SIZE / ALIGN + 1];  // Free list for each size class
+    char* m_curp;  // Next unused byte in current chunk
+    char* m_endp;  // End of current chunk
+    std::vector<char*> m_chunks;  // All chunks allocated
+    // METHODS
+    static size_t sizeClass(size_t size) { return (size + ALIGN - 1) / ALIGN; }
+    void newChunk() {
+        m_curp = static_cast<char*>(::operator new(CHUNK_SIZE));
+        m_endp = m_curp + CHUNK_SIZE;
+        m_chunks.push_back(m_curp);
+    }
+    VL_UNCOPYABLE(V3Arena);
+public:
+    // CONSTRUCTORS
+    V3Arena()
+        : m_curp(NULL), m_endp(NULL) {
+        for (size_t i = 0; i <= MAX_SIZE / ALIGN; ++i) m_freeps[i] = NULL;
+    }
+    ~V3Arena() {
+        // Only for arenas whose objects are all gone; see class comment
+        for (std::vector<char*>::iterator it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+            ::operator delete(*it);
+        }
+    }
+    // METHODS
+    void* allocate(size_t size) {
+        if (VL_UNLIKELY(size > MAX_SIZE)) return ::operator new(size);
+        const size_t cls = sizeClass(size);
+        if (FreeEnt* entp = m_freeps[cls]) {
+            m_freeps[cls] = entp->m_nextp;
+            return entp;
+        }
+        if (VL_UNLIKELY(m_curp + cls * ALIGN > m_endp)) newChunk();
+        void* objp = m_curp;
+        m_curp += cls * ALIGN;
+        return objp;
+    }
+    void deallocate(void* objp, size_t size) {
+        if (!objp) return;
+        if (VL_UNLIKELY(size > MAX_SIZE)) { ::operator delete(objp); return; }
+        const size_t cls = sizeClass(size);
+        FreeEnt* entp = static_cast<FreeEnt*>(objp);
+        entp->m_nextp = m_freeps[cls];
+        m_freeps[cls] = entp;
+    }
+    // ACCESSORS
+    size_t chunkBytes() const { return m_chunks.size() * CHUNK_SIZE; }
+};
+
+#endif  // Guard
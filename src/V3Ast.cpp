@@ -17,6 +17,7 @@
 #include "config_build.h"
 #include "verilatedos.h"
 
+#include "V3Arena.h"
 #include "V3Ast.h"
 #include "V3File.h"
 #include "V3Global.h"
@@ -664,6 +665,7 @@ AstNode* AstNode::cloneTreeIterList() {
 }
 
 AstNode* AstNode::cloneTree(bool cloneNextLink) {
+    V3AstLockGuard lock;  // Clone pointers are marked with a global count
     this->debugTreeChange("-cloneThs: ", __LINE__, cloneNextLink);
     cloneClearTree();
     AstNode* newp;
@@ -739,6 +741,7 @@ void AstNode::deleteTree() {
 
 #ifdef VL_LEAK_CHECKS
 void* AstNode::operator new(size_t size) {
+    V3AstLockGuard lock;
     // Optimization note: Aligning to cache line is a loss, due to lost packing
     AstNode* objp = static_cast<AstNode*>(::operator new(size));
     V3Broken::addNewed(objp);
@@ -747,10 +750,27 @@ void* AstNode::operator new(size_t size) {
 
 void AstNode::operator delete(void* objp, size_t size) {
     if (!objp) return;
+    V3AstLockGuard lock;
     AstNode* nodep = static_cast<AstNode*>(objp);
     V3Broken::deleted(nodep);
     ::operator delete(objp);
 }
+#else
+static V3Arena& astArena() {
+    // Never destructed, as nodes may still be deleted during exit
+    static V3Arena* s_arenap = new V3Arena;
+    return *s_arenap;
+}
+
+void* AstNode::operator new(size_t size) {
+    V3AstLockGuard lock;
+    return astArena().allocate(size);
+}
+
+void AstNode::operator delete(void* objp, size_t size) {
+    V3AstLockGuard lock;
+    astArena().deallocate(objp, size);
+}
 #endif
 
 //======================================================================
@@ -1193,27 +1213,33 @@ void AstNode::dtypeChgWidthSigned(int width, int widthMin, AstNumeric numeric) {
 AstNodeDType* AstNode::findBasicDType(AstBasicDTypeKwd kwd) const {
     // For 'simple' types we use the global directory.  These are all unsized.
     // More advanced types land under the module/task/etc
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findBasicDType(fileline(), kwd);
 }
 AstNodeDType* AstNode::findBitDType(int width, int widthMin, AstNumeric numeric) const {
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findLogicBitDType(fileline(), AstBasicDTypeKwd::BIT, width, widthMin, numeric);
 }
 AstNodeDType* AstNode::findLogicDType(int width, int widthMin, AstNumeric numeric) const {
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findLogicBitDType(fileline(), AstBasicDTypeKwd::LOGIC, width, widthMin, numeric);
 }
 AstNodeDType* AstNode::findLogicRangeDType(VNumRange range, int widthMin,
                                            AstNumeric numeric) const {
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findLogicBitDType(fileline(), AstBasicDTypeKwd::LOGIC, range, widthMin, numeric);
 }
 AstBasicDType* AstNode::findInsertSameDType(AstBasicDType* nodep) {
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findInsertSameDType(nodep);
 }
 AstNodeDType* AstNode::findVoidDType() const {
+    V3AstLockGuard lock;
     return v3Global.rootp()->typeTablep()
         ->findVoidDType(fileline());
 }
@@ -24,6 +24,7 @@
 #include "V3FileLine.h"
 #include "V3Number.h"
 #include "V3Global.h"
+#include "V3Parallel.h"
 
 #include <cmath>
 #include VL_INCLUDE_UNORDERED_SET
@@ -145,6 +146,7 @@ public:
     enum en {
         ILLEGAL,
         COVERAGE_BLOCK_OFF,
+        HIER_BLOCK,
         INLINE_MODULE,
         NO_INLINE_MODULE,
         NO_INLINE_TASK,
@@ -178,7 +180,8 @@ public:
         TRACE_FULL,
         TRACE_FULL_SUB,
         TRACE_CHANGE,
-        TRACE_CHANGE_SUB
+        TRACE_CHANGE_SUB,
+        TRACE_CHANGE_GROUP  // Under TRACE_CHANGE, may run in parallel with other groups
     };
     enum en m_e;
     inline AstCFuncType() : m_e(FT_NORMAL) {}
@@ -189,7 +192,8 @@ public:
     // METHODS
     bool isTrace() const { return (m_e==TRACE_INIT || m_e==TRACE_INIT_SUB
                                    || m_e==TRACE_FULL || m_e==TRACE_FULL_SUB
-                                   || m_e==TRACE_CHANGE || m_e==TRACE_CHANGE_SUB); }
+                                   || m_e==TRACE_CHANGE || m_e==TRACE_CHANGE_SUB
+                                   || m_e==TRACE_CHANGE_GROUP); }
 };
 inline bool operator==(const AstCFuncType& lhs, const AstCFuncType& rhs) {
     return lhs.m_e == rhs.m_e;
@@ -1221,6 +1225,7 @@ public:
     class Illegal {};  // for creator type-overload selection
     class FullValue {};  // for creator type-overload selection
     explicit V3Hash(Illegal) { m_both = 0; }
+    V3Hash(FullValue, uint32_t both) { m_both = both; }
     // Saving and restoring inside a userp
     explicit V3Hash(VNUser u) { m_both = u.toInt(); }
     V3Hash operator+= (const V3Hash& rh) {
@@ -1380,10 +1385,8 @@ public:
 
     // CONSTRUCTORS
     virtual ~AstNode() {}
-#ifdef VL_LEAK_CHECKS
     static void* operator new(size_t size);
     static void operator delete(void* obj, size_t size);
-#endif
 
     // CONSTANT ACCESSORS
     static int instrCountBranch() { return 4; }        ///< Instruction cycles to branch
@@ -1514,7 +1517,10 @@ public:
     static void user5ClearTree() { AstUser5InUse::clear(); }  // Clear userp()'s across the entire tree
 
     vluint64_t editCount() const { return m_editCount; }
-    void editCountInc() { m_editCount = ++s_editCntGbl; }  // Preincrement, so can "watch AstNode::s_editCntGbl=##"
+    void editCountInc() {
+        V3AstLockGuard lock;
+        m_editCount = ++s_editCntGbl;  // Preincrement, so can "watch AstNode::s_editCntGbl=##"
+    }
     static vluint64_t editCountLast() { return s_editCntLast; }
     static vluint64_t editCountGbl() { return s_editCntGbl; }
     static void editCountSetLast() { s_editCntLast = editCountGbl(); }
@@ -2413,6 +2419,7 @@ private:
     bool        m_internal:1;   // Internally created
     bool        m_recursive:1;  // Recursive module
     bool        m_recursiveClone:1;  // If recursive, what module it clones, otherwise NULL
+    bool        m_hierBlock:1;  // Hierarchical block, Verilated separately under --hierarchical
     int         m_level;        // 1=top module, 2=cell off top module, ...
     int         m_varNum;       // Incrementing variable number
     int         m_typeNum;      // Incrementing implicit type number
@@ -2422,7 +2429,7 @@ public:
         , m_name(name), m_origName(name)
         , m_modPublic(false), m_modTrace(false), m_inLibrary(false), m_dead(false)
         , m_internal(false), m_recursive(false), m_recursiveClone(false)
-        , m_level(0), m_varNum(0), m_typeNum(0) { }
+        , m_hierBlock(false), m_level(0), m_varNum(0), m_typeNum(0) { }
     ASTNODE_BASE_FUNCS(NodeModule)
     virtual void dump(std::ostream& str) const;
     virtual bool maybePointedTo() const { return true; }
@@ -2457,6 +2464,8 @@ public:
     bool recursive() const { return m_recursive; }
     void recursiveClone(bool flag) { m_recursiveClone = flag; }
     bool recursiveClone() const { return m_recursiveClone; }
+    void hierBlock(bool flag) { m_hierBlock = flag; }
+    bool hierBlock() const { return m_hierBlock; }
 };
 
 class AstNodeRange : public AstNode {
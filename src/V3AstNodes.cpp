@@ -1153,6 +1153,7 @@ void AstNodeModule::dump(std::ostream& str) const {
     this->AstNode::dump(str);
     str<<"  L"<<level();
     if (modPublic()) str<<" [P]";
+    if (hierBlock()) str<<" [HIERB]";
     if (inLibrary()) str<<" [LIB]";
     if (dead()) str<<" [DEAD]";
     if (recursiveClone()) str<<" [RECURSIVE-CLONE]";
@@ -20,6 +20,8 @@
 //          For each variable that comes from combo block and is generated AFTER a usage
 //              Add __Vlast_{var} to local section, init to current value (just use array?)
 //              Change = if any var != last.
+//          Skip variables where every read in _eval's statement order
+//              comes after every write, so one pass settles them.
 //          If a signal is used as a clock in this module or any
 //          module *below*, and it isn't a input to this module,
 //          we need to indicate a new clock has been created.
@@ -33,9 +35,11 @@
 #include "V3Ast.h"
 #include "V3Changed.h"
 #include "V3EmitCBase.h"
+#include "V3Stats.h"
 
 #include <algorithm>
 #include <cstdarg>
+#include <map>
 #include <set>
 
 //######################################################################
@@ -221,6 +225,166 @@ public:
     VL_UNCOPYABLE(ChangedInsertVisitor);
 };
 
+//######################################################################
+// Find which circular variables _eval always writes before reading
+
+class ChangedOrderVisitor : public AstNVisitor {
+private:
+    // TYPES
+    // Reads and writes of circular variables by one function, including
+    // functions it calls.  Positions are relative to the function's start.
+    struct FuncSummary {
+        typedef std::map<AstVarScope*,std::pair<int,int> > VarPosMap;
+        VarPosMap       m_varPos;       // Position of first read and last write, 0 = none
+        int             m_length;       // Positions the function uses
+        const char*     m_unknownp;     // Why unknown code may access any variable, else NULL
+        bool            m_done;         // Summary complete
+        FuncSummary() : m_length(0), m_unknownp(NULL), m_done(false) {}
+    };
+    typedef std::map<const AstCFunc*,FuncSummary> FuncSummaryMap;
+
+    // STATE
+    FuncSummaryMap      m_summaries;    // Summary of each function walked
+    FuncSummary*        m_curp;         // Summary of function being walked
+    const FuncSummary*  m_evalp;        // Summary of _eval
+    int                 m_pos;          // Position of last reference
+    int                 m_loopPos;      // Position of first reference in outermost loop
+    int                 m_loopDepth;    // Number of loops we're under
+
+    // METHODS
+    VL_DEBUG_FUNC;  // Declare debug()
+
+    void unknown(AstNode* nodep, const char* whyp) {
+        if (!m_curp->m_unknownp) {
+            UINFO(4, "  Order unknown: "<<whyp<<": "<<nodep<<endl);
+            m_curp->m_unknownp = whyp;
+        }
+    }
+    void noteRead(AstVarScope* vscp, int pos) {
+        // A loop may repeat, so treat reads in it as before any write in it
+        if (m_loopDepth) pos = m_loopPos;
+        std::pair<int,int>& posr = m_curp->m_varPos[vscp];
+        if (!posr.first) posr.first = pos;  // Positions only grow, so first is least
+    }
+    void noteWrite(AstVarScope* vscp, int pos) {
+        m_curp->m_varPos[vscp].second = pos;  // Positions only grow, so last is greatest
+    }
+    const FuncSummary* summarize(AstCFunc* funcp) {
+        FuncSummaryMap::iterator it = m_summaries.find(funcp);
+        if (it != m_summaries.end()) return &it->second;
+        FuncSummary* origCurp = m_curp;
+        int origPos = m_pos;
+        int origLoopPos = m_loopPos;
+        int origLoopDepth = m_loopDepth;
+        {
+            m_curp = &m_summaries[funcp];
+            m_pos = 0;
+            m_loopPos = 0;
+            m_loopDepth = 0;
+            iterateChildren(funcp);
+            m_curp->m_length = m_pos;
+            m_curp->m_done = true;
+        }
+        const FuncSummary* summaryp = m_curp;
+        m_curp = origCurp;
+        m_pos = origPos;
+        m_loopPos = origLoopPos;
+        m_loopDepth = origLoopDepth;
+        return summaryp;
+    }
+
+    // VISITORS
+    virtual void visit(AstVarRef* nodep) VL_OVERRIDE {
+        AstVarScope* vscp = nodep->varScopep();
+        if (!vscp || !vscp->isCircular()) return;
+        if (nodep->lvalue()) {
+            noteWrite(vscp, ++m_pos);
+        } else {
+            noteRead(vscp, ++m_pos);
+        }
+    }
+    virtual void visit(AstWhile* nodep) VL_OVERRIDE {
+        if (!m_loopDepth) m_loopPos = m_pos + 1;
+        ++m_loopDepth;
+        iterateChildren(nodep);
+        --m_loopDepth;
+    }
+    virtual void visit(AstNodeCCall* nodep) VL_OVERRIDE {
+        iterateChildren(nodep);
+        if (!nodep->funcp()) {
+            unknown(nodep, "call of unknown function");
+            return;
+        } else if (nodep->funcp()->dpiImport()) {
+            // Imported function may call an export which reads or writes anything
+            unknown(nodep, "calls DPI import");
+            return;
+        }
+        // Each function is walked once, then its summary placed at each call
+        const FuncSummary* summaryp = summarize(nodep->funcp());
+        if (!summaryp->m_done) {
+            unknown(nodep, "recursive call");
+            return;
+        }
+        if (summaryp->m_unknownp) unknown(nodep, summaryp->m_unknownp);
+        int base = m_pos;
+        for (FuncSummary::VarPosMap::const_iterator it = summaryp->m_varPos.begin();
+             it != summaryp->m_varPos.end(); ++it) {
+            if (it->second.first) noteRead(it->first, base + it->second.first);
+        }
+        for (FuncSummary::VarPosMap::const_iterator it = summaryp->m_varPos.begin();
+             it != summaryp->m_varPos.end(); ++it) {
+            if (it->second.second) noteWrite(it->first, base + it->second.second);
+        }
+        m_pos += summaryp->m_length;
+    }
+    virtual void visit(AstUCStmt* nodep) VL_OVERRIDE {
+        unknown(nodep, "contains $c");
+    }
+    virtual void visit(AstUCFunc* nodep) VL_OVERRIDE {
+        unknown(nodep, "contains $c");
+    }
+    virtual void visit(AstExecGraph* nodep) VL_OVERRIDE {
+        // Mtasks run in parallel, so the statement order isn't the execution order
+        unknown(nodep, "threaded");
+    }
+    //--------------------
+    // Default: Just iterate
+    virtual void visit(AstNode* nodep) VL_OVERRIDE {
+        iterateChildren(nodep);
+    }
+
+public:
+    // CONSTRUCTORS
+    explicit ChangedOrderVisitor(AstCFunc* evalp) {
+        m_curp = NULL;
+        m_evalp = NULL;
+        m_pos = 0;
+        m_loopPos = 0;
+        m_loopDepth = 0;
+        if (evalp) m_evalp = summarize(evalp);
+    }
+    virtual ~ChangedOrderVisitor() {}
+    // METHODS
+    const char* whyNeedsDetect(AstVarScope* vscp) const {
+        // Return why the variable may change after being read in one pass
+        // of _eval, so needs another pass when it changes, else NULL
+        if (vscp->varp()->isUsedClock()) {
+            // Edges are detected against the value at the end of the
+            // previous pass, so a generated clock needs another pass
+            return "used as clock";
+        }
+        if (!m_evalp) return "no _eval";
+        if (m_evalp->m_unknownp) return m_evalp->m_unknownp;
+        FuncSummary::VarPosMap::const_iterator it = m_evalp->m_varPos.find(vscp);
+        if (it != m_evalp->m_varPos.end()
+            && it->second.first && it->second.second
+            && it->second.first <= it->second.second) {
+            return "read before written";
+        }
+        return NULL;
+    }
+};
+
 //######################################################################
 // Changed state, as a visitor of each AstNode
 
@@ -233,11 +397,23 @@ private:
 
     // STATE
     ChangedState*       m_statep;       // Shared state across visitors
+    ChangedOrderVisitor* m_orderp;      // Order of reads and writes in _eval
+    VDouble0            m_statDetects;  // Statistic tracking
+    VDouble0            m_statProven;   // Statistic tracking
 
     // METHODS
     VL_DEBUG_FUNC;  // Declare debug()
 
     void genChangeDet(AstVarScope* vscp) {
+        if (const char* whyp = m_orderp->whyNeedsDetect(vscp)) {
+            UINFO(4, "  Change detect, "<<whyp<<": "<<vscp<<endl);
+        } else {
+            // Settles in the same pass that changes it, so no need for another pass
+            UINFO(4, "  No change detect, written before read: "<<vscp<<endl);
+            ++m_statProven;
+            return;
+        }
+        ++m_statDetects;
         vscp->v3warn(IMPERFECTSCH, "Imperfect scheduling of variable: "<<vscp->prettyNameQ());
         ChangedInsertVisitor visitor (vscp, m_statep);
     }
@@ -273,7 +449,10 @@ private:
         m_statep->maybeCreateChgFuncp();
         m_statep->m_chgFuncp->addStmtsp(new AstChangeDet(nodep->fileline(), NULL, NULL, false));
 
+        ChangedOrderVisitor orderVisitor (v3Global.rootp()->evalp());
+        m_orderp = &orderVisitor;
         iterateChildren(nodep);
+        m_orderp = NULL;
     }
     virtual void visit(AstVarScope* nodep) VL_OVERRIDE {
         if (nodep->isCircular()) {
@@ -296,9 +475,13 @@ public:
     // CONSTRUCTORS
     ChangedVisitor(AstNetlist* nodep, ChangedState* statep) {
         m_statep = statep;
+        m_orderp = NULL;
         iterate(nodep);
     }
-    virtual ~ChangedVisitor() {}
+    virtual ~ChangedVisitor() {
+        V3Stats::addStat("Optimizations, Change detects", m_statDetects);
+        V3Stats::addStat("Optimizations, Change detects avoided", m_statProven);
+    }
 };
 
 //######################################################################
@@ -178,7 +178,7 @@ private:
     //  AstNodeStmt::user()     -> bool.  True if iterated already
     //  AstCFunc::user3p()      -> AstCFunc*, If set, replace ccalls to this func with new func
     //  AstNodeStmt::user3()    -> AstNode*.  True if to ignore this cell
-    //  AstNodeStmt::user4()    -> V3Hashed::V3Hash.  Hash value of this node (hash of 0 is illegal)
+    //  AstNodeStmt::user4p()   -> V3Hashed::Key.  Hash key of this node (key of 0 is illegal)
     AstUser1InUse       m_inuser1;
     AstUser3InUse       m_inuser3;
     //AstUser4InUse     part of V3Hashed
@@ -213,12 +213,12 @@ private:
     }
     void walkEmptyFuncs() {
         for (V3Hashed::iterator it = m_hashed.begin(); it != m_hashed.end(); ++it) {
-            AstNode* node1p = it->second;
+            AstNode* node1p = *it;
             AstCFunc* oldfuncp = VN_CAST(node1p, CFunc);
             if (oldfuncp
                 && oldfuncp->emptyBody()
                 && !oldfuncp->dontCombine()) {
-                UINFO(5,"     EmptyFunc "<<std::hex<<V3Hash(oldfuncp->user4p())
+                UINFO(5,"     EmptyFunc "<<std::hex<<V3Hashed::nodeHash(oldfuncp)
                       <<" "<<oldfuncp<<endl);
                 // Mark user3p on entire old tree, so we don't process it more
                 CombMarkVisitor visitor(oldfuncp);
@@ -230,16 +230,16 @@ private:
     }
     void walkDupFuncs() {
         for (V3Hashed::iterator it = m_hashed.begin(); it != m_hashed.end(); ++it) {
-            V3Hash hashval = it->first;
-            AstNode* node1p = it->second;
+            V3Hashed::Key key = it.key();
+            AstNode* node1p = *it;
             if (!VN_IS(node1p, CFunc)) continue;
-            UASSERT_OBJ(!hashval.isIllegal(), node1p, "Illegal (unhashed) nodes");
-            for (V3Hashed::iterator eqit = it; eqit != m_hashed.end(); ++eqit) {
-                AstNode* node2p = eqit->second;
-                if (!(eqit->first == hashval)) break;
+            UASSERT_OBJ(key, node1p, "Illegal (unhashed) nodes");
+            for (V3Hashed::iterator eqit = m_hashed.findFirst(key); eqit != m_hashed.end();
+                 eqit = m_hashed.findNext(eqit)) {
+                AstNode* node2p = *eqit;
                 if (node1p==node2p) continue;  // Identical iterator
                 if (node1p->user3p() || node2p->user3p()) continue;  // Already merged
-                if (node1p->sameTree(node2p)) {  // walk of tree has same comparison
+                if (m_hashed.sameNodes(node1p, node2p)) {  // walk of tree has same comparison
                     // Replace AstCCall's that point here
                     replaceFuncWFunc(VN_CAST(node2p, CFunc), VN_CAST(node1p, CFunc));
                     // Replacement may promote a slow routine to fast path
@@ -249,8 +249,8 @@ private:
         }
     }
     void replaceFuncWFunc(AstCFunc* oldfuncp, AstCFunc* newfuncp) {
-        UINFO(5,"     DupFunc "<<std::hex<<V3Hash(newfuncp->user4p())<<" "<<newfuncp<<endl);
-        UINFO(5,"         and "<<std::hex<<V3Hash(oldfuncp->user4p())<<" "<<oldfuncp<<endl);
+        UINFO(5,"     DupFunc "<<std::hex<<V3Hashed::nodeHash(newfuncp)<<" "<<newfuncp<<endl);
+        UINFO(5,"         and "<<std::hex<<V3Hashed::nodeHash(oldfuncp)<<" "<<oldfuncp<<endl);
         // Mark user3p on entire old tree, so we don't process it more
         ++m_statCombs;
         CombMarkVisitor visitor(oldfuncp);
@@ -274,18 +274,17 @@ private:
     }
 
     void walkDupCodeStart(AstNode* node1p) {
-        V3Hash hashval(node1p->user4p());
-        //UINFO(4,"    STMT "<<hashval<<" "<<node1p<<endl);
+        V3Hashed::Key key = V3Hashed::nodeKey(node1p);
+        //UINFO(4,"    STMT "<<V3Hashed::keyToHash(key)<<" "<<node1p<<endl);
         //
         int bestDepth = 0;  // Best substitution found in the search
         AstNode* bestNode2p = NULL;
         AstNode* bestLast1p = NULL;
         AstNode* bestLast2p = NULL;
         //
-        std::pair<V3Hashed::iterator,V3Hashed::iterator> eqrange
-            = m_hashed.mmap().equal_range(hashval);
-        for (V3Hashed::iterator eqit = eqrange.first; eqit != eqrange.second; ++eqit) {
-            AstNode* node2p = eqit->second;
+        for (V3Hashed::iterator eqit = m_hashed.findFirst(key); eqit != m_hashed.end();
+             eqit = m_hashed.findNext(eqit)) {
+            AstNode* node2p = *eqit;
             if (node1p==node2p) continue;
             //
             // We need to mark iteration to prevent matching code inside
@@ -319,9 +318,9 @@ private:
         if (node1p->user1p() || node2p->user1p()) return 0;  // Already iterated
         if (node1p->user3p() || node2p->user3p()) return 0;  // Already merged
         if (!m_hashed.sameNodes(node1p, node2p)) return 0;  // walk of tree has same comparison
-        V3Hash hashval(node1p->user4p());
-        //UINFO(9,"        wdup1 "<<level<<" "<<V3Hash(node1p->user4p())<<" "<<node1p<<endl);
-        //UINFO(9,"        wdup2 "<<level<<" "<<V3Hash(node2p->user4p())<<" "<<node2p<<endl);
+        V3Hash hashval = V3Hashed::nodeHash(node1p);
+        //UINFO(9,"        wdup1 "<<level<<" "<<V3Hashed::nodeHash(node1p)<<" "<<node1p<<endl);
+        //UINFO(9,"        wdup2 "<<level<<" "<<V3Hashed::nodeHash(node2p)<<" "<<node2p<<endl);
         m_walkLast1p = node1p;
         m_walkLast2p = node2p;
         node1p->user1(true);
@@ -22,6 +22,7 @@
 #include "V3EmitC.h"
 #include "V3EmitCBase.h"
 #include "V3Number.h"
+#include "V3Parallel.h"
 #include "V3PartitionGraph.h"
 #include "V3TSP.h"
 
@@ -36,6 +37,28 @@
 
 #define EMITC_NUM_CONSTW 8  // Number of VL_CONST_W_*X's in verilated.h (IE VL_CONST_W_8X is last)
 
+// We only do one display at once per emitter, so one state is enough
+
+struct EmitDispState {
+    string              m_format;  // "%s" and text from user
+    std::vector<char>   m_argsChar;  // Format of each argument to be printed
+    std::vector<AstNode*> m_argsp;  // Each argument to be printed
+    std::vector<string> m_argsFunc;  // Function before each argument to be printed
+    EmitDispState() { clear(); }
+    void clear() {
+        m_format = "";
+        m_argsChar.clear();
+        m_argsp.clear();
+        m_argsFunc.clear();
+    }
+    void pushFormat(const string& fmt) { m_format += fmt; }
+    void pushFormat(char fmt) { m_format += fmt; }
+    void pushArg(char fmtChar, AstNode* nodep, const string& func) {
+        m_argsChar.push_back(fmtChar);
+        m_argsp.push_back(nodep); m_argsFunc.push_back(func);
+    }
+};
+
 //######################################################################
 // Emit statements and math operators
 
@@ -50,6 +73,7 @@ private:
     int         m_labelNum;             // Next label number
     int         m_splitSize;    // # of cfunc nodes placed into output file
     int         m_splitFilenum; // File number being created, 0 = primary
+    EmitDispState m_emitDispState;  // $display being formed
 
 public:
     // METHODS
@@ -193,7 +217,7 @@ public:
             for (const V3GraphVertex* vxp = depGraphp->verticesBeginp(); vxp;
                  vxp = vxp->verticesNextp()) {
                 const ExecMTask* mtp = dynamic_cast<const ExecMTask*>(vxp);
-                if (mtp->threadRoot()) {
+                if (mtp->threadRoot() || v3Global.opt.threadsDynamic()) {
                     // Emit function declaration for this mtask
                     ofp()->putsPrivate(true);
                     puts("static void ");
@@ -367,6 +391,7 @@ public:
     virtual void visit(AstCoverDecl* nodep) VL_OVERRIDE {
         puts("__vlCoverInsert(");  // As Declared in emitCoverageDecl
         puts("&(vlSymsp->__Vcoverage[");
+        if (coverShards()) puts("0][");  // Insert finds the other shards
         puts(cvtToStr(nodep->dataDeclThisp()->binNum())); puts("])");
         // If this isn't the first instantiation of this module under this
         // design, don't really count the bucket, and rely on verilator_cov to
@@ -384,7 +409,13 @@ public:
         puts(");\n");
     }
     virtual void visit(AstCoverInc* nodep) VL_OVERRIDE {
-        if (v3Global.opt.threads()) {
+        if (int shards = coverShards()) {
+            puts("vlCovShardInc(vlSymsp->__Vcoverage[Verilated::threadNum() & ");
+            puts(cvtToStr(shards - 1));
+            puts("][");
+            puts(cvtToStr(nodep->declp()->dataDeclThisp()->binNum()));
+            puts("]);\n");
+        } else if (v3Global.opt.threads()) {
             puts("vlSymsp->__Vcoverage[");
             puts(cvtToStr(nodep->declp()->dataDeclThisp()->binNum()));
             puts("].fetch_add(1, std::memory_order_relaxed);\n");
@@ -1070,13 +1101,12 @@ class EmitVarTspSorter : public V3TSP::TspStateBase {
 private:
     // MEMBERS
     const MTaskIdSet& m_mtaskIds;  // Mtask we're ordering
-    static unsigned m_serialNext;  // Unique ID to establish serial order
-    unsigned m_serial;  // Serial ordering
+    unsigned m_serial;  // Serial ordering, unique among those being sorted
 public:
     // CONSTRUCTORS
-    explicit EmitVarTspSorter(const MTaskIdSet& mtaskIds)
+    EmitVarTspSorter(const MTaskIdSet& mtaskIds, unsigned serial)
         : m_mtaskIds(mtaskIds),
-          m_serial(++m_serialNext) {}
+          m_serial(serial) {}
     virtual ~EmitVarTspSorter() {}
     // METHODS
     bool operator<(const TspStateBase& other) const {
@@ -1105,8 +1135,6 @@ public:
     }
 };
 
-unsigned EmitVarTspSorter::m_serialNext = 0;
-
 //######################################################################
 // Internal EmitC implementation
 
@@ -1116,13 +1144,20 @@ class EmitCImp : EmitCStmts {
     std::vector<AstChangeDet*> m_blkChangeDetVec;  // All encountered changes in block
     bool        m_slow;  // Creating __Slow file
     bool        m_fast;  // Creating non __Slow file (or both)
+    int         m_addDoubleOr;  // Terms until next "||" in change detection
+    // Files created, added to the netlist by addCFiles() so it's not changed
+    // while emitting in parallel
+    struct CFileInfo {
+        string m_filename;
+        bool m_slow;
+        bool m_source;
+    };
+    std::vector<CFileInfo> m_cfiles;
 
     //---------------------------------------
     // METHODS
 
     void doubleOrDetect(AstChangeDet* changep, bool& gotOne) {
-        // cppcheck-suppress variableScope
-        static int s_addDoubleOr = 10;  // Determined experimentally as best
         if (!changep->rhsp()) {
             if (!gotOne) gotOne = true;
             else puts(" | ");
@@ -1138,11 +1173,11 @@ class EmitCImp : EmitCStmts {
                  ++word) {
                 if (!gotOne) {
                     gotOne = true;
-                    s_addDoubleOr = 10;
+                    m_addDoubleOr = 10;
                     puts("(");
-                } else if (--s_addDoubleOr == 0) {
+                } else if (--m_addDoubleOr == 0) {
                     puts("|| (");
-                    s_addDoubleOr = 10;
+                    m_addDoubleOr = 10;
                 } else {
                     puts(" | (");
                 }
@@ -1157,6 +1192,13 @@ class EmitCImp : EmitCStmts {
         }
     }
 
+    void addCFile(const string& filename, bool slow, bool source) {
+        CFileInfo info;
+        info.m_filename = filename;
+        info.m_slow = slow;
+        info.m_source = source;
+        m_cfiles.push_back(info);
+    }
     V3OutCFile* newOutCFile(AstNodeModule* modp, bool slow, bool source, int filenum=0) {
         string filenameNoExt = v3Global.opt.makeDir() + "/" + prefixNameProtect(modp);
         if (filenum) filenameNoExt += "__" + cvtToStr(filenum);
@@ -1166,17 +1208,17 @@ class EmitCImp : EmitCStmts {
             // Unfortunately we have some lint checks here, so we can't just skip processing.
             // We should move them to a different stage.
             string filename = VL_DEV_NULL;
-            newCFile(filename, slow, source);
+            addCFile(filename, slow, source);
             ofp = new V3OutCFile(filename);
         }
         else if (optSystemC()) {
             string filename = filenameNoExt+(source?".cpp":".h");
-            newCFile(filename, slow, source);
+            addCFile(filename, slow, source);
             ofp = new V3OutScFile(filename);
         }
         else {
             string filename = filenameNoExt+(source?".cpp":".h");
-            newCFile(filename, slow, source);
+            addCFile(filename, slow, source);
             ofp = new V3OutCFile(filename);
         }
 
@@ -1212,9 +1254,31 @@ class EmitCImp : EmitCStmts {
         return result;
     }
 
+    // With --threads-schedule dynamic, returns the number of upstream
+    // mtasks that must complete before mtaskp is pushed to the thread
+    // pool. Only mtasks with more than one need a VlMTaskVertex; a single
+    // upstream mtask just pushes its successor directly.
+    static uint32_t dynamicMTaskDeps(const ExecMTask* mtaskp) {
+        uint32_t result = 0;
+        for (V3GraphEdge* edgep = mtaskp->inBeginp(); edgep; edgep = edgep->inNextp()) {
+            ++result;
+        }
+        return result;
+    }
+
+    // Returns the initial count for mtaskp's VlMTaskVertex, or 0 if
+    // mtaskp needs no VlMTaskVertex under the current scheduling mode.
+    static uint32_t mtaskVertexDeps(const ExecMTask* mtaskp) {
+        if (v3Global.opt.threadsDynamic()) {
+            uint32_t deps = dynamicMTaskDeps(mtaskp);
+            return (deps > 1) ? deps : 0;
+        }
+        return packedMTaskMayBlock(mtaskp);
+    }
+
     void emitMTaskBody(AstMTaskBody* nodep) {
         ExecMTask* curExecMTaskp = nodep->execMTaskp();
-        if (packedMTaskMayBlock(curExecMTaskp)) {
+        if (!v3Global.opt.threadsDynamic() && packedMTaskMayBlock(curExecMTaskp)) {
             puts("vlTOPp->__Vm_mt_" + cvtToStr(curExecMTaskp->id())
                  + ".waitUntilUpstreamDone(even_cycle);\n");
         }
@@ -1246,6 +1310,27 @@ class EmitCImp : EmitCStmts {
         // Flush message queue
         puts("Verilated::endOfThreadMTask(vlSymsp->__Vm_evalMsgQp);\n");
 
+        if (v3Global.opt.threadsDynamic()) {
+            // Push every downstream mtask we made ready; any thread may
+            // then pick it up.
+            for (V3GraphEdge* edgep = curExecMTaskp->outBeginp();
+                 edgep; edgep = edgep->outNextp()) {
+                const ExecMTask* nextp = dynamic_cast<ExecMTask*>(edgep->top());
+                bool needsVertex = mtaskVertexDeps(nextp) > 0;
+                if (needsVertex) {
+                    puts("if (vlTOPp->__Vm_mt_" + cvtToStr(nextp->id())
+                         + ".signalUpstreamDone(even_cycle)) {\n");
+                }
+                puts("vlTOPp->__Vm_threadPoolp->dynamicPush("
+                     + protect(nextp->cFuncName()) + ", even_cycle, vlSymsp);\n");
+                if (needsVertex) puts("}\n");
+            }
+            if (curExecMTaskp->outEmpty()) {
+                puts("vlTOPp->__Vm_mt_final.signalUpstreamDone(even_cycle);\n");
+            }
+            return;
+        }
+
         // For any downstream mtask that's on another thread, bump its
         // counter and maybe notify it.
         for (V3GraphEdge* edgep = curExecMTaskp->outBeginp();
@@ -1402,7 +1487,27 @@ class EmitCImp : EmitCStmts {
         // Don't recurse to children -- this isn't the place to emit
         // function definitions for the nested CFuncs. We'll do that at the
         // end.
-        puts("vlTOPp->__Vm_even_cycle = !vlTOPp->__Vm_even_cycle;\n");
+        if (v3Global.opt.threadsDynamic()) {
+            puts("vlTOPp->__Vm_even_cycle = !vlTOPp->__Vm_even_cycle;\n");
+            // Hand the mtasks with no upstream dependencies to the pool,
+            // and let it run the graph to completion
+            string roots;
+            int nRoots = 0;
+            for (const V3GraphVertex* vxp = nodep->depGraphp()->verticesBeginp();
+                 vxp; vxp = vxp->verticesNextp()) {
+                const ExecMTask* etp = dynamic_cast<const ExecMTask*>(vxp);
+                if (!etp->inEmpty()) continue;
+                if (nRoots++) roots += ", ";
+                roots += protect(etp->cFuncName());
+            }
+            if (nRoots) {
+                puts("static const VlExecFnp __Vroots[] = {" + roots + "};\n");
+                puts("vlTOPp->__Vm_threadPoolp->dynamicRun(__Vroots, " + cvtToStr(nRoots)
+                     + ", vlSymsp, &vlTOPp->__Vm_mt_final, vlTOPp->__Vm_even_cycle);\n");
+                puts("Verilated::mtaskId(0);\n");
+            }
+            return;
+        }
 
         // Build the list of initial mtasks to start
         std::vector<const ExecMTask*> execMTasks;
@@ -1417,6 +1522,8 @@ class EmitCImp : EmitCStmts {
                     nodep, "More root mtasks than available threads");
 
         if (!execMTasks.empty()) {
+            puts("if (VL_LIKELY(vlTOPp->__Vm_threadPoolp->staticBegin())) {\n");
+            puts("vlTOPp->__Vm_even_cycle = !vlTOPp->__Vm_even_cycle;\n");
             for (uint32_t i = 0; i < execMTasks.size(); ++i) {
                 bool runInline = (i == execMTasks.size() - 1);
                 if (runInline) {
@@ -1434,7 +1541,40 @@ class EmitCImp : EmitCStmts {
                 }
             }
             puts("vlTOPp->__Vm_mt_final.waitUntilUpstreamDone(vlTOPp->__Vm_even_cycle);\n");
+            puts("vlTOPp->__Vm_threadPoolp->staticEnd();\n");
+            puts("} else {\n");
+            // Nested in a static eval on a shared pool (from DPI), so the
+            // workers are busy with it; run the mtasks here in dependency
+            // order. The mtask vertices are untouched, so the even cycle
+            // isn't toggled.
+            emitMTasksSerial(nodep);
+            puts("}\n");
+        }
+    }
+    void emitMTasksSerial(AstExecGraph* nodep) {
+        typedef std::map<const ExecMTask*, uint32_t> WaitingMap;
+        WaitingMap waiting;  // Upstream mtasks yet to be emitted
+        std::vector<const ExecMTask*> ready;
+        for (const V3GraphVertex* vxp = nodep->depGraphp()->verticesBeginp();
+             vxp; vxp = vxp->verticesNextp()) {
+            const ExecMTask* etp = dynamic_cast<const ExecMTask*>(vxp);
+            uint32_t deps = 0;
+            for (V3GraphEdge* edgep = etp->inBeginp(); edgep; edgep = edgep->inNextp()) ++deps;
+            if (deps) waiting[etp] = deps;
+            else ready.push_back(etp);
+        }
+        while (!ready.empty()) {
+            const ExecMTask* etp = ready.back();
+            ready.pop_back();
+            puts("Verilated::mtaskId(" + cvtToStr(etp->id()) + ");\n");
+            iterateAndNextNull(etp->bodyp()->stmtsp());
+            puts("Verilated::endOfThreadMTask(vlSymsp->__Vm_evalMsgQp);\n");
+            for (V3GraphEdge* edgep = etp->outBeginp(); edgep; edgep = edgep->outNextp()) {
+                const ExecMTask* nextp = dynamic_cast<const ExecMTask*>(edgep->top());
+                if (!--waiting[nextp]) ready.push_back(nextp);
+            }
         }
+        puts("Verilated::mtaskId(0);\n");
     }
 
     //---------------------------------------
@@ -1591,10 +1731,19 @@ public:
         m_modp = NULL;
         m_slow = false;
         m_fast = false;
+        m_addDoubleOr = 10;  // Determined experimentally as best
     }
     virtual ~EmitCImp() {}
     void mainImp(AstNodeModule* modp, bool slow, bool fast);
     void mainInt(AstNodeModule* modp);
+    void addCFiles() {
+        // Add the files written to the netlist, in the order written
+        for (std::vector<CFileInfo>::const_iterator it = m_cfiles.begin();
+             it != m_cfiles.end(); ++it) {
+            newCFile(it->m_filename, it->m_slow, it->m_source);
+        }
+        m_cfiles.clear();
+    }
     void mainDoFunc(AstCFunc* nodep) {
         iterate(nodep);
     }
@@ -1790,30 +1939,8 @@ void EmitCStmts::emitOpName(AstNode* nodep, const string& format,
 //----------------------------------------------------------------------
 // Mid level - VISITS
 
-// We only do one display at once, so can just use static state
-
-struct EmitDispState {
-    string              m_format;  // "%s" and text from user
-    std::vector<char>   m_argsChar;  // Format of each argument to be printed
-    std::vector<AstNode*> m_argsp;  // Each argument to be printed
-    std::vector<string> m_argsFunc;  // Function before each argument to be printed
-    EmitDispState() { clear(); }
-    void clear() {
-        m_format = "";
-        m_argsChar.clear();
-        m_argsp.clear();
-        m_argsFunc.clear();
-    }
-    void pushFormat(const string& fmt) { m_format += fmt; }
-    void pushFormat(char fmt) { m_format += fmt; }
-    void pushArg(char fmtChar, AstNode* nodep, const string& func) {
-        m_argsChar.push_back(fmtChar);
-        m_argsp.push_back(nodep); m_argsFunc.push_back(func);
-    }
-} emitDispState;
-
 void EmitCStmts::displayEmit(AstNode* nodep, bool isScan) {
-    if (emitDispState.m_format == ""
+    if (m_emitDispState.m_format == ""
         && VN_IS(nodep, Display)) {  // not fscanf etc, as they need to return value
         // NOP
     } else {
@@ -1855,13 +1982,13 @@ void EmitCStmts::displayEmit(AstNode* nodep, bool isScan) {
         } else {
             nodep->v3fatalSrc("Unknown displayEmit node type");
         }
-        ofp()->putsQuoted(emitDispState.m_format);
+        ofp()->putsQuoted(m_emitDispState.m_format);
         // Arguments
-        for (unsigned i=0; i < emitDispState.m_argsp.size(); i++) {
+        for (unsigned i=0; i < m_emitDispState.m_argsp.size(); i++) {
             puts(",");
-            char     fmt  = emitDispState.m_argsChar[i];
-            AstNode* argp = emitDispState.m_argsp[i];
-            string   func = emitDispState.m_argsFunc[i];
+            char     fmt  = m_emitDispState.m_argsChar[i];
+            AstNode* argp = m_emitDispState.m_argsp[i];
+            string   func = m_emitDispState.m_argsFunc[i];
             ofp()->indentInc();
             ofp()->putbs("");
             if (func!="") puts(func);
@@ -1879,7 +2006,7 @@ void EmitCStmts::displayEmit(AstNode* nodep, bool isScan) {
         if (isStmt) puts(";\n");
         else puts(" ");
         // Prep for next
-        emitDispState.clear();
+        m_emitDispState.clear();
     }
 }
 
@@ -1914,9 +2041,9 @@ void EmitCStmts::displayArg(AstNode* dispp, AstNode** elistp, bool isScan,
     } else {
         pfmt = string("%") + vfmt + fmtLetter;
     }
-    emitDispState.pushFormat(pfmt);
-    emitDispState.pushArg(' ', NULL, cvtToStr(argp->widthMin()));
-    emitDispState.pushArg(fmtLetter, argp, "");
+    m_emitDispState.pushFormat(pfmt);
+    m_emitDispState.pushArg(' ', NULL, cvtToStr(argp->widthMin()));
+    m_emitDispState.pushArg(fmtLetter, argp, "");
 
     // Next parameter
     *elistp = (*elistp)->nextp();
@@ -1929,7 +2056,7 @@ void EmitCStmts::displayNode(AstNode* nodep, AstScopeName* scopenamep,
 
     // Convert Verilog display to C printf formats
     //          "%0t" becomes "%d"
-    emitDispState.clear();
+    m_emitDispState.clear();
     string vfmt;
     string::const_iterator pos = vformat.begin();
     bool inPct = false;
@@ -1939,7 +2066,7 @@ void EmitCStmts::displayNode(AstNode* nodep, AstScopeName* scopenamep,
             inPct = true;
             vfmt = "";
         } else if (!inPct) {  // Normal text
-            emitDispState.pushFormat(*pos);
+            m_emitDispState.pushFormat(*pos);
         } else {  // Format character
             inPct = false;
             switch (tolower(pos[0])) {
@@ -1952,7 +2079,7 @@ void EmitCStmts::displayNode(AstNode* nodep, AstScopeName* scopenamep,
                 inPct = true;  // Get more digits
                 break;
             case '%':
-                emitDispState.pushFormat("%%");  // We're printf'ing it, so need to quote the %
+                m_emitDispState.pushFormat("%%");  // We're printf'ing it, so need to quote the %
                 break;
             // Special codes
             case '~': displayArg(nodep, &elistp, isScan, vfmt, 'd'); break;  // Signed decimal
@@ -1974,15 +2101,15 @@ void EmitCStmts::displayNode(AstNode* nodep, AstScopeName* scopenamep,
             case 'm': {
                 UASSERT_OBJ(scopenamep, nodep, "Display with %m but no AstScopeName");
                 string suffix = scopenamep->scopePrettySymName();
-                if (suffix=="") emitDispState.pushFormat("%S");
-                else emitDispState.pushFormat("%N");  // Add a . when needed
-                emitDispState.pushArg(' ', NULL, "vlSymsp->name()");
-                emitDispState.pushFormat(suffix);
+                if (suffix=="") m_emitDispState.pushFormat("%S");
+                else m_emitDispState.pushFormat("%N");  // Add a . when needed
+                m_emitDispState.pushArg(' ', NULL, "vlSymsp->name()");
+                m_emitDispState.pushFormat(suffix);
                 break;
             }
             case 'l': {
                 // Better than not compiling
-                emitDispState.pushFormat("----");
+                m_emitDispState.pushFormat("----");
                 break;
             }
             default:
@@ -2021,14 +2148,17 @@ void EmitCImp::emitMTaskVertexCtors(bool* firstp) {
     for (const V3GraphVertex* vxp = depGraphp->verticesBeginp();
          vxp; vxp = vxp->verticesNextp()) {
         const ExecMTask* mtp = dynamic_cast<const ExecMTask*>(vxp);
-        unsigned edgesInCt = packedMTaskMayBlock(mtp);
-        if (packedMTaskMayBlock(mtp) > 0) {
+        unsigned edgesInCt = mtaskVertexDeps(mtp);
+        if (edgesInCt > 0) {
             emitCtorSep(firstp);
             puts("__Vm_mt_"+cvtToStr(mtp->id())+"("+cvtToStr(edgesInCt)+")");
         }
-        // Each mtask with no packed successor will become a dependency
-        // for the final node:
-        if (!mtp->packNextp()) ++finalEdgesInCt;
+        // Each mtask with no packed successor (or, when scheduling
+        // dynamically, no successor at all) will become a dependency for
+        // the final node:
+        if (v3Global.opt.threadsDynamic() ? mtp->outEmpty() : !mtp->packNextp()) {
+            ++finalEdgesInCt;
+        }
     }
 
     emitCtorSep(firstp);
@@ -2071,29 +2201,29 @@ void EmitCImp::emitCtorImp(AstNodeModule* modp) {
     emitTextSection(AstType::atScCtor);
 
     if (modp->isTop() && v3Global.opt.mtasks()) {
-        // TODO-- For now each top module creates its own ThreadPool here,
-        // and deletes it in the destructor. If A and B are each top level
-        // modules, each creates a separate thread pool.  This allows
-        // A.eval() and B.eval() to run concurrently without any
-        // interference -- so long as the physical machine has enough cores
-        // to support both pools and all testbench threads.
-        //
-        // In the future, we might want to let the client provide a
-        // threadpool to the constructor. This would allow two or more
-        // models to share a single threadpool.
-        //
-        // For example: suppose models A and B are each compiled to run on
-        // 4 threads. The client might create a single thread pool with 3
-        // threads and pass it to both models. If the client can ensure that
-        // A.eval() and B.eval() do NOT run concurrently, there will be no
-        // contention for the threads. This mode is missing for now.  (Is
-        // there demand for such a setup?)
-        puts("__Vm_threadPoolp = new VlThreadPool("
-             // Note we create N-1 threads in the thread pool. The thread
+        // Each top module creates its own ThreadPool here, and releases it
+        // in the destructor, unless the client installed a pool with
+        // VlThreadPool::shared() for models to share. Separate pools allow
+        // A.eval() and B.eval() to run concurrently without interference,
+        // so long as the machine has enough cores for both pools; a shared
+        // pool avoids oversubscribing the cores when there are many models.
+        // With dynamic scheduling, size each thread's deque so it can hold
+        // every mtask; zero means static scheduling
+        uint32_t dequeCapacity = 0;
+        if (v3Global.opt.threadsDynamic()) {
+            for (const V3GraphVertex* vxp
+                     = v3Global.rootp()->execGraphp()->depGraphp()->verticesBeginp();
+                 vxp; vxp = vxp->verticesNextp()) {
+                ++dequeCapacity;
+            }
+        }
+        puts("__Vm_threadPoolp = VlThreadPool::acquire("
+             // Note we ask for N-1 threads in the thread pool. The thread
              // that calls eval() becomes the final Nth thread for the
              // duration of the eval call.
              + cvtToStr(v3Global.opt.threads() - 1)
              + ", " + cvtToStr(v3Global.opt.profThreads())
+             + ", " + cvtToStr(dequeCapacity)
              + ");\n");
 
         if (v3Global.opt.profThreads()) {
@@ -2134,10 +2264,18 @@ void EmitCImp::emitCoverageImp(AstNodeModule* modp) {
         }
         // static doesn't need save-restore as is constant
         puts(   "static uint32_t fake_zero_count = 0;\n");
-        // Used for second++ instantiation of identical bin
-        puts(   "if (!enable) count32p = &fake_zero_count;\n");
-        puts(   "*count32p = 0;\n");
-        puts("VL_COVER_INSERT(count32p,");
+        if (int shards = coverShards()) {
+            puts(   "int shards = " + cvtToStr(shards) + ";\n");
+            // Used for second++ instantiation of identical bin
+            puts(   "if (!enable) { count32p = &fake_zero_count; shards = 1; }\n");
+            puts("VL_COVER_INSERT_SHARDED(count32p, shards,");
+            puts(   " sizeof(__VlSymsp->__Vcoverage[0]) / sizeof(uint32_t),");
+        } else {
+            // Used for second++ instantiation of identical bin
+            puts(   "if (!enable) count32p = &fake_zero_count;\n");
+            puts(   "*count32p = 0;\n");
+            puts("VL_COVER_INSERT(count32p,");
+        }
         puts(   "  \"filename\",filenamep,");
         puts(   "  \"lineno\",lineno,");
         puts(   "  \"column\",column,\n");
@@ -2156,7 +2294,7 @@ void EmitCImp::emitDestructorImp(AstNodeModule* modp) {
     puts(prefixNameProtect(modp) + "::~" + prefixNameProtect(modp) + "() {\n");
     if (modp->isTop()) {
         if (v3Global.opt.mtasks()) {
-            puts("delete __Vm_threadPoolp; __Vm_threadPoolp = NULL;\n");
+            puts("VlThreadPool::release(__Vm_threadPoolp); __Vm_threadPoolp = NULL;\n");
         }
         // Call via function in __Trace.cpp as this .cpp file does not have trace header
         if (v3Global.needTraceDumper()) {
@@ -2353,6 +2491,13 @@ void EmitCImp::emitSettleLoop(const std::string& eval_call, bool initial) {
     puts(        "__Vchange = "+protect("_change_request")+"(vlSymsp);\n");
     puts(    "}\n");
     puts("} while (VL_UNLIKELY(__Vchange));\n");
+    if (v3Global.opt.profSettle() && !initial) {
+        puts("++vlSymsp->__Vm_settleEvals;\n");
+        puts("vlSymsp->__Vm_settlePasses += __VclockLoop;\n");
+        puts("if (VL_UNLIKELY(__VclockLoop > vlSymsp->__Vm_settleMaxPasses)) {\n");
+        puts(    "vlSymsp->__Vm_settleMaxPasses = __VclockLoop;\n");
+        puts("}\n");
+    }
 }
 
 void EmitCImp::emitWrapEval(AstNodeModule* modp) {
@@ -2570,8 +2715,9 @@ void EmitCStmts::emitVarSort(const VarSortMap& vmap, VarVec* sortedp) {
 
     // Create a TSP sort state for each MTaskIdSet footprint
     V3TSP::StateVec states;
+    unsigned serial = 0;
     for (MTaskVarSortMap::iterator it = m2v.begin(); it != m2v.end(); ++it) {
-        states.push_back(new EmitVarTspSorter(it->first));
+        states.push_back(new EmitVarTspSorter(it->first, ++serial));
     }
 
     // Do the TSP sort
@@ -2660,7 +2806,7 @@ void EmitCImp::emitMTaskState() {
     for (const V3GraphVertex* vxp = depGraphp->verticesBeginp();
          vxp; vxp = vxp->verticesNextp()) {
         const ExecMTask* mtp = dynamic_cast<const ExecMTask*>(vxp);
-        if (packedMTaskMayBlock(mtp) > 0) {
+        if (mtaskVertexDeps(mtp) > 0) {
             puts("VlMTaskVertex __Vm_mt_" + cvtToStr(mtp->id()) + ";\n");
         }
     }
@@ -3021,12 +3167,13 @@ void EmitCImp::mainImp(AstNodeModule* modp, bool slow, bool fast) {
         for (const V3GraphVertex* vxp = depGraphp->verticesBeginp();
              vxp; vxp = vxp->verticesNextp()) {
             const ExecMTask* mtaskp = dynamic_cast<const ExecMTask*>(vxp);
-            if (mtaskp->threadRoot()) {
+            if (mtaskp->threadRoot() || v3Global.opt.threadsDynamic()) {
                 maybeSplit(modp);
-                // Only define one function for all the mtasks packed on
-                // a given thread. We'll name this function after the
-                // root mtask though it contains multiple mtasks' worth
-                // of logic.
+                // Statically scheduled, only define one function for all
+                // the mtasks packed on a given thread. We'll name this
+                // function after the root mtask though it contains
+                // multiple mtasks' worth of logic. Dynamically scheduled,
+                // each mtask is its own function.
                 iterate(mtaskp->bodyp());
             }
         }
@@ -3047,6 +3194,7 @@ class EmitCTrace : EmitCStmts {
     AstCFunc*   m_funcp;        // Function we're in now
     bool        m_slow;         // Making slow file
     int         m_enumNum;      // Enumeration number (whole netlist)
+    std::vector<const AstCFunc*> m_groups;  // TRACE_CHANGE_GROUPs called by m_funcp
 
     // METHODS
     void newOutCFile(int filenum) {
@@ -3161,6 +3309,31 @@ class EmitCTrace : EmitCStmts {
         puts("\n//======================\n\n");
     }
 
+    void emitTraceGroups() {
+        // Each group dumps its codes into its own shard of the trace file,
+        // on the thread pool. Merging the shards in group order then
+        // gives the same output as dumping the groups in turn.
+        puts("struct "+protect("__Vgroups")+" {\n");
+        puts(symClassName()+"* symsp;\n");
+        puts(v3Global.opt.traceClassBase()+"* vcdp;\n");
+        puts("uint32_t code;\n");
+        puts("static void run(void* userp, int index) {\n");
+        puts(protect("__Vgroups")+"* gp = static_cast<"+protect("__Vgroups")+"*>(userp);\n");
+        puts(v3Global.opt.traceClassBase()+"* shardp = gp->vcdp->shardp(index);\n");
+        puts("switch (index) {\n");
+        for (size_t i = 0; i < m_groups.size(); ++i) {
+            puts("case "+cvtToStr(i)+": gp->symsp->TOPp->"+m_groups[i]->nameProtect()
+                 +"(gp->symsp, shardp, gp->code); break;\n");
+        }
+        puts("}\n");
+        puts("}\n");
+        puts("} "+protect("__Vgroupsd")+" = {vlSymsp, vcdp, code};\n");
+        puts("vcdp->shardsReserve("+cvtToStr(m_groups.size())+");\n");
+        puts("vlTOPp->__Vm_threadPoolp->parallelFor(&"+protect("__Vgroups")+"::run, &"
+             +protect("__Vgroupsd")+", "+cvtToStr(m_groups.size())+");\n");
+        puts("vcdp->shardsMerge("+cvtToStr(m_groups.size())+");\n");
+    }
+
     bool emitTraceIsScBv(AstTraceInc* nodep) {
         const AstVarRef* varrefp = VN_CAST(nodep->valuep(), VarRef);
         if (!varrefp) return false;
@@ -3412,6 +3585,7 @@ class EmitCTrace : EmitCStmts {
             } else if (nodep->funcType() == AstCFuncType::TRACE_FULL_SUB) {
             } else if (nodep->funcType() == AstCFuncType::TRACE_CHANGE) {
             } else if (nodep->funcType() == AstCFuncType::TRACE_CHANGE_SUB) {
+            } else if (nodep->funcType() == AstCFuncType::TRACE_CHANGE_GROUP) {
             } else nodep->v3fatalSrc("Bad Case");
 
             if (nodep->initsp()) {
@@ -3424,7 +3598,9 @@ class EmitCTrace : EmitCStmts {
             if (nodep->stmtsp()) {
                 putsDecoration("// Body\n");
                 puts("{\n");
+                m_groups.clear();
                 iterateAndNextNull(nodep->stmtsp());
+                if (!m_groups.empty()) emitTraceGroups();
                 puts("}\n");
             }
             if (nodep->finalsp()) {
@@ -3435,6 +3611,13 @@ class EmitCTrace : EmitCStmts {
         }
         m_funcp = NULL;
     }
+    virtual void visit(AstCCall* nodep) VL_OVERRIDE {
+        if (nodep->funcp()->funcType() == AstCFuncType::TRACE_CHANGE_GROUP) {
+            m_groups.push_back(nodep->funcp());  // Emitted by emitTraceGroups
+        } else {
+            EmitCStmts::visit(nodep);
+        }
+    }
     virtual void visit(AstTraceDecl* nodep) VL_OVERRIDE {
         int enumNum = emitTraceDeclDType(nodep->dtypep());
         if (nodep->arrayRange().ranged()) {
@@ -3484,19 +3667,54 @@ public:
 //######################################################################
 // EmitC class functions
 
+class EmitCImpJob {
+    // One module's header, or implementation files, for V3EmitC::emitc() to
+    // write.  Jobs only read the netlist, so may run in parallel.
+    AstNodeModule* m_modp;  // Module to emit
+    bool m_int;  // Emit header, else implementation
+    bool m_slow;  // Passed to mainImp()
+    bool m_fast;  // Passed to mainImp()
+public:
+    EmitCImp m_imp;  // Emitter, holding the files written
+    // CONSTRUCTORS
+    EmitCImpJob(AstNodeModule* modp, bool isInt, bool slow, bool fast)
+        : m_modp(modp), m_int(isInt), m_slow(slow), m_fast(fast) {}
+    // METHODS
+    void main() {
+        if (m_int) m_imp.mainInt(m_modp);
+        else m_imp.mainImp(m_modp, m_slow, m_fast);
+    }
+    static void run(void* userp, int index) {
+        (*static_cast<std::vector<EmitCImpJob*>*>(userp))[index]->main();
+    }
+};
+
 void V3EmitC::emitc() {
     UINFO(2,__FUNCTION__<<": "<<endl);
-    // Process each module in turn
+    // Each module's header and implementation files are separate jobs
+    std::vector<EmitCImpJob*> jobs;
     for (AstNodeModule* nodep = v3Global.rootp()->modulesp();
          nodep; nodep = VN_CAST(nodep->nextp(), NodeModule)) {
-        { EmitCImp cint; cint.mainInt(nodep); }
+        jobs.push_back(new EmitCImpJob(nodep, true, false, false));
         if (v3Global.opt.outputSplit()) {
-            { EmitCImp fast; fast.mainImp(nodep, false, true); }
-            { EmitCImp slow; slow.mainImp(nodep, true, false); }
+            jobs.push_back(new EmitCImpJob(nodep, false, false, true));
+            jobs.push_back(new EmitCImpJob(nodep, false, true, false));
         } else {
-            { EmitCImp both; both.mainImp(nodep, true, true); }
+            jobs.push_back(new EmitCImpJob(nodep, false, true, true));
         }
     }
+    V3File::createMakeDir();  // Else parallel jobs race to create it
+    if (v3Global.opt.protectIds()) {
+        // Protected names depend on the order names are first protected
+        for (size_t i = 0; i < jobs.size(); ++i) jobs[i]->main();
+    } else {
+        V3Parallel::forEach(static_cast<int>(jobs.size()), &EmitCImpJob::run, &jobs);
+    }
+    // Add files to the netlist in a fixed order, independent of --verilate-jobs
+    for (std::vector<EmitCImpJob*>::iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        (*it)->m_imp.addCFiles();
+        VL_DO_DANGLING(delete *it, *it);
+    }
 }
 
 void V3EmitC::emitcTrace() {
@@ -65,6 +65,12 @@ public:
             return v3Global.opt.modPrefix() + "_" + protect(nodep->name());
         }
     }
+    static int coverShards() {  // Number of per-thread coverage count copies, 0=not sharded
+        if (!v3Global.opt.coveragePerThread() || !v3Global.opt.threads()) return 0;
+        int shards = 1;  // Power of 2, so the shard can be selected with a mask
+        while (shards < v3Global.opt.threads()) shards <<= 1;
+        return shards;
+    }
     static string topClassName() {  // Return name of top wrapper module
         return v3Global.opt.prefix();
     }
@@ -115,9 +115,11 @@ class CMakeEmitter {
         *of << "# Threaded output mode?  0/1/N threads (from --threads)\n";
         cmake_set_raw(*of, name + "_THREADS", cvtToStr(v3Global.opt.threads()));
         *of << "# VCD Tracing output mode?  0/1 (from --trace)\n";
-        cmake_set_raw(*of, name + "_TRACE_VCD", (v3Global.opt.trace() && (v3Global.opt.traceFormat() == TraceFormat::VCD))?"1":"0");
+        cmake_set_raw(*of, name + "_TRACE_VCD", (v3Global.opt.trace() && v3Global.opt.traceFormat().vcdFlavor())?"1":"0");
         *of << "# FST Tracing output mode? 0/1 (from --fst-trace)\n";
-        cmake_set_raw(*of, name + "_TRACE_FST", (v3Global.opt.trace() && (v3Global.opt.traceFormat() != TraceFormat::VCD)) ? "1":"0");
+        cmake_set_raw(*of, name + "_TRACE_FST", (v3Global.opt.trace() && v3Global.opt.traceFormat().fstFlavor()) ? "1":"0");
+        *of << "# Raw Tracing output mode? 0/1 (from --trace-raw)\n";
+        cmake_set_raw(*of, name + "_TRACE_RAW", (v3Global.opt.trace() && v3Global.opt.traceFormat() == TraceFormat::RAW) ? "1":"0");
 
         *of << "\n### Sources...\n";
         std::vector<string> classes_fast, classes_slow, support_fast, support_slow, global;
@@ -158,7 +160,7 @@ class CMakeEmitter {
             global.push_back("${VERILATOR_ROOT}/include/"
                              + v3Global.opt.traceSourceBase() + "_c.cpp");
             if (v3Global.opt.systemC()) {
-                if (v3Global.opt.traceFormat() != TraceFormat::VCD) {
+                if (!v3Global.opt.traceFormat().vcdFlavor()) {
                     v3error("Unsupported: This trace format is not supported in SystemC, use VCD format.");
                 }
                 global.push_back("${VERILATOR_ROOT}/include/"
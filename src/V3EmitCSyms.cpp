@@ -425,6 +425,11 @@ void EmitCSyms::emitSymHdr() {
         puts("bool __Vm_activity;  ///< Used by trace routines to determine change occurred\n");
     }
     puts("bool __Vm_didInit;\n");
+    if (v3Global.opt.profSettle()) {
+        puts("vluint64_t __Vm_settleEvals;  ///< Number of eval() calls\n");
+        puts("vluint64_t __Vm_settlePasses;  ///< Number of _eval passes in those calls\n");
+        puts("int __Vm_settleMaxPasses;  ///< Most _eval passes in one call\n");
+    }
 
     puts("\n// SUBCELL STATE\n");
     for (std::vector<ScopeModPair>::iterator it = m_scopes.begin(); it != m_scopes.end(); ++it) {
@@ -443,7 +448,16 @@ void EmitCSyms::emitSymHdr() {
         puts("\n// COVERAGE\n");
         puts(v3Global.opt.threads() ? "std::atomic<uint32_t>" : "uint32_t");
         puts(" __Vcoverage[");
-        puts(cvtToStr(m_coverBins));
+        if (int shards = coverShards()) {
+            // One row of counts per thread.  Round each row up to whole
+            // cache lines plus one, so no two rows share a line whatever
+            // the array's alignment.
+            const int lineCounts = VL_CACHE_LINE_BYTES / sizeof(uint32_t);
+            int stride = (m_coverBins + lineCounts - 1) / lineCounts * lineCounts + lineCounts;
+            puts(cvtToStr(shards) + "][" + cvtToStr(stride));
+        } else {
+            puts(cvtToStr(m_coverBins));
+        }
         puts("];\n");
     }
 
@@ -461,7 +475,19 @@ void EmitCSyms::emitSymHdr() {
 
     puts("\n// CREATORS\n");
     puts(symClassName()+"("+topClassName()+"* topp, const char* namep);\n");
-    puts(string("~")+symClassName()+"() {}\n");
+    if (v3Global.opt.profSettle()) {
+        puts(string("~")+symClassName()+"() {\n");
+        puts("if (__Vm_settleEvals) {\n");
+        puts("VL_PRINTF_MT(\"- %s: Settle loop: %\" VL_PRI64 \"u evals, %\" VL_PRI64 \"u passes,\"\n");
+        puts("             \" %.2f passes average, %d passes maximum\\n\",\n");
+        puts("             name(), __Vm_settleEvals, __Vm_settlePasses,\n");
+        puts("             static_cast<double>(__Vm_settlePasses) / __Vm_settleEvals,\n");
+        puts("             __Vm_settleMaxPasses);\n");
+        puts("}\n");
+        puts("}\n");
+    } else {
+        puts(string("~")+symClassName()+"() {}\n");
+    }
 
     for (std::map<int,bool>::iterator it = m_usesVfinal.begin();
          it != m_usesVfinal.end(); ++it) {
@@ -593,6 +619,11 @@ void EmitCSyms::emitSymImp() {
     }
     if (v3Global.opt.trace()) puts("    , __Vm_activity(false)\n");
     puts("    , __Vm_didInit(false)\n");
+    if (v3Global.opt.profSettle()) {
+        puts("    , __Vm_settleEvals(0)\n");
+        puts("    , __Vm_settlePasses(0)\n");
+        puts("    , __Vm_settleMaxPasses(0)\n");
+    }
     puts("    // Setup submodule names\n");
     char comma = ',';
     for (std::vector<ScopeModPair>::iterator it = m_scopes.begin(); it != m_scopes.end(); ++it) {
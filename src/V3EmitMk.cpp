@@ -54,7 +54,7 @@ public:
         of.puts("VM_THREADS = "); of.puts(cvtToStr(v3Global.opt.threads())); of.puts("\n");
         of.puts("# Tracing output mode?  0/1 (from --trace)\n");
         of.puts("VM_TRACE = "); of.puts(v3Global.opt.trace()?"1":"0"); of.puts("\n");
-        of.puts("# Tracing threaded output mode?  0/1 (from --trace-fst-thread)\n");
+        of.puts("# Tracing threaded output mode?  0/1 (from --trace-fst-thread, --trace-vcd-thread)\n");
         of.puts("VM_TRACE_THREADED = "); of.puts(v3Global.opt.traceFormat().threaded()
                                                  ?"1":"0"); of.puts("\n");
 
@@ -86,7 +86,7 @@ public:
                     if (v3Global.opt.trace()) {
                         putMakeClassEntry(of, v3Global.opt.traceSourceBase() + "_c.cpp");
                         if (v3Global.opt.systemC()) {
-                            if (v3Global.opt.traceFormat() != TraceFormat::VCD) {
+                            if (!v3Global.opt.traceFormat().vcdFlavor()) {
                                 v3error("Unsupported: This trace format is not supported in SystemC, use VCD format.");
                             } else {
                                 putMakeClassEntry(of, v3Global.opt.traceSourceLang() + ".cpp");
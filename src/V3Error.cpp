@@ -41,6 +41,7 @@ bool V3Error::s_describedWarnings = false;
 bool V3Error::s_pretendError[V3ErrorCode::_ENUM_MAX];
 V3Error::MessagesSet V3Error::s_messages;
 V3Error::ErrorExitCb V3Error::s_errorExitCb = NULL;
+V3Mutex V3Error::s_mutex;
 
 struct v3errorIniter {
     v3errorIniter() {  V3Error::init(); }
@@ -161,6 +162,7 @@ string V3Error::warnMore() {
 }
 
 void V3Error::v3errorEnd(std::ostringstream& sstr, const string& locationStr) {
+    V3LockGuard lock (s_mutex, V3LockGuard::AdoptLock());  // Locked by v3errorPrep
 #if defined(__COVERITY__) || defined(__cppcheck__)
     if (s_errorCode==V3ErrorCode::EC_FATAL) __coverity_panic__(x);
 #endif
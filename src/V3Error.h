@@ -21,6 +21,7 @@
 #include "verilatedos.h"
 
 // Limited V3 headers here - this is a base class for Vlc etc
+#include "V3Parallel.h"
 #include "V3String.h"
 
 #include <bitset>
@@ -237,6 +238,7 @@ class V3Error {
     static bool         s_errorSuppressed;      // Error being formed should be suppressed
     static MessagesSet  s_messages;             // What errors we've outputted
     static ErrorExitCb  s_errorExitCb;          // Callback when error occurs for dumping
+    static V3Mutex      s_mutex;                // Held from v3errorPrep to v3errorEnd
 
     enum MaxErrors {    MAX_ERRORS = 50 };      // Fatal after this may errors
 
@@ -278,6 +280,7 @@ class V3Error {
     // Internals for v3error()/v3fatal() macros only
     // Error end takes the string stream to output, be careful to seek() as needed
     static void v3errorPrep(V3ErrorCode code) {
+        s_mutex.lock();  // Released by v3errorEnd
         s_errorStr.str(""); s_errorCode = code;
         s_errorContexted = false; s_errorSuppressed = false; }
     static std::ostringstream& v3errorStr() { return s_errorStr; }
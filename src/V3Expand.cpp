@@ -31,6 +31,7 @@
 #include "V3Global.h"
 #include "V3Expand.h"
 #include "V3Ast.h"
+#include "V3ParallelCFunc.h"
 
 #include <algorithm>
 #include <cstdarg>
@@ -42,10 +43,11 @@ class ExpandVisitor : public AstNVisitor {
 private:
     // NODE STATE
     //  AstNode::user1()        -> bool.  Processed
-    AstUser1InUse       m_inuser1;
+    //  AstUser1InUse is held by V3Expand::expandAll, as visitors run in parallel
 
     // STATE
     AstNode*            m_stmtp;        // Current statement
+    bool                m_skipFuncs;    // Don't visit CFuncs, they're expanded in parallel
 
     // METHODS
     VL_DEBUG_FUNC;  // Declare debug()
@@ -951,6 +953,9 @@ private:
 
     //--------------------
     // Default: Just iterate
+    virtual void visit(AstCFunc* nodep) VL_OVERRIDE {
+        if (!m_skipFuncs) iterateChildren(nodep);
+    }
     virtual void visit(AstVar*) VL_OVERRIDE {}  // Don't hit varrefs under vars
     virtual void visit(AstNode* nodep) VL_OVERRIDE {
         iterateChildren(nodep);
@@ -958,11 +963,15 @@ private:
 
 public:
     // CONSTRUCTORS
-    explicit ExpandVisitor(AstNetlist* nodep) {
+    ExpandVisitor(AstNode* nodep, bool skipFuncs) {
         m_stmtp = NULL;
+        m_skipFuncs = skipFuncs;
         iterate(nodep);
     }
     virtual ~ExpandVisitor() {}
+    static void expandFunc(void*, AstCFunc* funcp, int) {
+        ExpandVisitor visitor (funcp, false);
+    }
 };
 
 //----------------------------------------------------------------------
@@ -974,7 +983,11 @@ public:
 void V3Expand::expandAll(AstNetlist* nodep) {
     UINFO(2,__FUNCTION__<<": "<<endl);
     {
-        ExpandVisitor visitor (nodep);
+        AstUser1InUse inuser1;  // For ExpandVisitor
+        // Functions are expanded independently, so in parallel
+        V3ParallelCFunc funcs (nodep);
+        funcs.forEach(&ExpandVisitor::expandFunc, NULL);
+        ExpandVisitor visitor (nodep, true);  // Anything outside functions
     }  // Destruct before checking
     V3Global::dumpCheckGlobalTree("expand", 0, v3Global.opt.dumpTreeLevel(__FILE__) >= 3);
 }
@@ -19,6 +19,7 @@
 
 #include "V3Global.h"
 #include "V3File.h"
+#include "V3Parallel.h"
 #include "V3Os.h"
 #include "V3PreShell.h"
 #include "V3String.h"
@@ -26,15 +27,18 @@
 
 #include <cerrno>
 #include <cstdarg>
+#include <cstdio>
 #include <fcntl.h>
 #include <iomanip>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
 # define INFILTER_PIPE  // Allow pipe filtering.  Needs fork()
+# define INFILTER_MMAP  // Allow memory mapping unfiltered files.  Needs mmap()
 #endif
 
 #ifdef HAVE_STAT_NSEC  // i.e. Linux 2.6, from configure
@@ -48,6 +52,9 @@
 #ifdef INFILTER_PIPE
 # include <sys/wait.h>
 #endif
+#ifdef INFILTER_MMAP
+# include <sys/mman.h>
+#endif
 
 #if defined(_WIN32) || defined(__MINGW32__)
 # include <io.h>  // open, read, write, close
@@ -57,6 +64,7 @@
 //#define INFILTER_IPC_BUFSIZ 16
 #define INFILTER_IPC_BUFSIZ (64*1024)  // For debug, try this as a small number
 #define INFILTER_CACHE_MAX  (64*1024)  // Maximum bytes to cache if same file read twice
+#define INFILTER_MMAP_MIN   INFILTER_CACHE_MAX  // Minimum bytes to map rather than read
 
 //######################################################################
 // V3File Internal state
@@ -132,9 +140,12 @@ public:
     std::vector<string> getAllDeps() const;
     void writeTimes(const string& filename, const string& cmdlineIn);
     bool checkTimes(const string& filename, const string& cmdlineIn);
+    bool readCache(const string& cacheDir, const string& cmdlineIn);
+    void writeCache(const string& cacheDir, const string& cmdlineIn);
 };
 
 V3FileDependImp  dependImp;  // Depend implementation class
+static V3Mutex dependMutex;  // Guards dependImp, as files may be written in parallel
 
 //######################################################################
 // V3FileDependImp
@@ -287,13 +298,216 @@ inline bool V3FileDependImp::checkTimes(const string& filename, const string& cm
     return true;
 }
 
+//######################################################################
+// --cache-dir support
+//
+// Each key (version, directory and command line) has a directory in the
+// cache, with a manifest listing up to CACHE_ENTRIES entries, oldest first:
+//      E <entry>
+//      S <size> <mstime> <mnstime> <sha256> <filename>  (each file read)
+//      T <filename>  (each file written, stored as <entry>/<index>)
+
+class V3FileCacheEntry {
+public:
+    struct Src {
+        off_t   m_size;
+        time_t  m_mstime;
+        time_t  m_mnstime;
+        string  m_hash;  // Sha256 of contents
+        string  m_filename;
+    };
+    string m_name;  // Hash of all sources, also subdirectory name
+    std::vector<Src> m_srcs;  // Files read
+    std::vector<string> m_tgts;  // Files written
+};
+typedef std::vector<V3FileCacheEntry> V3FileCacheEntries;
+
+enum { CACHE_ENTRIES = 8 };  // Entries kept for each key
+
+static string cacheHashFile(const string& filename) {
+    // Return hash of file contents, or "" if can't read
+    std::ifstream is (filename.c_str(), std::ios::binary);
+    if (!is) return "";
+    VHashSha256 digest;
+    char buf[64*1024];
+    while (is.read(buf, sizeof(buf)) || is.gcount()) {
+        digest.insert(buf, is.gcount());
+    }
+    return digest.digestHex();
+}
+
+static bool cacheCopyFile(const string& fromFilename, const string& toFilename) {
+    std::ifstream is (fromFilename.c_str(), std::ios::binary);
+    if (!is) return false;
+    std::ofstream os (toFilename.c_str(), std::ios::binary);
+    if (!os) return false;
+    os<<is.rdbuf();
+    return !os.fail();
+}
+
+static string cacheKeyDir(const string& cacheDir, const string& cmdline) {
+    VHashSha256 digest;
+    digest.insert(V3Options::version()+"\n");
+    digest.insert(V3Os::filenameRealPath(".")+"\n");
+    digest.insert(cmdline);
+    return cacheDir+"/"+digest.digestHex().substr(0, 32);
+}
+
+static V3FileCacheEntries cacheReadManifest(const string& filename) {
+    V3FileCacheEntries entries;
+    std::ifstream is (filename.c_str());
+    while (is.good()) {
+        string line = V3Os::getline(is);
+        if (line.length() < 2 || line[1] != ' ') continue;
+        std::istringstream ls (line.substr(2));
+        if (line[0] == 'E') {
+            entries.push_back(V3FileCacheEntry());
+            ls>>entries.back().m_name;
+        } else if (entries.empty()) {
+            continue;  // Corrupt
+        } else if (line[0] == 'S') {
+            V3FileCacheEntry::Src src;
+            ls>>src.m_size>>src.m_mstime>>src.m_mnstime>>src.m_hash;
+            ls.get();  // Space
+            src.m_filename = V3Os::getline(ls);
+            entries.back().m_srcs.push_back(src);
+        } else if (line[0] == 'T') {
+            entries.back().m_tgts.push_back(line.substr(2));
+        }
+    }
+    return entries;
+}
+
+static void cacheWriteManifest(const string& filename, const V3FileCacheEntries& entries) {
+    // Write then rename, so parallel runs never see a partial manifest
+    const string tmpFilename = filename+".tmp";
+    {
+        const vl_unique_ptr<std::ofstream> ofp (V3File::new_ofstream_nodepend(tmpFilename));
+        if (ofp->fail()) v3fatal("Can't write "<<tmpFilename);
+        for (V3FileCacheEntries::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            *ofp<<"E "<<it->m_name<<endl;
+            for (std::vector<V3FileCacheEntry::Src>::const_iterator sit = it->m_srcs.begin();
+                 sit != it->m_srcs.end(); ++sit) {
+                *ofp<<"S "<<sit->m_size<<" "<<sit->m_mstime<<" "<<sit->m_mnstime
+                    <<" "<<sit->m_hash<<" "<<sit->m_filename<<endl;
+            }
+            for (std::vector<string>::const_iterator tit = it->m_tgts.begin();
+                 tit != it->m_tgts.end(); ++tit) {
+                *ofp<<"T "<<*tit<<endl;
+            }
+        }
+    }
+    if (rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+        v3fatal("Can't rename "<<tmpFilename<<" to "<<filename);
+    }
+}
+
+static bool cacheEntryMatches(const V3FileCacheEntry& entry) {
+    for (std::vector<V3FileCacheEntry::Src>::const_iterator it = entry.m_srcs.begin();
+         it != entry.m_srcs.end(); ++it) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+        struct stat chkStat;
+        if (stat(it->m_filename.c_str(), &chkStat) != 0) return false;
+        if (chkStat.st_size != it->m_size) return false;
+        // Only need to read the file if touched since cached
+        if (chkStat.st_mtime == it->m_mstime
+            && VL_STAT_MTIME_NSEC(chkStat) == it->m_mnstime) continue;
+        if (cacheHashFile(it->m_filename) != it->m_hash) {
+            UINFO(2,"   --cache-dir: changed "<<it->m_filename<<endl);
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool V3FileDependImp::readCache(const string& cacheDir, const string& cmdlineIn) {
+    const string keyDir = cacheKeyDir(cacheDir, stripQuotes(cmdlineIn));
+    const V3FileCacheEntries entries = cacheReadManifest(keyDir+"/manifest");
+    // Most recent first
+    for (V3FileCacheEntries::const_reverse_iterator it = entries.rbegin();
+         it != entries.rend(); ++it) {
+        if (!cacheEntryMatches(*it)) continue;
+        UINFO(1,"--cache-dir: Restoring "<<keyDir<<"/"<<it->m_name<<endl);
+        for (size_t i = 0; i < it->m_tgts.size(); ++i) {
+            V3File::createMakeDirFor(it->m_tgts[i]);
+            if (!cacheCopyFile(keyDir+"/"+it->m_name+"/"+cvtToStr(i), it->m_tgts[i])) {
+                UINFO(1,"--cache-dir: Can't restore "<<it->m_tgts[i]<<endl);
+                return false;  // Caller will make all outputs again
+            }
+        }
+        for (std::vector<V3FileCacheEntry::Src>::const_iterator sit = it->m_srcs.begin();
+             sit != it->m_srcs.end(); ++sit) {
+            addSrcDepend(sit->m_filename);
+        }
+        for (std::vector<string>::const_iterator tit = it->m_tgts.begin();
+             tit != it->m_tgts.end(); ++tit) {
+            addTgtDepend(*tit);
+        }
+        return true;
+    }
+    return false;
+}
+
+inline void V3FileDependImp::writeCache(const string& cacheDir, const string& cmdlineIn) {
+    const string keyDir = cacheKeyDir(cacheDir, stripQuotes(cmdlineIn));
+    V3FileCacheEntry entry;
+    VHashSha256 entryDigest;
+    for (std::set<DependFile>::iterator iter=m_filenameList.begin();
+         iter!=m_filenameList.end(); ++iter) {
+        if (iter->target()) {
+            entry.m_tgts.push_back(iter->filename());
+        } else if (iter->exists()) {
+            // Stat again, so the hash read below is at least as new
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+            struct stat srcStat;
+            if (stat(iter->filename().c_str(), &srcStat) != 0) return;
+            V3FileCacheEntry::Src src;
+            src.m_size = srcStat.st_size;
+            src.m_mstime = srcStat.st_mtime;
+            src.m_mnstime = VL_STAT_MTIME_NSEC(srcStat);
+            src.m_hash = cacheHashFile(iter->filename());
+            src.m_filename = iter->filename();
+            if (src.m_hash.empty()) return;  // Can't read, so don't cache
+            entry.m_srcs.push_back(src);
+            entryDigest.insert(src.m_filename+" "+src.m_hash+"\n");
+        }
+    }
+    entry.m_name = entryDigest.digestHex().substr(0, 32);
+
+    V3Os::createDir(cacheDir);
+    V3Os::createDir(keyDir);
+    const string entryDir = keyDir+"/"+entry.m_name;
+    V3Os::createDir(entryDir);
+    for (size_t i = 0; i < entry.m_tgts.size(); ++i) {
+        if (!cacheCopyFile(entry.m_tgts[i], entryDir+"/"+cvtToStr(i))) {
+            UINFO(1,"--cache-dir: Can't store "<<entry.m_tgts[i]<<endl);
+            return;
+        }
+    }
+
+    V3FileCacheEntries entries = cacheReadManifest(keyDir+"/manifest");
+    for (V3FileCacheEntries::iterator it = entries.begin(); it != entries.end(); ) {
+        if (it->m_name == entry.m_name) it = entries.erase(it);  // Replaced below
+        else ++it;
+    }
+    entries.push_back(entry);
+    while (entries.size() > CACHE_ENTRIES) {
+        V3Os::unlinkRegexp(keyDir+"/"+entries.front().m_name, "*");
+        entries.erase(entries.begin());
+    }
+    cacheWriteManifest(keyDir+"/manifest", entries);
+    UINFO(1,"--cache-dir: Stored "<<entryDir<<endl);
+}
+
 //######################################################################
 // V3File
 
 void V3File::addSrcDepend(const string& filename) {
+    V3LockGuard lock (dependMutex);
     dependImp.addSrcDepend(filename);
 }
 void V3File::addTgtDepend(const string& filename) {
+    V3LockGuard lock (dependMutex);
     dependImp.addTgtDepend(filename);
 }
 void V3File::writeDepend(const string& filename) {
@@ -308,6 +522,12 @@ void V3File::writeTimes(const string& filename, const string& cmdlineIn) {
 bool V3File::checkTimes(const string& filename, const string& cmdlineIn) {
     return dependImp.checkTimes(filename, cmdlineIn);
 }
+bool V3File::readCache(const string& cacheDir, const string& cmdlineIn) {
+    return dependImp.readCache(cacheDir, cmdlineIn);
+}
+void V3File::writeCache(const string& cacheDir, const string& cmdlineIn) {
+    dependImp.writeCache(cacheDir, cmdlineIn);
+}
 void V3File::createMakeDirFor(const string& filename) {
     if (filename != VL_DEV_NULL
         // If doesn't start with makeDir then some output file user requested
@@ -328,9 +548,11 @@ void V3File::createMakeDir() {
 
 class VInFilterImp {
     typedef std::map<string,string> FileContentsMap;
+    typedef std::map<string,std::pair<const char*,size_t> > FileMapsMap;
     typedef VInFilter::StrList StrList;
 
     FileContentsMap     m_contentsMap;  // Cache of file contents
+    FileMapsMap         m_mapsMap;      // Files mapped into memory, kept until exit once used
     bool                m_readEof;      // Received EOF on read
 #ifdef INFILTER_PIPE
     pid_t               m_pid;          // fork() process id
@@ -558,6 +780,45 @@ protected:
         }
         return true;
     }
+    bool mapWholefile(const string& filename, const char*& datapr, size_t& sizer) {
+#ifdef INFILTER_MMAP
+        if (m_pid) return false;  // Must read through the filter
+        FileMapsMap::iterator it = m_mapsMap.find(filename);
+        if (it != m_mapsMap.end()) {
+            datapr = it->second.first;
+            sizer = it->second.second;
+            return true;
+        }
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd<0) return false;
+        struct stat st;
+        void* mapp = MAP_FAILED;
+        // Small files are faster to read, and are cached by readWholefile
+        if (0 == fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size >= INFILTER_MMAP_MIN) {
+            mapp = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (mapp == MAP_FAILED) return false;
+        UINFO(4,"Mapped "<<st.st_size<<" bytes of "<<filename<<endl);
+        datapr = static_cast<const char*>(mapp);
+        sizer = static_cast<size_t>(st.st_size);
+        m_mapsMap.insert(make_pair(filename, std::make_pair(datapr, sizer)));
+        return true;
+#else
+        if (filename!="" || datapr || sizer) {}  // Prevent unused
+        return false;
+#endif
+    }
+    void unmapWholefile(const string& filename) {
+#ifdef INFILTER_MMAP
+        FileMapsMap::iterator it = m_mapsMap.find(filename);
+        if (it == m_mapsMap.end()) return;
+        munmap(const_cast<char*>(it->second.first), it->second.second);
+        m_mapsMap.erase(it);
+#else
+        if (filename!="") {}  // Prevent unused
+#endif
+    }
     size_t listSize(StrList& sl) {
         size_t out = 0;
         for (StrList::iterator it=sl.begin(); it!=sl.end(); ++it) {
@@ -596,6 +857,14 @@ bool VInFilter::readWholefile(const string& filename, VInFilter::StrList& outl)
     if (!m_impp) v3fatalSrc("readWholefile on invalid filter");
     return m_impp->readWholefile(filename, outl);
 }
+bool VInFilter::mapWholefile(const string& filename, const char*& datapr, size_t& sizer) {
+    if (!m_impp) v3fatalSrc("mapWholefile on invalid filter");
+    return m_impp->mapWholefile(filename, datapr, sizer);
+}
+void VInFilter::unmapWholefile(const string& filename) {
+    if (!m_impp) v3fatalSrc("unmapWholefile on invalid filter");
+    m_impp->unmapWholefile(filename);
+}
 
 //######################################################################
 // V3OutFormatter: A class for printing to a file, with automatic indentation of C++ code.
@@ -612,16 +881,9 @@ V3OutFormatter::V3OutFormatter(const string& filename, V3OutFormatter::Language
 
 const string V3OutFormatter::indentSpaces(int num) {
     // Indent the specified number of spaces.  Use spaces.
-    static char str[MAXSPACE+20];
-    char* cp = str;
     if (num>MAXSPACE) num = MAXSPACE;
-    while (num>0) {
-        *cp++ = ' ';
-        num --;
-    }
-    *cp++ = '\0';
-    string st (str);
-    return st;
+    if (num<0) num = 0;
+    return string(num, ' ');
 }
 
 bool V3OutFormatter::tokenStart(const char* cp, const char* cmp) {
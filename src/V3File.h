@@ -65,6 +65,8 @@ public:
     static std::vector<string> getAllDeps();
     static void writeTimes(const string& filename, const string& cmdlineIn);
     static bool checkTimes(const string& filename, const string& cmdlineIn);
+    static bool readCache(const string& cacheDir, const string& cmdlineIn);
+    static void writeCache(const string& cacheDir, const string& cmdlineIn);
 
     // Directory utilities
     static void createMakeDirFor(const string& filename);
@@ -93,6 +95,12 @@ public:
     // METHODS
     // Read file contents and return it.  Return true on success.
     bool readWholefile(const string& filename, StrList& outl);
+    // Map a large unfiltered file into memory, setting datapr and sizer to
+    // its contents, which stay mapped until exit.  Return false if not
+    // mapped, in which case use readWholefile.
+    bool mapWholefile(const string& filename, const char*& datapr, size_t& sizer);
+    // Unmap a file mapped by mapWholefile that won't be used after all
+    void unmapWholefile(const string& filename);
 };
 
 //============================================================================
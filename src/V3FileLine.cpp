@@ -17,6 +17,7 @@
 #include "config_build.h"
 #include "verilatedos.h"
 
+#include "V3Arena.h"
 #include "V3Error.h"
 #include "V3FileLine.h"
 #include "V3String.h"
@@ -26,6 +27,10 @@
 # include "V3Stats.h"
 # include "V3Config.h"
 # include "V3File.h"
+# include "V3Parallel.h"
+typedef V3AstLockGuard FileLineLockGuard;  // FileLines may be made by V3Parallel jobs
+#else
+struct FileLineLockGuard { FileLineLockGuard() {} };  // No V3Parallel jobs
 #endif
 
 #include <algorithm>
@@ -115,6 +120,22 @@ void VFileContent::pushText(const string& text) {
 }
 
 string VFileContent::getLine(int lineno) const {
+    if (m_mappedp) {
+        if (m_mappedLines.empty()) {
+            // Number lines as pushText would, with a line [0] and a leftover line
+            m_mappedLines.push_back(0);
+            m_mappedLines.push_back(0);
+            for (size_t pos = 0; pos < m_mappedSize; ++pos) {
+                if (m_mappedp[pos] == '\n') m_mappedLines.push_back(pos+1);
+            }
+        }
+        if (lineno >= 0 && lineno < static_cast<int>(m_mappedLines.size())) {
+            size_t start = m_mappedLines[lineno];
+            size_t end = (lineno+1 < static_cast<int>(m_mappedLines.size())
+                          ? m_mappedLines[lineno+1] : m_mappedSize);
+            return string(m_mappedp + start, end - start);
+        }
+    }
     // Return error text rather than asserting so the user isn't left without a message
     // cppcheck-suppress negativeContainerIndex
     if (VL_UNCOVERABLE(lineno < 0 || lineno >= (int)m_lines.size())) {
@@ -424,6 +445,7 @@ typedef vl_unordered_set<FileLine*> FileLineCheckSet;
 FileLineCheckSet fileLineLeakChecks;
 
 void* FileLine::operator new(size_t size) {
+    FileLineLockGuard lock;
     FileLine* objp = static_cast<FileLine*>(::operator new(size));
     fileLineLeakChecks.insert(objp);
     return objp;
@@ -431,6 +453,7 @@ void* FileLine::operator new(size_t size) {
 
 void FileLine::operator delete(void* objp, size_t size) {
     if (!objp) return;
+    FileLineLockGuard lock;
     FileLine* flp = static_cast<FileLine*>(objp);
     FileLineCheckSet::iterator it = fileLineLeakChecks.find(flp);
     if (it != fileLineLeakChecks.end()) {
@@ -440,6 +463,23 @@ void FileLine::operator delete(void* objp, size_t size) {
     }
     ::operator delete(objp);
 }
+#else
+static V3Arena& fileLineArena() {
+    // Separate from the AstNode arena, so nodes stay packed together.
+    // Never destructed, as FileLines are used until exit.
+    static V3Arena* s_arenap = new V3Arena;
+    return *s_arenap;
+}
+
+void* FileLine::operator new(size_t size) {
+    FileLineLockGuard lock;
+    return fileLineArena().allocate(size);
+}
+
+void FileLine::operator delete(void* objp, size_t size) {
+    FileLineLockGuard lock;
+    fileLineArena().deallocate(objp, size);
+}
 #endif
 
 void FileLine::deleteAllRemaining() {
@@ -28,6 +28,7 @@
 #include <map>
 #include <set>
 #include <deque>
+#include <vector>
 
 //######################################################################
 
@@ -64,11 +65,17 @@ class VFileContent {
     // MEMBERS
     int m_id;  // Content ID number
     std::deque<string> m_lines;  // Source text lines
+    const char* m_mappedp;  // Source text mapped in memory, instead of m_lines
+    size_t m_mappedSize;  // Bytes at m_mappedp
+    mutable std::vector<size_t> m_mappedLines;  // Offset of each line, made when first needed
 public:
-    VFileContent() { static int s_id = 0; m_id = ++s_id; }
+    VFileContent() : m_mappedp(NULL), m_mappedSize(0) { static int s_id = 0; m_id = ++s_id; }
     ~VFileContent() { }
     // METHODS
     void pushText(const string& text);  // Add arbitrary text (need not be line-by-line)
+    // Use text that stays in memory until exit, rather than copying it; only
+    // when no other text is pushed
+    void pushMapped(const char* datap, size_t size) { m_mappedp = datap; m_mappedSize = size; }
     string getLine(int lineno) const;
     string ascii() const { return "ct"+cvtToStr(m_id); }
     static int debug();
@@ -140,10 +147,8 @@ public:
     FileLine* copyOrSameFileLine();
     static void deleteAllRemaining();
     ~FileLine() { }
-#ifdef VL_LEAK_CHECKS
     static void* operator new(size_t size);
     static void operator delete(void* obj, size_t size);
-#endif
     void newContent() { m_contentp = new VFileContent; m_contentLineno = 1; }
     // METHODS
     void lineno(int num) { m_firstLineno = num; m_lastLineno = num;
@@ -86,7 +86,6 @@ protected:
     void acyclicDFSIterate(V3GraphVertex *vertexp, int depth, uint32_t currentRank);
     void acyclicCut();
     void acyclicLoop(V3GraphVertex* vertexp, int depth);
-    double orderDFSIterate(V3GraphVertex* vertexp);
     void dumpEdge(std::ostream& os, V3GraphVertex* vertexp, V3GraphEdge* edgep);
     void verticesUnlink() { m_vertices.reset(); }
     // ACCESSORS
@@ -183,6 +182,7 @@ class V3GraphVertex {
 protected:
     friend class V3Graph;    friend class V3GraphEdge;
     friend class GraphAcyc;  friend class GraphAlgRank;
+    friend class GraphAlgOrderFanout;
     V3ListEnt<V3GraphVertex*> m_vertices;  // All vertices, linked list
     V3List<V3GraphEdge*> m_outs;        // Outbound edges,linked list
     V3List<V3GraphEdge*> m_ins;         // Inbound edges, linked list
@@ -19,6 +19,7 @@
 
 #include "V3Global.h"
 #include "V3GraphAlg.h"
+#include "V3GraphCsr.h"
 #include "V3GraphPathChecker.h"
 
 #include <cstdarg>
@@ -221,79 +222,82 @@ void V3Graph::weaklyConnected(V3EdgeFuncP edgeFuncp) {
 
 class GraphAlgStrongly : GraphAlg<> {
 private:
+    typedef V3GraphCsr::Index Index;
+    V3GraphCsr m_csr;  // Followed edges
     uint32_t m_currentDfs;  // DFS count
-    std::vector<V3GraphVertex*> m_callTrace;  // List of everything we hit processing so far
+    std::vector<uint32_t> m_dfs;  // DFS number indicating possible root of subtree, 0=not iterated
+    std::vector<uint32_t> m_color;  // Output subtree number (fully processed)
+    std::vector<Index> m_callTrace;  // List of everything we hit processing so far
 
     void main() {
         // Use Tarjan's algorithm to find the strongly connected subgraphs.
         // Node State:
         //     Vertex::user     // DFS number indicating possible root of subtree, 0=not iterated
         //     Vertex::color    // Output subtree number (fully processed)
+        // Computed in m_dfs and m_color, then copied to the vertices.
 
         // Clear info
-        for (V3GraphVertex* vertexp = m_graphp->verticesBeginp();
-             vertexp; vertexp=vertexp->verticesNextp()) {
-            vertexp->color(0);
-            vertexp->user(0);
-        }
+        const Index size = m_csr.size();
+        m_dfs.resize(size, 0);
+        m_color.resize(size, 0);
         // Color graph
-        for (V3GraphVertex* vertexp = m_graphp->verticesBeginp();
-             vertexp; vertexp=vertexp->verticesNextp()) {
-            if (!vertexp->user()) {
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            if (!m_dfs[vertex]) {
                 m_currentDfs++;
-                vertexIterate(vertexp);
+                vertexIterate(vertex);
             }
         }
         // If there's a single vertex of a color, it doesn't need a subgraph
         // This simplifies the consumer's code, and reduces graph debugging clutter
-        for (V3GraphVertex* vertexp = m_graphp->verticesBeginp();
-             vertexp; vertexp=vertexp->verticesNextp()) {
+        for (Index vertex = 0; vertex < size; ++vertex) {
             bool onecolor = true;
-            for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep=edgep->outNextp()) {
-                if (followEdge(edgep)) {
-                    if (vertexp->color() == edgep->top()->color()) {
-                        onecolor = false;
-                        break;
-                    }
+            for (V3GraphCsr::EdgeIterator it = m_csr.outBegin(vertex);
+                 it != m_csr.outEnd(vertex); ++it) {
+                if (m_color[vertex] == m_color[*it]) {
+                    onecolor = false;
+                    break;
                 }
             }
-            if (onecolor) vertexp->color(0);
+            if (onecolor) m_color[vertex] = 0;
+        }
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            m_csr.vertexp(vertex)->user(m_dfs[vertex]);
+            m_csr.vertexp(vertex)->color(m_color[vertex]);
         }
     }
 
-    void vertexIterate(V3GraphVertex* vertexp) {
+    void vertexIterate(Index vertex) {
         uint32_t thisDfsNum = m_currentDfs++;
-        vertexp->user(thisDfsNum);
-        vertexp->color(0);
-        for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep=edgep->outNextp()) {
-            if (followEdge(edgep)) {
-                V3GraphVertex* top = edgep->top();
-                if (!top->user()) {  // Dest not computed yet
-                    vertexIterate(top);
-                }
-                if (!top->color()) {  // Dest not in a component
-                    if (vertexp->user() > top->user()) vertexp->user(top->user());
-                }
+        m_dfs[vertex] = thisDfsNum;
+        m_color[vertex] = 0;
+        for (V3GraphCsr::EdgeIterator it = m_csr.outBegin(vertex);
+             it != m_csr.outEnd(vertex); ++it) {
+            Index top = *it;
+            if (!m_dfs[top]) {  // Dest not computed yet
+                vertexIterate(top);
+            }
+            if (!m_color[top]) {  // Dest not in a component
+                if (m_dfs[vertex] > m_dfs[top]) m_dfs[vertex] = m_dfs[top];
             }
         }
-        if (vertexp->user() == thisDfsNum) {  // New head of subtree
-            vertexp->color(thisDfsNum);  // Mark as component
+        if (m_dfs[vertex] == thisDfsNum) {  // New head of subtree
+            m_color[vertex] = thisDfsNum;  // Mark as component
             while (!m_callTrace.empty()) {
-                V3GraphVertex* popVertexp = m_callTrace.back();
-                if (popVertexp->user() >= thisDfsNum) {  // Lower node is part of this subtree
+                Index popVertex = m_callTrace.back();
+                if (m_dfs[popVertex] >= thisDfsNum) {  // Lower node is part of this subtree
                     m_callTrace.pop_back();
-                    popVertexp->color(thisDfsNum);
+                    m_color[popVertex] = thisDfsNum;
                 } else {
                     break;
                 }
             }
         } else {  // In another subtree (maybe...)
-            m_callTrace.push_back(vertexp);
+            m_callTrace.push_back(vertex);
         }
     }
 public:
     GraphAlgStrongly(V3Graph* graphp, V3EdgeFuncP edgeFuncp)
-        : GraphAlg<>(graphp, edgeFuncp) {
+        : GraphAlg<>(graphp, edgeFuncp), m_csr(graphp, edgeFuncp) {
         m_currentDfs = 0;
         main();
     }
@@ -310,45 +314,52 @@ void V3Graph::stronglyConnected(V3EdgeFuncP edgeFuncp) {
 
 class GraphAlgRank : GraphAlg<> {
 private:
+    typedef V3GraphCsr::Index Index;
+    V3GraphCsr m_csr;  // Followed edges
+    std::vector<uint32_t> m_rank;  // Rank of each vertex
+    std::vector<uint32_t> m_state;  // 1 indicates processing, 2 indicates completed
+
     void main() {
         // Rank each vertex, ignoring cutable edges
-        // Vertex::m_user begin: 1 indicates processing, 2 indicates completed
+        // Computed in m_rank and m_state, then copied to the vertices
         // Clear existing ranks
-        for (V3GraphVertex* vertexp = m_graphp->verticesBeginp();
-             vertexp; vertexp=vertexp->verticesNextp()) {
-            vertexp->rank(0);
-            vertexp->user(0);
-        }
-        for (V3GraphVertex* vertexp = m_graphp->verticesBeginp();
-             vertexp; vertexp=vertexp->verticesNextp()) {
-            if (!vertexp->user()) {
-                vertexIterate(vertexp, 1);
+        const Index size = m_csr.size();
+        m_rank.resize(size, 0);
+        m_state.resize(size, 0);
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            if (!m_state[vertex]) {
+                vertexIterate(vertex, 1);
             }
         }
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            m_csr.vertexp(vertex)->rank(m_rank[vertex]);
+            m_csr.vertexp(vertex)->user(m_state[vertex]);
+        }
     }
 
-    void vertexIterate(V3GraphVertex* vertexp, uint32_t currentRank) {
+    void vertexIterate(Index vertex, uint32_t currentRank) {
         // Assign rank to each unvisited node
         // If larger rank is found, assign it and loop back through
         // If we hit a back node make a list of all loops
-        if (vertexp->user() == 1) {
+        if (m_state[vertex] == 1) {
+            V3GraphVertex* vertexp = m_csr.vertexp(vertex);
             m_graphp->reportLoops(m_edgeFuncp, vertexp);
             m_graphp->loopsMessageCb(vertexp);
             return;
         }
-        if (vertexp->rank() >= currentRank) return;  // Already processed it
-        vertexp->user(1);
-        vertexp->rank(currentRank);
-        for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep=edgep->outNextp()) {
-            if (followEdge(edgep)) {
-                vertexIterate(edgep->top(), currentRank + vertexp->rankAdder());
-            }
+        if (m_rank[vertex] >= currentRank) return;  // Already processed it
+        m_state[vertex] = 1;
+        m_rank[vertex] = currentRank;
+        uint32_t nextRank = currentRank + m_csr.vertexp(vertex)->rankAdder();
+        for (V3GraphCsr::EdgeIterator it = m_csr.outBegin(vertex);
+             it != m_csr.outEnd(vertex); ++it) {
+            vertexIterate(*it, nextRank);
         }
-        vertexp->user(2);
+        m_state[vertex] = 2;
     }
 public:
     GraphAlgRank(V3Graph* graphp, V3EdgeFuncP edgeFuncp)
-        : GraphAlg<>(graphp, edgeFuncp) {
+        : GraphAlg<>(graphp, edgeFuncp), m_csr(graphp, edgeFuncp) {
         main();
     }
     ~GraphAlgRank() {}
@@ -551,16 +562,61 @@ void V3Graph::order() {
     orderPreRanked();
 }
 
-void V3Graph::orderPreRanked() {
-    // Compute fanouts
-    // Vertex::m_user begin: 1 indicates processing, 2 indicates completed
-    userClearVertices();
-    for (V3GraphVertex* vertexp = verticesBeginp(); vertexp; vertexp=vertexp->verticesNextp()) {
-        if (!vertexp->user()) {
-            orderDFSIterate(vertexp);
+class GraphAlgOrderFanout : GraphAlg<> {
+private:
+    typedef V3GraphCsr::Index Index;
+    V3GraphCsr m_csr;  // Edges with weight
+    std::vector<double> m_fanout;  // Fanout of each vertex
+    std::vector<uint32_t> m_state;  // 1 indicates processing, 2 indicates completed
+
+    void main() {
+        // Compute fanouts
+        // Computed in m_fanout and m_state, then copied to the vertices
+        const Index size = m_csr.size();
+        m_fanout.resize(size, 0);
+        m_state.resize(size, 0);
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            if (!m_state[vertex]) {
+                vertexIterate(vertex);
+            }
+        }
+        for (Index vertex = 0; vertex < size; ++vertex) {
+            m_csr.vertexp(vertex)->fanout(m_fanout[vertex]);
+            m_csr.vertexp(vertex)->user(m_state[vertex]);
         }
     }
 
+    double vertexIterate(Index vertex) {
+        // Compute fanouts of each node
+        // If forward edge, don't double count that fanout
+        if (m_state[vertex] == 2) return m_fanout[vertex];  // Already processed it
+        UASSERT_OBJ(m_state[vertex] != 1, m_csr.vertexp(vertex),
+                    "Loop found, backward edges should be dead");
+        m_state[vertex] = 1;
+        double fanout = 0;
+        for (V3GraphCsr::EdgeIterator it = m_csr.outBegin(vertex);
+             it != m_csr.outEnd(vertex); ++it) {
+            fanout += vertexIterate(*it);
+        }
+        // Just count inbound edges
+        fanout += m_csr.inSize(vertex);
+        m_fanout[vertex] = fanout;
+        m_state[vertex] = 2;
+        return fanout;
+    }
+public:
+    explicit GraphAlgOrderFanout(V3Graph* graphp)
+        : GraphAlg<>(graphp, &V3GraphEdge::followAlwaysTrue)
+        , m_csr(graphp, &V3GraphEdge::followAlwaysTrue) {
+        main();
+    }
+    ~GraphAlgOrderFanout() {}
+};
+
+void V3Graph::orderPreRanked() {
+    // Compute fanouts
+    GraphAlgOrderFanout(this);
+
     // Sort list of vertices by rank, then fanout. Fanout is a bit of a
     // misnomer. It is the sum of all the fanouts of nodes reached from a node
     // *plus* the count of edges in to that node.
@@ -568,22 +624,3 @@ void V3Graph::orderPreRanked() {
     // Sort edges by rank then fanout of node they point to
     sortEdges();
 }
-
-double V3Graph::orderDFSIterate(V3GraphVertex* vertexp) {
-    // Compute fanouts of each node
-    // If forward edge, don't double count that fanout
-    if (vertexp->user() == 2) return vertexp->fanout();  // Already processed it
-    UASSERT_OBJ(vertexp->user() != 1, vertexp, "Loop found, backward edges should be dead");
-    vertexp->user(1);
-    double fanout = 0;
-    for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep = edgep->outNextp()) {
-        if (edgep->weight()) fanout += orderDFSIterate(edgep->m_top);
-    }
-    // Just count inbound edges
-    for (V3GraphEdge* edgep = vertexp->inBeginp(); edgep; edgep = edgep->inNextp()) {
-        if (edgep->weight()) fanout ++;
-    }
-    vertexp->fanout(fanout);
-    vertexp->user(2);
-    return vertexp->fanout();
-}
@@ -0,0 +1,55 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Graph compressed sparse row view
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Global.h"
+#include "V3GraphCsr.h"
+
+//######################################################################
+// V3GraphCsr class functions
+
+V3GraphCsr::V3GraphCsr(V3Graph* graphp, V3EdgeFuncP edgeFuncp) {
+    // Vertex::m_user begin: index of the vertex
+    Index vertices = 0;
+    size_t edges = 0;
+    for (V3GraphVertex* vertexp = graphp->verticesBeginp();
+         vertexp; vertexp=vertexp->verticesNextp()) {
+        vertexp->user(vertices++);
+        for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep=edgep->outNextp()) {
+            ++edges;
+        }
+    }
+    m_vertexps.reserve(vertices);
+    m_outBegins.reserve(vertices+1);
+    m_outTops.reserve(edges);  // Upper bound, as not all may be followed
+    m_inSizes.resize(vertices, 0);
+    for (V3GraphVertex* vertexp = graphp->verticesBeginp();
+         vertexp; vertexp=vertexp->verticesNextp()) {
+        m_vertexps.push_back(vertexp);
+        m_outBegins.push_back(static_cast<Index>(m_outTops.size()));
+        for (V3GraphEdge* edgep = vertexp->outBeginp(); edgep; edgep=edgep->outNextp()) {
+            if (edgep->weight() && (edgeFuncp)(edgep)) {
+                Index top = edgep->top()->user();
+                m_outTops.push_back(top);
+                ++m_inSizes[top];
+            }
+        }
+    }
+    m_outBegins.push_back(static_cast<Index>(m_outTops.size()));
+    // Vertex::m_user end, now unused
+}
@@ -0,0 +1,64 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Graph compressed sparse row view
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#ifndef _V3GRAPHCSR_H_
+#define _V3GRAPHCSR_H_ 1
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Error.h"
+#include "V3Graph.h"
+
+#include <vector>
+
+//######################################################################
+
+/// Frozen compressed sparse row view of the edges of a V3Graph that an
+/// algorithm follows (those with weight() and edgeFuncp true).
+/// Vertices are numbered in verticesBeginp() order, and each vertex's out
+/// edges are a contiguous run of indexes in the original edge order, so
+/// algorithms walk arrays instead of chasing list pointers, and keep their
+/// per-vertex state in vectors indexed the same way.
+///
+/// The graph must not change during the lifetime of the view.
+/// Constructing the view uses V3GraphVertex::user().
+class V3GraphCsr {
+public:
+    // TYPES
+    typedef uint32_t Index;
+    typedef std::vector<Index>::const_iterator EdgeIterator;
+private:
+    // MEMBERS
+    std::vector<V3GraphVertex*> m_vertexps;  // Vertex of each index
+    std::vector<Index> m_outBegins;  // Each vertex's first m_outTops entry, then total edges
+    std::vector<Index> m_outTops;  // Index of vertex each out edge goes to
+    std::vector<Index> m_inSizes;  // Number of in edges of each vertex
+public:
+    // CONSTRUCTORS
+    V3GraphCsr(V3Graph* graphp, V3EdgeFuncP edgeFuncp);
+    ~V3GraphCsr() {}
+    // ACCESSORS
+    Index size() const { return static_cast<Index>(m_vertexps.size()); }
+    V3GraphVertex* vertexp(Index index) const { return m_vertexps[index]; }
+    EdgeIterator outBegin(Index index) const { return m_outTops.begin()+m_outBegins[index]; }
+    EdgeIterator outEnd(Index index) const { return m_outTops.begin()+m_outBegins[index+1]; }
+    Index inSize(Index index) const { return m_inSizes[index]; }
+private:
+    VL_UNCOPYABLE(V3GraphCsr);
+};
+
+#endif  // Guard
@@ -17,7 +17,9 @@
 //
 //          Hash each node depth first
 //              Hash includes varp name and operator type, and constants
+//              Mix into a 64 bit key, so different trees rarely share a key
 //              Form lookup table based on hash of each statement  w/ nodep and next nodep
+//              Table is open addressed, so lookups are a few probes of one array
 //
 //*************************************************************************
 
@@ -42,44 +44,72 @@ class HashedVisitor : public AstNVisitor {
 private:
     // NODE STATE
     // Entire netlist:
-    //  AstNodeStmt::user4()    -> V3Hash.  Hash value of this node (hash of 0 is illegal)
+    //  AstNodeStmt::user4p()   -> V3Hashed::Key.  Hash key of this node (key of 0 is illegal)
     //AstUser4InUse     in V3Hashed.h
 
     // STATE
-    V3Hash              m_lowerHash;    // Hash of the statement we're building
-    bool                m_cacheInUser4; // Use user4 to cache each V3Hash?
+    vluint64_t          m_lowerHash;    // Hash of the statement we're building
+    uint32_t            m_lowerDepth;   // Number of nodes in the statement we're building
+    V3Hashed::Key       m_lastKey;      // Key of the last node hashed
+    bool                m_cacheInUser4; // Use user4 to cache each key?
 
     // METHODS
     VL_DEBUG_FUNC;  // Declare debug()
 
+    static vluint64_t mix(vluint64_t h) {
+        // MurmurHash3 finalizer; each input bit affects all output bits
+        h ^= h >> 33;
+        h *= VL_ULL(0xff51afd7ed558ccd);
+        h ^= h >> 33;
+        h *= VL_ULL(0xc4ceb9fe1a85ec53);
+        h ^= h >> 33;
+        return h;
+    }
+    static vluint64_t combine(vluint64_t seed, vluint64_t val) {
+        // Order dependant, so swapped children hash differently
+        return seed ^ (mix(val) + VL_ULL(0x9e3779b97f4a7c15) + (seed << 6) + (seed >> 2));
+    }
+    static V3Hashed::Key makeKey(uint32_t depth, vluint64_t hash) {
+        if (depth > 255) depth = 255;
+        return (hash << 8) | depth;
+    }
+
     void nodeHashIterate(AstNode* nodep) {
-        V3Hash thisHash;
-        if (!m_cacheInUser4 || !nodep->user4()) {
+        V3Hashed::Key thisKey = 0;
+        if (!m_cacheInUser4 || !nodep->user4p()) {
             UASSERT_OBJ(!(VN_IS(nodep->backp(), CFunc)
                           && !(VN_IS(nodep, NodeStmt) || VN_IS(nodep, CFunc))), nodep,
                         "Node "<<nodep->prettyTypeName()
                         <<" in statement position but not marked stmt (node under function)");
-            V3Hash oldHash = m_lowerHash;
+            vluint64_t oldHash = m_lowerHash;
+            uint32_t oldDepth = m_lowerDepth;
             {
-                m_lowerHash = nodep->sameHash();
-                UASSERT_OBJ(!m_lowerHash.isIllegal(), nodep,
+                V3Hash sameHash = nodep->sameHash();
+                UASSERT_OBJ(!sameHash.isIllegal(), nodep,
                             "sameHash function undefined (returns 0) for node under CFunc.");
                 // For identical nodes, the type should be the same thus
                 // dtypep should be the same too
-                m_lowerHash = V3Hash(m_lowerHash, V3Hash(nodep->type()<<6,
-                                                         V3Hash(nodep->dtypep())));
+                m_lowerHash = combine(combine(sameHash.fullValue(), nodep->type()),
+                                      reinterpret_cast<uintptr_t>(nodep->dtypep()));
+                m_lowerDepth = 1;
                 // Now update m_lowerHash for our children's (and next children) contributions
                 iterateChildren(nodep);
-                // Store the hash value
-                nodep->user4(m_lowerHash.fullValue());
-                //UINFO(9, "    hashnode "<<m_lowerHash<<"  "<<nodep<<endl);
+                thisKey = makeKey(m_lowerDepth, mix(m_lowerHash));
+                // Store the hash key
+                if (m_cacheInUser4) {
+                    nodep->user4p(reinterpret_cast<void*>(static_cast<uintptr_t>(thisKey)));
+                }
+                //UINFO(9, "    hashnode "<<V3Hashed::keyToHash(thisKey)<<"  "<<nodep<<endl);
             }
-            thisHash = m_lowerHash;
             m_lowerHash = oldHash;
+            m_lowerDepth = oldDepth;
         }
+        // As truncated on 32 bit hosts, always use the cached key if there is one
+        if (m_cacheInUser4) thisKey = V3Hashed::nodeKey(nodep);
         // Update what will become the above node's hash
-        m_lowerHash += m_cacheInUser4
-            ? V3Hashed::nodeHash(nodep) : thisHash;
+        m_lowerHash = combine(m_lowerHash, thisKey);
+        m_lowerDepth += static_cast<uint32_t>(thisKey & 255);
+        m_lastKey = thisKey;
     }
 
     //--------------------
@@ -93,30 +123,78 @@ private:
 
 public:
     // CONSTRUCTORS
-    explicit HashedVisitor(AstNode* nodep) {
+    explicit HashedVisitor(AstNode* nodep)
+        : m_lowerHash(0), m_lowerDepth(0), m_lastKey(0) {
         m_cacheInUser4 = true;
         nodeHashIterate(nodep);
         //UINFO(9,"  stmthash "<<hex<<V3Hashed::nodeHash(nodep)<<"  "<<nodep<<endl);
     }
-    explicit HashedVisitor(const AstNode* nodep) {
+    explicit HashedVisitor(const AstNode* nodep)
+        : m_lowerHash(0), m_lowerDepth(0), m_lastKey(0) {
         m_cacheInUser4 = false;
         nodeHashIterate(const_cast<AstNode*>(nodep));
     }
-    V3Hash finalHash() const { return m_lowerHash; }
+    V3Hashed::Key finalKey() const { return m_lastKey; }
     virtual ~HashedVisitor() {}
 };
 
 //######################################################################
 // Hashed class functions
 
+V3Hashed::~V3Hashed() {
+    if (m_statInserts != 0.0) {
+        V3Stats::addStatSum("Hashed, Nodes inserted", m_statInserts);
+        V3Stats::addStatSum("Hashed, Slot probes past first", m_statProbes);
+        V3Stats::addStatSum("Hashed, Same key but different tree", m_statFalseMatches);
+        V3Stats::addStatSum("Hashed, Table rebuilds", m_statResizes);
+    }
+}
+
 V3Hash V3Hashed::uncachedHash(const AstNode* nodep) {
     HashedVisitor visitor(nodep);
-    return visitor.finalHash();
+    return keyToHash(visitor.finalKey());
+}
+
+void V3Hashed::clear() {
+    SlotVec(16).swap(m_slots);  // Release, as may be reused for many small modules
+    m_used = 0;
+    m_size = 0;
+    AstNode::user4ClearTree();
+}
+
+void V3Hashed::rehash(size_t slots) {
+    ++m_statResizes;
+    SlotVec oldSlots (slots);
+    oldSlots.swap(m_slots);
+    for (SlotVec::const_iterator it = oldSlots.begin(); it != oldSlots.end(); ++it) {
+        if (!it->m_nodep) continue;
+        size_t index = firstSlot(it->m_key);
+        while (m_slots[index].m_nodep) index = nextSlot(index);
+        m_slots[index] = *it;
+    }
+    m_used = m_size;
 }
 
 V3Hashed::iterator V3Hashed::hashAndInsert(AstNode* nodep) {
     hash(nodep);
-    return m_hashMmap.insert(make_pair(nodeHash(nodep), nodep));
+    // Keep at least half the slots empty, so probes stay short
+    if ((m_used+1)*2 > m_slots.size()) {
+        // Grow if mostly holding nodes, else just drop the deleted slots
+        rehash((m_size+1)*4 > m_slots.size() ? m_slots.size()*2 : m_slots.size());
+    }
+    Key key = nodeKey(nodep);
+    size_t index = firstSlot(key);
+    while (m_slots[index].m_nodep) {
+        index = nextSlot(index);
+        ++m_statProbes;
+    }
+    Slot& slot = m_slots[index];
+    if (!slot.m_key) ++m_used;  // Else reusing a deleted slot
+    slot.m_key = key;
+    slot.m_nodep = nodep;
+    ++m_size;
+    ++m_statInserts;
+    return iterator(&m_slots, index);
 }
 
 void V3Hashed::hash(AstNode* nodep) {
@@ -129,21 +207,42 @@ void V3Hashed::hash(AstNode* nodep) {
 bool V3Hashed::sameNodes(AstNode* node1p, AstNode* node2p) {
     UASSERT_OBJ(node1p->user4p(), node1p, "Called isIdentical on non-hashed nodes");
     UASSERT_OBJ(node2p->user4p(), node2p, "Called isIdentical on non-hashed nodes");
-    return (node1p->user4p() == node2p->user4p()  // Same hash
-            && node1p->sameTree(node2p));
+    if (nodeKey(node1p) != nodeKey(node2p)) return false;  // Different hash
+    if (node1p->sameTree(node2p)) return true;
+    ++m_statFalseMatches;
+    return false;
 }
 
 void V3Hashed::erase(iterator it) {
     AstNode* nodep = iteratorNodep(it);
     UINFO(8,"   erase "<<nodep<<endl);
     UASSERT_OBJ(nodep->user4p(), nodep, "Called removeNode on non-hashed node");
-    m_hashMmap.erase(it);
+    m_slots[it.m_index].m_nodep = NULL;  // Keeping m_key marks the slot deleted
+    --m_size;
     nodep->user4p(NULL);  // So we don't allow removeNode again
 }
 
+V3Hashed::iterator V3Hashed::findFrom(Key key, size_t index) {
+    // Deleted slots don't end the probe, as key may have been inserted past them
+    for (;; index = nextSlot(index)) {
+        const Slot& slot = m_slots[index];
+        if (!slot.m_key) return end();
+        if (slot.m_nodep && slot.m_key == key) return iterator(&m_slots, index);
+        ++m_statProbes;
+    }
+}
+
+V3Hashed::iterator V3Hashed::findFirst(Key key) {
+    return findFrom(key, firstSlot(key));
+}
+
+V3Hashed::iterator V3Hashed::findNext(iterator it) {
+    return findFrom(it.key(), nextSlot(it.m_index));
+}
+
 void V3Hashed::check() {
-    for (HashMmap::iterator it = begin(); it != end(); ++it) {
-        AstNode* nodep = it->second;
+    for (iterator it = begin(); it != end(); ++it) {
+        AstNode* nodep = *it;
         UASSERT_OBJ(nodep->user4p(), nodep, "V3Hashed check failed, non-hashed node");
     }
 }
@@ -158,36 +257,29 @@ void V3Hashed::dumpFile(const string& filename, bool tree) {
     const vl_unique_ptr<std::ofstream> logp (V3File::new_ofstream(filename));
     if (logp->fail()) v3fatal("Can't write "<<filename);
 
-    std::map<int,int> dist;
+    // Sort by key, so equal keys dump together
+    typedef std::multimap<Key,AstNode*> SortedMmap;
+    SortedMmap sorted;
+    for (iterator it = begin(); it != end(); ++it) sorted.insert(make_pair(it.key(), *it));
 
-    V3Hash lasthash;
-    int num_in_bucket = 0;
-    for (HashMmap::iterator it=begin(); 1; ++it) {
-        if (it==end() || lasthash != it->first) {
-            if (it!=end()) lasthash = it->first;
-            if (num_in_bucket) {
-                if (dist.find(num_in_bucket)==dist.end()) {
-                    dist.insert(make_pair(num_in_bucket, 1));
-                } else {
-                    ++dist[num_in_bucket];
-                }
-            }
-            num_in_bucket = 0;
-        }
-        if (it==end()) break;
-        num_in_bucket++;
+    std::map<int,int> dist;
+    for (SortedMmap::iterator it = sorted.begin(); it != sorted.end();
+         it = sorted.upper_bound(it->first)) {
+        ++dist[static_cast<int>(sorted.count(it->first))];
     }
     *logp <<"\n*** STATS:\n"<<endl;
-    *logp<<"    #InBucket   Occurrences\n";
+    *logp<<"    Nodes "<<m_size<<" in "<<m_slots.size()<<" slots"<<endl;
+    *logp<<"\n    #InBucket   Occurrences\n";
     for (std::map<int,int>::iterator it=dist.begin(); it!=dist.end(); ++it) {
         *logp<<"    "<<std::setw(9)<<it->first<<"  "<<std::setw(12)<<it->second<<endl;
     }
 
     *logp <<"\n*** Dump:\n"<<endl;
-    for (HashMmap::iterator it=begin(); it!=end(); ++it) {
-        if (lasthash != it->first) {
-            lasthash = it->first;
-            *logp <<"    "<<it->first<<endl;
+    Key lastKey = 0;
+    for (SortedMmap::iterator it=sorted.begin(); it!=sorted.end(); ++it) {
+        if (lastKey != it->first) {
+            lastKey = it->first;
+            *logp <<"    "<<keyToHash(it->first)<<" "<<std::hex<<it->first<<std::dec<<endl;
         }
         *logp <<"\t"<<it->second<<endl;
         // Dumping the entire tree may make nearly N^2 sized dumps,
@@ -199,10 +291,8 @@ void V3Hashed::dumpFile(const string& filename, bool tree) {
 V3Hashed::iterator V3Hashed::findDuplicate(AstNode* nodep, V3HashedUserSame* checkp) {
     UINFO(8,"   findD "<<nodep<<endl);
     UASSERT_OBJ(nodep->user4p(), nodep, "Called findDuplicate on non-hashed node");
-    std::pair<HashMmap::iterator,HashMmap::iterator> eqrange
-        = mmap().equal_range(nodeHash(nodep));
-    for (HashMmap::iterator eqit = eqrange.first; eqit != eqrange.second; ++eqit) {
-        AstNode* node2p = eqit->second;
+    for (iterator eqit = findFirst(nodeKey(nodep)); eqit != end(); eqit = findNext(eqit)) {
+        AstNode* node2p = *eqit;
         if (nodep != node2p
             && (!checkp || checkp->isSame(nodep, node2p))
             && sameNodes(nodep, node2p)) {
@@ -21,6 +21,9 @@
 
 #include "V3Error.h"
 #include "V3Ast.h"
+#include "V3Stats.h"
+
+#include <vector>
 
 //============================================================================
 
@@ -45,40 +48,92 @@ struct V3HashedUserSame {
 
 class V3Hashed : public VHashedBase {
     // NODE STATE
-    //  AstNode::user4()        -> V3Hash.  Hash value of this node (hash of 0 is illegal)
+    //  AstNode::user4p()       -> Key.  Hash key of this node (key of 0 is illegal)
     AstUser4InUse m_inuser4;
 
     // TYPES
 public:
-    typedef std::multimap<V3Hash,AstNode*> HashMmap;
-    typedef HashMmap::iterator iterator;
+    // Structural hash of a tree: 8 bits with the number of nodes in the
+    // tree, then 56 bits of hash.  Cached in user4p, so on 32 bit hosts
+    // only the low 24 bits of hash are kept, as with V3Hash.
+    typedef vluint64_t Key;
+private:
+    struct Slot {
+        Key m_key;  // Hash key; if m_nodep is NULL, 0 = empty slot, else deleted
+        AstNode* m_nodep;  // Node inserted, or NULL
+        Slot() : m_key(0), m_nodep(NULL) {}
+    };
+    typedef std::vector<Slot> SlotVec;
+public:
+    class iterator {
+        // Iterator over the inserted nodes.  Any insertion invalidates it.
+        friend class V3Hashed;
+        const SlotVec* m_slotsp;  // Table being iterated
+        size_t m_index;  // Index of the slot in m_slotsp, or size() at end
+        iterator(const SlotVec* slotsp, size_t index) : m_slotsp(slotsp), m_index(index) {}
+        void skipEmpty() {
+            while (m_index < m_slotsp->size() && !(*m_slotsp)[m_index].m_nodep) ++m_index;
+        }
+    public:
+        iterator() : m_slotsp(NULL), m_index(0) {}
+        AstNode* operator*() const { return (*m_slotsp)[m_index].m_nodep; }
+        Key key() const { return (*m_slotsp)[m_index].m_key; }
+        iterator& operator++() { ++m_index; skipEmpty(); return *this; }
+        bool operator==(const iterator& rh) const { return m_index == rh.m_index; }
+        bool operator!=(const iterator& rh) const { return m_index != rh.m_index; }
+    };
 private:
     // MEMBERS
-    HashMmap m_hashMmap;  // hashvalue -> nodes with that hash
+    SlotVec m_slots;  // Open addressed table, linear probing, power of two sized
+    size_t m_used;  // Number of slots not empty, including deleted slots
+    size_t m_size;  // Number of nodes inserted
+    // Statistics, published to V3Stats when destroyed
+    VDouble0 m_statInserts;  // Nodes inserted
+    VDouble0 m_statProbes;  // Slots looked at past each key's first slot
+    VDouble0 m_statFalseMatches;  // Same key, but not the same tree
+    VDouble0 m_statResizes;  // Table grown or rebuilt
+
+    // METHODS
+    size_t firstSlot(Key key) const {
+        return static_cast<size_t>(key >> 8) & (m_slots.size()-1);
+    }
+    size_t nextSlot(size_t index) const { return (index+1) & (m_slots.size()-1); }
+    iterator findFrom(Key key, size_t index);  // Probe for key starting at index
+    void rehash(size_t slots);  // Rebuild table with given number of slots
 
 public:
     // CONSTRUCTORS
-    V3Hashed() { clear(); }
-    ~V3Hashed() {}
+    V3Hashed() : m_used(0), m_size(0) { clear(); }
+    ~V3Hashed();
 
     // ACCESSORS
-    HashMmap& mmap() { return m_hashMmap; }  // Return map for iteration
-    iterator begin() { return m_hashMmap.begin(); }
-    iterator end() { return m_hashMmap.end(); }
+    iterator begin() const { iterator it (&m_slots, 0); it.skipEmpty(); return it; }
+    iterator end() const { return iterator(&m_slots, m_slots.size()); }
+    size_t size() const { return m_size; }
 
     // METHODS
-    void clear() { m_hashMmap.clear(); AstNode::user4ClearTree(); }
+    void clear();
     void check();  // Check assertions on structure
     iterator hashAndInsert(AstNode* nodep);  // Hash the node, and insert into map. Return iterator to inserted
     void hash(AstNode* nodep);  // Only hash the node
     bool sameNodes(AstNode* node1p, AstNode* node2p);  // After hashing, and tell if identical
     void erase(iterator it);  // Remove node from structures
+    // First/next inserted node with the given key, or end()
+    iterator findFirst(Key key);
+    iterator findNext(iterator it);
     // Return duplicate in hash, if any, with optional user check for sameness
     iterator findDuplicate(AstNode* nodep, V3HashedUserSame* checkp=NULL);
-    AstNode* iteratorNodep(iterator it) { return it->second; }
+    AstNode* iteratorNodep(iterator it) { return *it; }
     void dumpFile(const string& filename, bool tree);
     void dumpFilePrefixed(const string& nameComment, bool tree=false);
-    static V3Hash nodeHash(AstNode* nodep) { return V3Hash(nodep->user4p()); }
+    static Key nodeKey(AstNode* nodep) {
+        return static_cast<Key>(reinterpret_cast<uintptr_t>(nodep->user4p()));
+    }
+    static V3Hash nodeHash(AstNode* nodep) { return keyToHash(nodeKey(nodep)); }
+    static V3Hash keyToHash(Key key) {
+        return V3Hash(V3Hash::FullValue(),
+                      static_cast<uint32_t>(((key & 255) << 24) | ((key >> 8) & 0xffffff)));
+    }
     // Hash of the nodep tree, without caching in user4.
     static V3Hash uncachedHash(const AstNode* nodep);
 };
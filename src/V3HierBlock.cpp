@@ -0,0 +1,288 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Hierarchical Verilation of hier_block modules
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+// V3HierBlock's Transformations:
+//
+//  With --hierarchical, after parameters are resolved:
+//      Find the modules marked /*verilator hier_block*/, and for each
+//      the nearest hier blocks instantiated below it.
+//      For each hier block, write a -f file to Verilate just that module
+//      with --protect-lib into its own directory, treating the hier
+//      blocks below it as already Verilated (--hierarchical-block).
+//      Write a -f file to Verilate the top the same way, linking all of
+//      the hier block libraries.
+//      Write a makefile running all of these, then run it; make runs
+//      independent blocks in parallel, and --skip-identical reuses
+//      blocks whose sources are unchanged.
+//
+//*************************************************************************
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Global.h"
+#include "V3HierBlock.h"
+#include "V3File.h"
+#include "V3Os.h"
+#include "V3Parallel.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+//######################################################################
+
+class HierBlockVisitor : public AstNVisitor {
+public:
+    // TYPES
+    typedef std::vector<AstNodeModule*> ModVec;
+private:
+    typedef std::map<AstNodeModule*,ModVec> BelowMap;
+    // STATE
+    BelowMap m_below;  // Nearest hier blocks under each module visited
+    ModVec* m_belowp;  // m_below entry of module being visited
+    // METHODS
+    static void addUnique(ModVec& mods, AstNodeModule* modp) {
+        if (std::find(mods.begin(), mods.end(), modp) == mods.end()) mods.push_back(modp);
+    }
+    // VISITORS
+    virtual void visit(AstNodeModule* nodep) VL_OVERRIDE {
+        if (m_below.find(nodep) != m_below.end()) return;  // Already done
+        ModVec* lastBelowp = m_belowp;
+        m_belowp = &m_below[nodep];
+        iterateChildren(nodep);
+        m_belowp = lastBelowp;
+    }
+    virtual void visit(AstCell* nodep) VL_OVERRIDE {
+        AstNodeModule* modp = nodep->modp();
+        if (!modp) return;
+        iterate(modp);
+        if (modp->hierBlock()) {
+            if (modp->name() != modp->origName()) {
+                nodep->v3error("Unsupported: --hierarchical block with parameter overrides: "
+                               <<modp->prettyNameQ());
+            }
+            addUnique(*m_belowp, modp);
+        } else {
+            const ModVec& below = m_below[modp];
+            for (ModVec::const_iterator it = below.begin(); it != below.end(); ++it) {
+                addUnique(*m_belowp, *it);
+            }
+        }
+    }
+    virtual void visit(AstNodeMath*) VL_OVERRIDE {}  // Accelerate
+    virtual void visit(AstNode* nodep) VL_OVERRIDE { iterateChildren(nodep); }
+public:
+    // CONSTRUCTORS
+    explicit HierBlockVisitor(AstNodeModule* topp)
+        : m_belowp(NULL) {
+        iterate(topp);
+    }
+    virtual ~HierBlockVisitor() {}
+    // ACCESSORS
+    const ModVec& below(AstNodeModule* modp) { return m_below[modp]; }
+};
+
+//######################################################################
+
+class HierBlockEmitter {
+    // TYPES
+    typedef HierBlockVisitor::ModVec ModVec;
+    typedef std::vector<string> ArgList;
+    // STATE
+    HierBlockVisitor& m_blocks;  // Hierarchy of hier blocks
+    AstNodeModule* m_topp;  // Top module
+    ModVec m_order;  // Hier blocks, each before the blocks under it
+    std::map<AstNodeModule*,bool> m_done;  // Hier blocks added to m_order
+    // METHODS
+    void addOrder(AstNodeModule* modp) {
+        // Post order, so reversed each block is before all blocks under it,
+        // as the static libraries must be linked in that order
+        if (m_done[modp]) return;
+        m_done[modp] = true;
+        const ModVec& below = m_blocks.below(modp);
+        for (ModVec::const_iterator it = below.begin(); it != below.end(); ++it) addOrder(*it);
+        m_order.push_back(modp);
+    }
+    static string prefix(AstNodeModule* modp) { return "V"+modp->prettyName(); }
+    static string blockDir(AstNodeModule* modp) {
+        return v3Global.opt.makeDir()+"/"+prefix(modp);
+    }
+    static string argsFilename(AstNodeModule* modp) {
+        return blockDir(modp)+"/"+prefix(modp)+"__hierArgs.f";
+    }
+    static string topArgsFilename() {
+        return v3Global.opt.makeDir()+"/"+v3Global.opt.prefix()+"__hierArgs.f";
+    }
+    static string wrapperFilename(AstNodeModule* modp) {
+        return blockDir(modp)+"/"+V3HierBlock::wrapperName(modp->prettyName())+".sv";
+    }
+    static string libFilename(AstNodeModule* modp) {
+        // Absolute, as the top's model is built from inside the --Mdir
+        return V3Os::filenameRealPath(blockDir(modp))
+            +"/lib"+V3HierBlock::wrapperName(modp->prettyName())+".a";
+    }
+    static string targetName(AstNodeModule* modp) { return "hier_"+modp->prettyName(); }
+    static string quoteArg(const string& arg) {
+        // Quote as needed for reading back by -f
+        if (arg.find_first_of(" \t\n\"\\'") == string::npos) return arg;
+        string out = "\"";
+        for (string::const_iterator pos = arg.begin(); pos != arg.end(); ++pos) {
+            if (*pos == '"' || *pos == '\\') out += '\\';
+            out += *pos;
+        }
+        return out+"\"";
+    }
+    void addBelowArgs(ArgList& args, AstNodeModule* modp) {
+        // Use the wrapper of each hier block below rather than its sources
+        const ModVec& below = m_blocks.below(modp);
+        for (ModVec::const_iterator it = below.begin(); it != below.end(); ++it) {
+            args.push_back("--hierarchical-block");
+            args.push_back((*it)->prettyName());
+            args.push_back(wrapperFilename(*it));
+        }
+    }
+    static void writeArgsFile(const string& filename, const ArgList& args) {
+        std::ostringstream os;
+        os<<"// Verilated -*- Verilog-arguments -*-\n";
+        os<<"// DESCR" "IPTION: Verilator output: Arguments for --hierarchical child run\n";
+        for (ArgList::const_iterator it = args.begin(); it != args.end(); ++it) {
+            os<<quoteArg(*it)<<"\n";
+        }
+        // Only write if changed, so --skip-identical in the child run can
+        // tell nothing changed
+        {
+            std::ifstream is (filename.c_str());
+            std::ostringstream oldos;
+            oldos<<is.rdbuf();
+            if (is.good() && oldos.str() == os.str()) return;
+        }
+        const vl_unique_ptr<std::ofstream> ofp (V3File::new_ofstream_nodepend(filename));
+        if (ofp->fail()) v3fatal("Can't write "<<filename);
+        *ofp<<os.str();
+    }
+    void emitBlockArgs(AstNodeModule* modp) {
+        V3Os::createDir(blockDir(modp));
+        ArgList args (v3Global.opt.cmdArgs());
+        args.push_back("--no-hierarchical");
+        args.push_back("--hierarchical-child");
+        args.push_back("--no-exe");
+        args.push_back("--top-module");
+        args.push_back(modp->prettyName());
+        args.push_back("--prefix");
+        args.push_back(prefix(modp));
+        args.push_back("-Mdir");
+        args.push_back(blockDir(modp));
+        args.push_back("--protect-lib");
+        args.push_back(V3HierBlock::wrapperName(modp->prettyName()));
+        addBelowArgs(args, modp);
+        writeArgsFile(argsFilename(modp), args);
+    }
+    void emitTopArgs() {
+        ArgList args (v3Global.opt.cmdArgs());
+        args.push_back("--no-hierarchical");
+        args.push_back("--top-module");
+        args.push_back(m_topp->prettyName());
+        addBelowArgs(args, m_topp);
+        for (ModVec::const_iterator it = m_order.begin(); it != m_order.end(); ++it) {
+            args.push_back(libFilename(*it));
+        }
+        writeArgsFile(topArgsFilename(), args);
+    }
+    void emitMk(const string& filename) {
+        V3OutMkFile of (filename);
+        of.putsHeader();
+        of.puts("# DESCR" "IPTION: Verilator output: Makefile for --hierarchical Verilation\n");
+        of.puts("#\n");
+        of.puts("# Verilator runs this makefile itself; hier blocks that don't depend\n");
+        of.puts("# on each other are Verilated in parallel, see --verilate-jobs.\n");
+        of.puts("\n");
+        of.puts("default: "+targetName(m_topp)+"\n");
+        of.puts("\n");
+        of.puts("# Verilator executable (from this run)\n");
+        of.puts("VM_HIER_VERILATOR = "+v3Global.opt.bin()+"\n");
+        for (ModVec::const_reverse_iterator it = m_order.rbegin(); it != m_order.rend(); ++it) {
+            AstNodeModule* modp = *it;
+            of.puts("\n");
+            of.puts(targetName(modp)+":");
+            const ModVec& below = m_blocks.below(modp);
+            for (ModVec::const_iterator bit = below.begin(); bit != below.end(); ++bit) {
+                of.puts(" "+targetName(*bit));
+            }
+            of.puts("\n");
+            of.puts("\t$(VM_HIER_VERILATOR) -f "+argsFilename(modp)+"\n");
+            of.puts("\t$(MAKE) -C "+blockDir(modp)+" -f "+prefix(modp)+".mk\n");
+        }
+        of.puts("\n");
+        of.puts(targetName(m_topp)+":");
+        const ModVec& below = m_blocks.below(m_topp);
+        for (ModVec::const_iterator it = below.begin(); it != below.end(); ++it) {
+            of.puts(" "+targetName(*it));
+        }
+        of.puts("\n");
+        of.puts("\t$(VM_HIER_VERILATOR) -f "+topArgsFilename()+"\n");
+        of.puts("\n");
+        of.puts(".PHONY: default "+targetName(m_topp));
+        for (ModVec::const_iterator it = m_order.begin(); it != m_order.end(); ++it) {
+            of.puts(" "+targetName(*it));
+        }
+        of.puts("\n");
+        of.puts("\n");
+        of.putsHeader();
+    }
+public:
+    // CONSTRUCTORS
+    HierBlockEmitter(HierBlockVisitor& blocks, AstNodeModule* topp)
+        : m_blocks(blocks), m_topp(topp) {
+        const ModVec& below = m_blocks.below(m_topp);
+        for (ModVec::const_iterator it = below.begin(); it != below.end(); ++it) addOrder(*it);
+        std::reverse(m_order.begin(), m_order.end());
+    }
+    // METHODS
+    bool empty() const { return m_order.empty(); }
+    void emit(const string& mkFilename) {
+        V3File::createMakeDir();
+        for (ModVec::const_iterator it = m_order.begin(); it != m_order.end(); ++it) {
+            emitBlockArgs(*it);
+        }
+        emitTopArgs();
+        emitMk(mkFilename);
+    }
+};
+
+//######################################################################
+// HierBlock class functions
+
+bool V3HierBlock::verilate(AstNetlist* rootp) {
+    UINFO(2,__FUNCTION__<<": "<<endl);
+    AstNodeModule* topp = rootp->topModulep();
+    if (!topp) return false;
+    HierBlockVisitor blocks (topp);
+    V3Error::abortIfErrors();
+    HierBlockEmitter emitter (blocks, topp);
+    if (emitter.empty()) return false;
+
+    const string mkFilename = v3Global.opt.makeDir()+"/"+v3Global.opt.prefix()+"__hier.mk";
+    emitter.emit(mkFilename);
+    const string cmd = V3Os::getenvStr("MAKE", "make")+" -j "+cvtToStr(V3Parallel::jobs())
+        +" -f "+mkFilename;
+    if (V3Os::system(cmd) != 0) {
+        v3fatal("--hierarchical child Verilation failed: "<<cmd);
+    }
+    return true;
+}
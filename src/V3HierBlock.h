@@ -0,0 +1,37 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Hierarchical Verilation of hier_block modules
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#ifndef _V3HIERBLOCK_H_
+#define _V3HIERBLOCK_H_ 1
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Error.h"
+#include "V3Ast.h"
+
+//============================================================================
+
+class V3HierBlock {
+public:
+    // Name of the --protect-lib wrapper module made for a hier block
+    static string wrapperName(const string& modName) { return modName+"_Vhier"; }
+    // Verilate each hier block, then the top against their libraries,
+    // all in child runs.  Return false if there are no hier blocks.
+    static bool verilate(AstNetlist* rootp);
+};
+
+#endif  // Guard
@@ -28,6 +28,7 @@
 
 #include "V3Global.h"
 #include "V3LinkCells.h"
+#include "V3HierBlock.h"
 #include "V3SymTable.h"
 #include "V3Parse.h"
 #include "V3Ast.h"
@@ -289,6 +290,10 @@ private:
             UINFO(4,"Link Cell: "<<nodep<<endl);
             // Use findIdFallback instead of findIdFlat; it doesn't matter for now
             // but we might support modules-under-modules someday.
+            if (v3Global.opt.isHierBlock(nodep->modName())) {
+                // Already Verilated by --hierarchical, use its --protect-lib wrapper
+                nodep->modName(V3HierBlock::wrapperName(nodep->modName()));
+            }
             AstNodeModule* cellmodp = resolveModule(nodep, nodep->modName());
             if (cellmodp) {
                 if (cellmodp == m_modp
@@ -330,7 +335,12 @@ private:
                 else {  // Non-recursive
                     // Track module depths, so can sort list from parent down to children
                     nodep->modp(cellmodp);
-                    new V3GraphEdge(&m_graph, vertex(m_modp), vertex(cellmodp), 1, false);
+                    // A --hierarchical block is instantiated by parents that its
+                    // child run doesn't Verilate; they must not put it below the top
+                    if (!(v3Global.opt.hierChild()
+                          && v3Global.opt.topModule() == cellmodp->prettyName())) {
+                        new V3GraphEdge(&m_graph, vertex(m_modp), vertex(cellmodp), 1, false);
+                    }
                 }
             }
         }
@@ -245,6 +245,11 @@ private:
             m_modp->modPublic(true);
             nodep->unlinkFrBack(); VL_DO_DANGLING(pushDeletep(nodep), nodep);
         }
+        else if (nodep->pragType() == AstPragmaType::HIER_BLOCK) {
+            UASSERT_OBJ(m_modp, nodep, "HIER_BLOCK not under a module");
+            m_modp->hierBlock(true);
+            nodep->unlinkFrBack(); VL_DO_DANGLING(pushDeletep(nodep), nodep);
+        }
         else if (nodep->pragType() == AstPragmaType::PUBLIC_TASK) {
             UASSERT_OBJ(m_ftaskp, nodep, "PUBLIC_TASK not under a task");
             m_ftaskp->taskPublic(true);
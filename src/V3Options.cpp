@@ -210,6 +210,9 @@ void V3Options::addFuture(const string& flag) {
 bool V3Options::isFuture(const string& flag) const {
     return m_futures.find(flag) != m_futures.end();
 }
+bool V3Options::isHierBlock(const string& modname) const {
+    return m_hierBlocks.find(modname) != m_hierBlocks.end();
+}
 bool V3Options::isLibraryFile(const string& filename) const {
     return m_libraryFiles.find(filename) != m_libraryFiles.end();
 }
@@ -623,6 +626,7 @@ string V3Options::argString(int argc, char** argv) {
 void V3Options::parseOpts(FileLine* fl, int argc, char** argv) {
     // Parse all options
     // Initial entry point from Verilator.cpp
+    for (int i=0; i<argc; ++i) m_cmdArgs.push_back(argv[i]);
     parseOptsList(fl, ".", argc, argv);
 
     // Default certain options and error check
@@ -741,6 +745,7 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if ( onoff (sw, "-cdc", flag/*ref*/))          { m_cdc = flag; }
             else if ( onoff (sw, "-coverage", flag/*ref*/))     { coverage(flag); }
             else if ( onoff (sw, "-coverage-line", flag/*ref*/)){ m_coverageLine = flag; }
+            else if ( onoff (sw, "-coverage-per-thread", flag/*ref*/)){ m_coveragePerThread = flag; }
             else if ( onoff (sw, "-coverage-toggle", flag/*ref*/)){ m_coverageToggle = flag; }
             else if ( onoff (sw, "-coverage-underscore", flag/*ref*/)){ m_coverageUnderscore = flag; }
             else if ( onoff (sw, "-coverage-user", flag/*ref*/)){ m_coverageUser = flag; }
@@ -760,6 +765,8 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if ( onoff (sw, "-dump-defines", flag/*ref*/)) { m_dumpDefines = flag; }
             else if ( onoff (sw, "-dump-tree", flag/*ref*/))    { m_dumpTree = flag ? 3 : 0; }  // Also see --dump-treei
             else if ( onoff (sw, "-exe", flag/*ref*/))          { m_exe = flag; }
+            else if ( onoff (sw, "-hierarchical", flag/*ref*/)) { m_hierarchical = flag; }
+            else if ( onoff (sw, "-hierarchical-child", flag/*ref*/)) { m_hierChild = flag; }  // Undocumented, used by --hierarchical
             else if ( onoff (sw, "-ignc", flag/*ref*/))         { m_ignc = flag; }
             else if ( onoff (sw, "-inhibit-sim", flag/*ref*/))  { m_inhibitSim = flag; }
             else if ( onoff (sw, "-lint-only", flag/*ref*/))    { m_lintOnly = flag; }
@@ -773,6 +780,7 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if (!strcmp(sw, "-private"))                   { m_public = false; }
             else if ( onoff (sw, "-prof-cfuncs", flag/*ref*/))       { m_profCFuncs = flag; }
             else if ( onoff (sw, "-profile-cfuncs", flag/*ref*/))    { m_profCFuncs = flag; }  // Undocumented, for backward compat
+            else if ( onoff (sw, "-prof-settle", flag/*ref*/))       { m_profSettle = flag; }
             else if ( onoff (sw, "-prof-threads", flag/*ref*/))      { m_profThreads = flag; }
             else if ( onoff (sw, "-protect-ids", flag/*ref*/))       { m_protectIds = flag; }
             else if ( onoff (sw, "-public", flag/*ref*/))            { m_public = flag; }
@@ -790,6 +798,7 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if ( onoff (sw, "-structs-unpacked", flag/*ref*/))  { m_structsPacked = flag; }
             else if (!strcmp(sw, "-sv"))                             { m_defaultLanguage = V3LangCode::L1800_2005; }
             else if ( onoff (sw, "-threads-coarsen", flag/*ref*/))   { m_threadsCoarsen = flag; }  // Undocumented, debug
+            else if ( onoff (sw, "-threads-fast-contract", flag/*ref*/)) { m_threadsFastContract = flag; }
             else if ( onoff (sw, "-trace", flag/*ref*/))             { m_trace = flag; }
             else if ( onoff (sw, "-trace-coverage", flag/*ref*/))    { m_traceCoverage = flag; }
             else if ( onoff (sw, "-trace-dups", flag/*ref*/))        { m_traceDups = flag; }
@@ -947,6 +956,9 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if (!strcmp(sw, "-no-l2name")) {  // Historical and undocumented
                 m_l2Name = "";
             }
+            else if (!strcmp(sw, "-hierarchical-block") && (i+1)<argc) {  // Undocumented, used by --hierarchical
+                shift; m_hierBlocks.insert(argv[i]);
+            }
             else if ((!strcmp(sw, "-language") && (i+1)<argc)
                      || (!strcmp(sw, "-default-language") && (i+1)<argc)) {
                 shift;
@@ -994,6 +1006,35 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
                 m_traceFormat = TraceFormat::FST_THREAD;
                 addLdLibs("-lz");
             }
+            else if (!strcmp(sw, "-trace-raw")) {
+                m_trace = true;
+                m_traceFormat = TraceFormat::RAW;
+            }
+            else if (!strcmp(sw, "-trace-vcd-thread")) {
+                m_trace = true;
+                m_traceFormat = TraceFormat::VCD_THREAD;
+            }
+            else if (!strcmp(sw, "-table-max-bytes") && (i+1)<argc) {
+                shift;
+                m_tableMaxBytes = atoi(argv[i]);
+                if (m_tableMaxBytes < 1) {
+                    fl->v3fatal("--table-max-bytes must be >= 1: "<<argv[i]);
+                }
+            }
+            else if (!strcmp(sw, "-table-min-nodes") && (i+1)<argc) {
+                shift;
+                m_tableMinNodes = atoi(argv[i]);
+                if (m_tableMinNodes < 0) {
+                    fl->v3fatal("--table-min-nodes must be >= 0: "<<argv[i]);
+                }
+            }
+            else if (!strcmp(sw, "-table-split-inputs") && (i+1)<argc) {
+                shift;
+                m_tableSplitInputs = atoi(argv[i]);
+                if (m_tableSplitInputs < 0 || m_tableSplitInputs > 24) {
+                    fl->v3fatal("--table-split-inputs must be 0 to 24: "<<argv[i]);
+                }
+            }
             else if (!strcmp(sw, "-trace-depth") && (i+1)<argc) {
                 shift;
                 m_traceDepth = atoi(argv[i]);
@@ -1006,6 +1047,10 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
                 shift;
                 m_traceMaxWidth = atoi(argv[i]);
             }
+            else if (!strcmp(sw, "-trace-parallel-stmts") && (i+1)<argc) {
+                shift;
+                m_traceParallelStmts = atoi(argv[i]);
+            }
             else if (!strncmp (sw, "-U", 2)) {
                 V3PreShell::undef(string(sw+strlen("-U")));
             }
@@ -1101,6 +1146,9 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
             else if (!strcmp(sw, "-bin") && (i+1)<argc) {
                 shift; m_bin = argv[i];
             }
+            else if (!strcmp(sw, "-cache-dir") && (i+1)<argc) {
+                shift; m_cacheDir = argv[i];
+            }
             else if (!strcmp(sw, "-compiler") && (i+1)<argc) {
                 shift;
                 if (!strcmp(argv[i], "clang")) {
@@ -1153,6 +1201,9 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
                 shift; m_prefix = argv[i];
                 if (m_modPrefix=="") m_modPrefix = m_prefix;
             }
+            else if (!strcmp(sw, "-profile-guided-threads") && (i+1)<argc) {
+                shift; m_profileGuidedThreads = argv[i];
+            }
             else if (!strcmp(sw, "-protect-key") && (i+1)<argc) {
                 shift; m_protectKey = argv[i];
             }
@@ -1178,12 +1229,26 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc, char
                 if (m_threadsMaxMTasks < 1)
                     fl->v3fatal("--threads-max-mtasks must be >= 1: "<<argv[i]);
             }
+            else if (!strcmp(sw, "-threads-schedule") && (i+1)<argc) {
+                shift;
+                if (!strcmp(argv[i], "static")) {
+                    m_threadsDynamic = false;
+                } else if (!strcmp(argv[i], "dynamic")) {
+                    m_threadsDynamic = true;
+                } else {
+                    fl->v3fatal("Unknown setting for --threads-schedule: "<<argv[i]);
+                }
+            }
             else if (!strcmp(sw, "-top-module") && (i+1)<argc) {
                 shift; m_topModule = argv[i];
             }
             else if (!strcmp(sw, "-unused-regexp") && (i+1)<argc) {
                 shift; m_unusedRegexp = argv[i];
             }
+            else if (!strcmp(sw, "-verilate-jobs") && (i+1)<argc) {
+                shift; m_verilateJobs = atoi(argv[i]);
+                if (m_verilateJobs < 0) fl->v3fatal("--verilate-jobs must be >= 0: "<<argv[i]);
+            }
             else if (!strcmp(sw, "-x-assign") && (i+1)<argc) {
                 shift;
                 if (!strcmp(argv[i], "0")) { m_xAssign = "0"; }
@@ -1451,6 +1516,7 @@ V3Options::V3Options() {
     m_cmake = false;
     m_context = true;
     m_coverageLine = false;
+    m_coveragePerThread = false;
     m_coverageToggle = false;
     m_coverageUnderscore = false;
     m_coverageUser = false;
@@ -1469,6 +1535,8 @@ V3Options::V3Options() {
     m_inhibitSim = false;
     m_lintOnly = false;
     m_gmake = false;
+    m_hierarchical = false;
+    m_hierChild = false;
     m_makePhony = false;
     m_orderClockDly = true;
     m_outFormatOk = false;
@@ -1479,6 +1547,7 @@ V3Options::V3Options() {
     m_pinsUint8 = false;
     m_ppComments = false;
     m_profCFuncs = false;
+    m_profSettle = false;
     m_profThreads = false;
     m_protectIds = false;
     m_preprocOnly = false;
@@ -1497,7 +1566,9 @@ V3Options::V3Options() {
     m_threads = 0;
     m_threadsDpiPure = true;
     m_threadsDpiUnpure = false;
+    m_threadsDynamic = false;
     m_threadsCoarsen = true;
+    m_threadsFastContract = false;
     m_threadsMaxMTasks = 0;
     m_trace = false;
     m_traceCoverage = false;
@@ -1521,11 +1592,16 @@ V3Options::V3Options() {
     m_outputSplit = 0;
     m_outputSplitCFuncs = 0;
     m_outputSplitCTrace = 0;
+    m_tableMaxBytes = 1024*1024;  // Better be lots of instructions to be worth it!
+    m_tableMinNodes = 32;
+    m_tableSplitInputs = 0;
     m_traceDepth = 0;
     m_traceMaxArray = 32;
     m_traceMaxWidth = 256;
+    m_traceParallelStmts = 5000;
     m_unrollCount = 64;
     m_unrollStmts = 30000;
+    m_verilateJobs = 1;
 
     m_compLimitBlocks = 0;
     m_compLimitMembers = 64;
@@ -1533,6 +1609,7 @@ V3Options::V3Options() {
 
     m_makeDir = "obj_dir";
     m_bin = "";
+    m_cacheDir = "";
     m_flags = "";
     m_l2Name = "";
     m_unusedRegexp = "*unused*";
@@ -75,18 +75,23 @@ public:
     enum en {
         VCD = 0,
         FST,
-        FST_THREAD
+        FST_THREAD,
+        VCD_THREAD,
+        RAW
     } m_e;
     inline TraceFormat(en _e = VCD) : m_e(_e) {}
     explicit inline TraceFormat(int _e) : m_e(static_cast<en>(_e)) {}
     operator en() const { return m_e; }
     bool fstFlavor() const { return m_e == FST || m_e == FST_THREAD; }
-    bool threaded() const { return m_e == FST_THREAD; }
+    bool vcdFlavor() const { return m_e == VCD || m_e == VCD_THREAD; }
+    bool threaded() const { return m_e == FST_THREAD || m_e == VCD_THREAD; }
     string classBase() const {
         static const char* const names[] = {
             "VerilatedVcd",
             "VerilatedFst",
-            "VerilatedFst"
+            "VerilatedFst",
+            "VerilatedVcd",
+            "VerilatedRaw"
         };
         return names[m_e];
     }
@@ -94,7 +99,9 @@ public:
         static const char* const names[] = {
             "verilated_vcd",
             "verilated_fst",
-            "verilated_fst"
+            "verilated_fst",
+            "verilated_vcd",
+            "verilated_raw"
         };
         return names[m_e];
     }
@@ -130,6 +137,8 @@ class V3Options {
     V3StringSet m_noClockers;   // argument: Verilog -noclk signals
     V3StringList m_vFiles;      // argument: Verilog files to read
     V3StringList m_forceIncs;   // argument: -FI
+    V3StringSet m_hierBlocks;   // argument: --hierarchical-block modules
+    V3StringList m_cmdArgs;     // argument: command line as given, for --hierarchical
     DebugSrcMap m_debugSrcs;    // argument: --debugi-<srcfile>=<level>
     DebugSrcMap m_dumpTrees;    // argument: --dump-treei-<srcfile>=<level>
     std::map<string,string> m_parameters;  // Parameters
@@ -146,6 +155,7 @@ class V3Options {
     bool        m_cmake;        // main switch: --make cmake
     bool        m_context;      // main switch: --Wcontext
     bool        m_coverageLine; // main switch: --coverage-block
+    bool        m_coveragePerThread;// main switch: --coverage-per-thread
     bool        m_coverageToggle;// main switch: --coverage-toggle
     bool        m_coverageUnderscore;// main switch: --coverage-underscore
     bool        m_coverageUser; // main switch: --coverage-func
@@ -164,6 +174,8 @@ class V3Options {
     bool        m_inhibitSim;   // main switch: --inhibit-sim
     bool        m_lintOnly;     // main switch: --lint-only
     bool        m_gmake;        // main switch: --make gmake
+    bool        m_hierarchical; // main switch: --hierarchical
+    bool        m_hierChild;    // main switch: --hierarchical-child
     bool        m_orderClockDly;// main switch: --order-clock-delay
     bool        m_outFormatOk;  // main switch: --cc, --sc or --sp was specified
     bool        m_pedantic;     // main switch: --Wpedantic
@@ -172,6 +184,7 @@ class V3Options {
     bool        m_pinsUint8;    // main switch: --pins-uint8
     bool        m_ppComments;   // main switch: --pp-comments
     bool        m_profCFuncs;   // main switch: --prof-cfuncs
+    bool        m_profSettle;   // main switch: --prof-settle
     bool        m_profThreads;  // main switch: --prof-threads
     bool        m_protectIds;   // main switch: --protect-ids
     bool        m_public;       // main switch: --public
@@ -188,6 +201,8 @@ class V3Options {
     bool        m_threadsCoarsen;  // main switch: --threads-coarsen
     bool        m_threadsDpiPure;  // main switch: --threads-dpi all/pure
     bool        m_threadsDpiUnpure;  // main switch: --threads-dpi all
+    bool        m_threadsDynamic;  // main switch: --threads-schedule dynamic
+    bool        m_threadsFastContract;  // main switch: --threads-fast-contract
     bool        m_trace;        // main switch: --trace
     bool        m_traceCoverage;  // main switch: --trace-coverage
     bool        m_traceDups;    // main switch: --trace-dups
@@ -212,20 +227,26 @@ class V3Options {
     int         m_outputSplitCTrace;// main switch: --output-split-ctrace
     int         m_pinsBv;       // main switch: --pins-bv
     VOptionBool m_skipIdentical;  // main switch: --skip-identical
+    int         m_tableMaxBytes;  // main switch: --table-max-bytes
+    int         m_tableMinNodes;  // main switch: --table-min-nodes
+    int         m_tableSplitInputs;  // main switch: --table-split-inputs
     int         m_threads;      // main switch: --threads (0 == --no-threads)
     int         m_threadsMaxMTasks;  // main switch: --threads-max-mtasks
     int         m_traceDepth;   // main switch: --trace-depth
-    TraceFormat m_traceFormat;  // main switch: --trace or --trace-fst
+    TraceFormat m_traceFormat;  // main switch: --trace, --trace-fst, ...
     int         m_traceMaxArray;// main switch: --trace-max-array
     int         m_traceMaxWidth;// main switch: --trace-max-width
+    int         m_traceParallelStmts;  // main switch: --trace-parallel-stmts
     int         m_unrollCount;  // main switch: --unroll-count
     int         m_unrollStmts;  // main switch: --unroll-stmts
+    int         m_verilateJobs;  // main switch: --verilate-jobs
 
     int         m_compLimitBlocks;  // compiler selection; number of nested blocks
     int         m_compLimitMembers;  // compiler selection; number of members in struct before make anon array
     int         m_compLimitParens;  // compiler selection; number of nested parens
 
     string      m_bin;          // main switch: --bin {binary}
+    string      m_cacheDir;     // main switch: --cache-dir {dir}
     string      m_exeName;      // main switch: -o {name}
     string      m_flags;        // main switch: -f {name}
     string      m_l2Name;       // main switch: --l2name; "" for top-module's name
@@ -233,6 +254,7 @@ class V3Options {
     string      m_modPrefix;    // main switch: --mod-prefix
     string      m_pipeFilter;   // main switch: --pipe-filter
     string      m_prefix;       // main switch: --prefix
+    string      m_profileGuidedThreads;  // main switch: --profile-guided-threads
     string      m_protectKey;   // main switch: --protect-key
     string      m_protectLib;   // main switch: --protect-lib {lib_name}
     string      m_topModule;    // main switch: --top-module
@@ -314,6 +336,7 @@ class V3Options {
     bool preprocNoLine() const { return m_preprocNoLine; }
     bool underlineZero() const { return m_underlineZero; }
     string bin() const { return m_bin; }
+    string cacheDir() const { return m_cacheDir; }
     string flags() const { return m_flags; }
     bool systemC() const { return m_systemC; }
     bool usingSystemCLibs() const { return !lintOnly() && systemC(); }
@@ -330,6 +353,7 @@ class V3Options {
     bool context() const { return m_context; }
     bool coverage() const { return m_coverageLine || m_coverageToggle || m_coverageUser; }
     bool coverageLine() const { return m_coverageLine; }
+    bool coveragePerThread() const { return m_coveragePerThread; }
     bool coverageToggle() const { return m_coverageToggle; }
     bool coverageUnderscore() const { return m_coverageUnderscore; }
     bool coverageUser() const { return m_coverageUser; }
@@ -345,9 +369,13 @@ class V3Options {
     bool dumpDefines() const { return m_dumpDefines; }
     bool exe() const { return m_exe; }
     bool gmake() const { return m_gmake; }
+    bool hierarchical() const { return m_hierarchical; }
+    bool hierChild() const { return m_hierChild; }
     bool threadsDpiPure() const { return m_threadsDpiPure; }
     bool threadsDpiUnpure() const { return m_threadsDpiUnpure; }
+    bool threadsDynamic() const { return m_threadsDynamic; }
     bool threadsCoarsen() const { return m_threadsCoarsen; }
+    bool threadsFastContract() const { return m_threadsFastContract; }
     bool trace() const { return m_trace; }
     bool traceCoverage() const { return m_traceCoverage; }
     bool traceDups() const { return m_traceDups; }
@@ -363,6 +391,7 @@ class V3Options {
     bool pinsUint8() const { return m_pinsUint8; }
     bool ppComments() const { return m_ppComments; }
     bool profCFuncs() const { return m_profCFuncs; }
+    bool profSettle() const { return m_profSettle; }
     bool profThreads() const { return m_profThreads; }
     bool protectIds() const { return m_protectIds; }
     bool allPublic() const { return m_public; }
@@ -390,6 +419,9 @@ class V3Options {
     int outputSplitCTrace() const { return m_outputSplitCTrace; }
     int pinsBv() const { return m_pinsBv; }
     VOptionBool skipIdentical() const { return m_skipIdentical; }
+    int tableMaxBytes() const { return m_tableMaxBytes; }
+    int tableMinNodes() const { return m_tableMinNodes; }
+    int tableSplitInputs() const { return m_tableSplitInputs; }
     int threads() const { return m_threads; }
     int threadsMaxMTasks() const { return m_threadsMaxMTasks; }
     bool mtasks() const { return (m_threads > 1); }
@@ -397,8 +429,10 @@ class V3Options {
     TraceFormat traceFormat() const { return m_traceFormat; }
     int traceMaxArray() const { return m_traceMaxArray; }
     int traceMaxWidth() const { return m_traceMaxWidth; }
+    int traceParallelStmts() const { return m_traceParallelStmts; }
     int unrollCount() const { return m_unrollCount; }
     int unrollStmts() const { return m_unrollStmts; }
+    int verilateJobs() const { return m_verilateJobs; }
 
     int compLimitBlocks() const { return m_compLimitBlocks; }
     int compLimitMembers() const { return m_compLimitMembers; }
@@ -410,6 +444,7 @@ class V3Options {
     string modPrefix() const { return m_modPrefix; }
     string pipeFilter() const { return m_pipeFilter; }
     string prefix() const { return m_prefix; }
+    string profileGuidedThreads() const { return m_profileGuidedThreads; }
     string protectKey() const { return m_protectKey; }
     string protectKeyDefaulted();  // Set default key if not set by user
     string protectLib() const { return m_protectLib; }
@@ -434,6 +469,7 @@ class V3Options {
     const V3StringSet& libraryFiles() const { return m_libraryFiles; }
     const V3StringList& vFiles() const { return m_vFiles; }
     const V3StringList& forceIncs() const { return m_forceIncs; }
+    const V3StringList& cmdArgs() const { return m_cmdArgs; }
     const V3LangCode& defaultLanguage() const { return m_defaultLanguage; }
 
     bool hasParameter(const string& name);
@@ -441,6 +477,7 @@ class V3Options {
     void checkParameters();
 
     bool isFuture(const string& flag) const;
+    bool isHierBlock(const string& modname) const;
     bool isLibraryFile(const string& filename) const;
     bool isClocker(const string& signame) const;
     bool isNoClocker(const string& signame) const;
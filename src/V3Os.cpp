@@ -34,6 +34,8 @@
 #include <cerrno>
 #include <climits>
 #include <cstdarg>
+#include <cstdlib>
+#include <cstring>
 #include <dirent.h>
 #include <fcntl.h>
 #include <fstream>
@@ -51,6 +53,7 @@
 # include <thread>
 #else
 # include <sys/time.h>
+# include <sys/wait.h>  // WIFEXITED
 # include <unistd.h>  // usleep
 #endif
 
@@ -327,3 +330,21 @@ void V3Os::u_sleep(int64_t usec) {
     ::usleep(usec);
 #endif
 }
+
+//######################################################################
+// Sub-process
+
+int V3Os::system(const string& command) {
+    UINFO(1, "Running system: "<<command<<endl);
+    const int ret = ::system(command.c_str());
+    if (VL_UNLIKELY(ret == -1)) {
+        v3fatal("Failed to execute command: "<<command<<": "<<strerror(errno));
+        return -1;
+    }
+#if defined(_WIN32) || defined(__MINGW32__)
+    return ret;
+#else
+    if (!WIFEXITED(ret)) return -1;  // Killed by a signal
+    return WEXITSTATUS(ret);
+#endif
+}
@@ -58,6 +58,9 @@ public:
     static void u_sleep(int64_t usec);  ///< Sleep for a given number of microseconds.
     static uint64_t timeUsecs();  ///< Return wall time since epoch in microseconds, or 0 if not implemented
     static uint64_t memUsageBytes();  ///< Return memory usage in bytes, or 0 if not implemented
+
+    // METHODS (sub-process)
+    static int system(const string& command);  ///< Run command using shell, return exit code
 };
 
 #endif  // Guard
@@ -0,0 +1,79 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Running Verilator's own work on multiple threads
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Global.h"
+#include "V3Parallel.h"
+
+#include <algorithm>
+
+#ifdef VL_PARALLEL_THREADS
+# include <atomic>
+# include <thread>
+# include <vector>
+#endif
+
+//######################################################################
+
+bool V3Parallel::s_active = false;
+
+V3Mutex& V3Parallel::astMutex() {
+    static V3Mutex s_mutex;
+    return s_mutex;
+}
+
+int V3Parallel::jobs() {
+#ifdef VL_PARALLEL_THREADS
+    int jobs = v3Global.opt.verilateJobs();
+    if (!jobs) jobs = std::thread::hardware_concurrency();
+    return std::max(1, jobs);
+#else
+    return 1;
+#endif
+}
+
+#ifdef VL_PARALLEL_THREADS
+static void parallelWorker(std::atomic<int>* nextp, int count,
+                           V3Parallel::Callback cbp, void* userp) {
+    for (int index = (*nextp)++; index < count; index = (*nextp)++) {
+        cbp(userp, index);
+    }
+}
+#endif
+
+void V3Parallel::forEach(int count, Callback cbp, void* userp) {
+    int threads = std::min(jobs(), count);
+    if (threads <= 1 || s_active) {
+        for (int index = 0; index < count; ++index) cbp(userp, index);
+        return;
+    }
+#ifdef VL_PARALLEL_THREADS
+    UINFO(4, "  forEach " << count << " on " << threads << " threads" << endl);
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    s_active = true;  // Set before threads start, so they all see it
+    for (int i = 1; i < threads; ++i) {
+        workers.push_back(std::thread(parallelWorker, &next, count, cbp, userp));
+    }
+    parallelWorker(&next, count, cbp, userp);  // This thread works too
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    s_active = false;
+#endif
+}
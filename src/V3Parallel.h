@@ -0,0 +1,95 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Running Verilator's own work on multiple threads
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#ifndef _V3PARALLEL_H_
+#define _V3PARALLEL_H_ 1
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#if __cplusplus >= 201103L
+# define VL_PARALLEL_THREADS 1  // Have std::thread, else work is always serial
+# include <mutex>
+#endif
+
+//============================================================================
+
+class V3Mutex {
+    // Mutex guarding state that V3Parallel::forEach jobs share.
+    // Recursive, as e.g. errors may be reported while holding it.
+    // Without std::thread nothing runs in parallel, so this does nothing.
+#ifdef VL_PARALLEL_THREADS
+    std::recursive_mutex m_mutex;
+public:
+    void lock() { m_mutex.lock(); }
+    void unlock() { m_mutex.unlock(); }
+#else
+public:
+    void lock() {}
+    void unlock() {}
+#endif
+};
+
+class V3LockGuard {
+    // Hold a V3Mutex while in scope
+    V3Mutex& m_mutexr;
+    VL_UNCOPYABLE(V3LockGuard);
+public:
+    struct AdoptLock {};  // Constructor selection; mutex already locked by caller
+    explicit V3LockGuard(V3Mutex& mutexr) : m_mutexr(mutexr) { m_mutexr.lock(); }
+    V3LockGuard(V3Mutex& mutexr, AdoptLock) : m_mutexr(mutexr) {}
+    ~V3LockGuard() { m_mutexr.unlock(); }
+};
+
+//============================================================================
+
+class V3Parallel {
+    static bool s_active;  // forEach calls are running on multiple threads
+public:
+    typedef void (*Callback)(void* userp, int index);
+    // METHODS
+    // Number of threads to use, from --verilate-jobs
+    static int jobs();
+    // Call cbp(userp, index) for each index from 0 to count-1, returning
+    // once all calls return.  Indexes are started in increasing order, on
+    // up to jobs() threads, so put the largest work first.  Calls must only
+    // share state that is guarded by a V3Mutex.  Creating, cloning and
+    // deleting AstNodes and FileLines, and data type lookups, are guarded
+    // with astMutex(); other edits must stay in nodes the call owns.
+    // Calls made from a call run serially.
+    static void forEach(int count, Callback cbp, void* userp);
+    // True while forEach calls may be running in parallel
+    static bool active() { return s_active; }
+    // Mutex guarding the AST's shared state, see V3AstLockGuard
+    static V3Mutex& astMutex();
+};
+
+class V3AstLockGuard {
+    // Hold V3Parallel::astMutex() while in scope, if forEach calls may be
+    // running in parallel.  Otherwise costs only a test, so it may be used
+    // in hot AST code such as node creation.
+    bool m_locked;
+    VL_UNCOPYABLE(V3AstLockGuard);
+public:
+    V3AstLockGuard() : m_locked(V3Parallel::active()) {
+        if (VL_UNLIKELY(m_locked)) V3Parallel::astMutex().lock();
+    }
+    ~V3AstLockGuard() {
+        if (VL_UNLIKELY(m_locked)) V3Parallel::astMutex().unlock();
+    }
+};
+
+#endif  // Guard
@@ -0,0 +1,88 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Running function-local passes on multiple threads
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Global.h"
+#include "V3ParallelCFunc.h"
+#include "V3Parallel.h"
+
+#include <algorithm>
+#include <utility>
+
+//######################################################################
+
+class ParallelCFuncVisitor : public AstNVisitor {
+    // Find every AstCFunc, with a cheap estimate of its size
+public:
+    typedef std::vector<std::pair<size_t, AstCFunc*> > SizedFuncs;
+private:
+    // STATE
+    SizedFuncs& m_funcs;  // Functions found
+    // VISITORS
+    virtual void visit(AstCFunc* nodep) VL_OVERRIDE {
+        // Count top level statements; cheaper than the pass we're scheduling
+        size_t stmts = 0;
+        for (AstNode* stmtp = nodep->stmtsp(); stmtp; stmtp = stmtp->nextp()) ++stmts;
+        m_funcs.push_back(std::make_pair(stmts, nodep));
+    }
+    virtual void visit(AstVar*) VL_OVERRIDE {}  // Accelerate
+    virtual void visit(AstNodeMath*) VL_OVERRIDE {}  // Accelerate
+    virtual void visit(AstNode* nodep) VL_OVERRIDE { iterateChildren(nodep); }
+public:
+    // CONSTRUCTORS
+    ParallelCFuncVisitor(AstNetlist* nodep, SizedFuncs& funcs)
+        : m_funcs(funcs) {
+        iterate(nodep);
+    }
+    virtual ~ParallelCFuncVisitor() {}
+};
+
+struct ParallelCFuncLarger {
+    bool operator()(const ParallelCFuncVisitor::SizedFuncs::value_type& a,
+                    const ParallelCFuncVisitor::SizedFuncs::value_type& b) const {
+        return a.first > b.first;
+    }
+};
+
+//######################################################################
+// ParallelCFunc class functions
+
+V3ParallelCFunc::V3ParallelCFunc(AstNetlist* rootp)
+    : m_cbp(NULL), m_userp(NULL) {
+    ParallelCFuncVisitor::SizedFuncs funcs;
+    { ParallelCFuncVisitor visitor (rootp, funcs); }
+    // Largest first, so a large function isn't left running alone at the
+    // end.  Stable, so the order is the same every run.
+    std::stable_sort(funcs.begin(), funcs.end(), ParallelCFuncLarger());
+    m_funcps.reserve(funcs.size());
+    for (ParallelCFuncVisitor::SizedFuncs::const_iterator it = funcs.begin();
+         it != funcs.end(); ++it) {
+        m_funcps.push_back(it->second);
+    }
+}
+
+void V3ParallelCFunc::run(void* selfp, int index) {
+    V3ParallelCFunc* thisp = static_cast<V3ParallelCFunc*>(selfp);
+    thisp->m_cbp(thisp->m_userp, thisp->m_funcps[index], index);
+}
+
+void V3ParallelCFunc::forEach(Callback cbp, void* userp) {
+    m_cbp = cbp;
+    m_userp = userp;
+    V3Parallel::forEach(size(), &V3ParallelCFunc::run, this);
+}
@@ -0,0 +1,57 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//*************************************************************************
+// DESCRIPTION: Verilator: Running function-local passes on multiple threads
+//
+// Code available from: https://verilator.org
+//
+//*************************************************************************
+//
+// Copyright 2003-2020 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//*************************************************************************
+
+#ifndef _V3PARALLELCFUNC_H_
+#define _V3PARALLELCFUNC_H_ 1
+
+#include "config_build.h"
+#include "verilatedos.h"
+
+#include "V3Error.h"
+#include "V3Ast.h"
+
+#include <vector>
+
+//============================================================================
+
+class V3ParallelCFunc {
+    // Run a pass on each AstCFunc as a V3Parallel::forEach job, for passes
+    // that only read and edit nodes under the function being visited.
+    // Jobs may create, clone and delete nodes (see V3AstLockGuard), but
+    // must not allocate AstUser*InUse, so the caller holds those around
+    // forEach(), and must guard any other shared state with a V3Mutex.
+public:
+    typedef std::vector<AstCFunc*> FuncVec;
+    typedef void (*Callback)(void* userp, AstCFunc* funcp, int index);
+private:
+    // MEMBERS
+    FuncVec m_funcps;  // Functions, largest first
+    Callback m_cbp;  // Callback for forEach()
+    void* m_userp;  // User pointer for forEach()
+    // METHODS
+    static void run(void* selfp, int index);
+    VL_UNCOPYABLE(V3ParallelCFunc);
+public:
+    // CONSTRUCTORS
+    explicit V3ParallelCFunc(AstNetlist* rootp);
+    // METHODS
+    // Number of functions; forEach() indexes are below this
+    int size() const { return static_cast<int>(m_funcps.size()); }
+    // Call cbp(userp, funcp, index) for each function, in parallel
+    void forEach(Callback cbp, void* userp);
+};
+
+#endif  // Guard
@@ -77,6 +77,15 @@ class MergeCandidate;
 #define PART_SIBLING_EDGE_LIMIT 25
 
 
+//   PART_FAST_SIBLING_EDGE_LIMIT (integer)
+//
+// With --threads-fast-contract, the PART_SIBLING_EDGE_LIMIT used when
+// re-enumerating siblings of the neighbors of each newly merged mtask.
+// This bounds the work done after each merge, at the cost of considering
+// fewer sibling merges.
+#define PART_FAST_SIBLING_EDGE_LIMIT 5
+
+
 //   PART_STEPPED_COST (boolean)
 //
 // When computing critical path costs, use a step function on the actual
@@ -196,6 +205,7 @@ private:
     bool m_slowAsserts;  // Enable nontrivial asserts
     typedef SortByValueMap<V3GraphVertex*, uint32_t> PropCpPendSet;
     PropCpPendSet m_pending;  // Pending rescores
+    size_t m_updates;  // Number of vertices whose CP was updated
 
 public:
     // CONSTRUCTORS
@@ -206,7 +216,8 @@ public:
         , m_way(way)
         , m_accessp(accessp)
         , m_generation(0)
-        , m_slowAsserts(slowAsserts) {}
+        , m_slowAsserts(slowAsserts)
+        , m_updates(0) {}
 
     // METHODS
     void cpHasIncreased(V3GraphVertex* vxp, uint32_t newInclusiveCp) {
@@ -268,8 +279,10 @@ public:
 
             m_accessp->setCritPathCost(updateMep, m_way, newCp);
             cpHasIncreased(updateMep, newCp + m_accessp->cost(updateMep));
+            ++m_updates;
         }
     }
+    size_t updates() const { return m_updates; }
 
 private:
     VL_DEBUG_FUNC;
@@ -390,6 +403,141 @@ public:
     }
 };
 
+//######################################################################
+// PartProfile - Profile guided costs, for --profile-guided-threads
+//
+// With --prof-threads we write a map from each mtask id to the logic it
+// contains. Each logic vertex is named by a key (scope, node type and
+// source location) that is stable from one Verilation to the next, even
+// though the mtask ids are not. The runtime profile gives the measured
+// time of each mtask. Reading the two back, each logic key gets the ratio
+// of its mtask's measured cost to its estimated cost, normalized so that
+// the average ratio is 1. LogicMTask costs are then scaled by that ratio,
+// so both the contraction and the final packing see measured costs, in
+// the same units as V3InstrCount.
+
+class PartProfile {
+    // TYPES
+    typedef std::map<string, double> KeyScaleMap;
+    typedef std::map<uint32_t, double> IdScaleMap;
+    // STATE
+    static KeyScaleMap s_keyScales;  // Logic key -> cost scale
+    static IdScaleMap s_mtaskScales;  // Final mtask ID -> cost scale
+    // METHODS
+    static string mapFilename() {
+        return v3Global.opt.makeDir() + "/" + v3Global.opt.prefix() + "__prof_threads_map.dat";
+    }
+public:
+    static string logicKey(const OrderLogicVertex* logicp) {
+        return (logicp->scopep()->name() + " " + logicp->nodep()->typeName() + " "
+                + logicp->nodep()->fileline()->ascii());
+    }
+    static void readProfile() {
+        s_keyScales.clear();
+        s_mtaskScales.clear();
+        const string& profFilename = v3Global.opt.profileGuidedThreads();
+        if (profFilename.empty()) return;
+        // Measured ticks per mtask, averaged across all records
+        std::map<uint32_t, std::pair<double, double> > measured;  // Total, samples
+        {
+            const vl_unique_ptr<std::ifstream> ifp(V3File::new_ifstream(profFilename));
+            if (ifp->fail()) {
+                v3fatal("Cannot open --profile-guided-threads file: " << profFilename);
+            }
+            while (!ifp->eof()) {
+                string line = V3Os::getline(*ifp);
+                if (line.compare(0, 13, "VLPROF mtask ") != 0) continue;
+                std::istringstream is(line.substr(13));
+                uint32_t id = 0;
+                string word;
+                double elapsed = 0;
+                is >> id;
+                while (is >> word) {
+                    if (word == "elapsed") is >> elapsed;
+                }
+                std::pair<double, double>& rec = measured[id];
+                rec.first += elapsed;
+                rec.second += 1;
+            }
+        }
+        // Estimated cost of each mtask, and each logic key's mtask, from
+        // the map written alongside the profiled model
+        std::map<uint32_t, double> estimated;
+        std::map<string, uint32_t> keyMTask;
+        {
+            const string mapFilename = PartProfile::mapFilename();
+            const vl_unique_ptr<std::ifstream> ifp(V3File::new_ifstream(mapFilename));
+            if (ifp->fail()) {
+                v3fatal("Cannot open " << mapFilename << " for --profile-guided-threads;"
+                        " Verilate with --prof-threads into the same --Mdir first");
+            }
+            while (!ifp->eof()) {
+                string line = V3Os::getline(*ifp);
+                if (line.compare(0, 6, "logic ") != 0) continue;
+                std::istringstream is(line.substr(6));
+                uint32_t id = 0;
+                double cost = 0;
+                is >> id >> cost;
+                string key;
+                std::getline(is >> std::ws, key);
+                estimated[id] += cost;
+                keyMTask[key] = id;
+            }
+        }
+        // Normalize so the overall measured:estimated ratio is 1
+        double totalMeasured = 0;
+        double totalEstimated = 0;
+        for (std::map<uint32_t, std::pair<double, double> >::iterator it = measured.begin();
+             it != measured.end(); ++it) {
+            if (!estimated[it->first]) continue;
+            totalMeasured += it->second.first / it->second.second;
+            totalEstimated += estimated[it->first];
+        }
+        if (!totalMeasured || !totalEstimated) {
+            v3fatal("No mtask profile records matching " << mapFilename()
+                    << " in --profile-guided-threads file: " << profFilename);
+        }
+        double norm = totalEstimated / totalMeasured;
+        for (std::map<string, uint32_t>::iterator it = keyMTask.begin();
+             it != keyMTask.end(); ++it) {
+            std::map<uint32_t, std::pair<double, double> >::iterator mit
+                = measured.find(it->second);
+            if (mit == measured.end() || !estimated[it->second]) continue;
+            double mtaskMeasured = mit->second.first / mit->second.second;
+            s_keyScales[it->first] = norm * mtaskMeasured / estimated[it->second];
+        }
+        V3Stats::addStat("MTask profile, logic with measured costs", s_keyScales.size());
+        V3Stats::addStat("MTask profile, logic without measured costs",
+                         keyMTask.size() - s_keyScales.size());
+    }
+    // Cost of logicp given its V3InstrCount estimate
+    static uint32_t guidedCost(const OrderLogicVertex* logicp, uint32_t estCost) {
+        if (s_keyScales.empty()) return estCost;
+        KeyScaleMap::const_iterator it = s_keyScales.find(logicKey(logicp));
+        if (it == s_keyScales.end()) return estCost;
+        double cost = estCost * it->second;
+        if (cost > 0x7fffffff) return 0x7fffffff;
+        return (estCost && cost < 1) ? 1 : static_cast<uint32_t>(cost);
+    }
+    // Record the scale applied to a final mtask's estimated cost, so
+    // V3Partition::finalizeCosts can apply it too.
+    static void mtaskScale(uint32_t id, uint32_t guidedCost, uint32_t estCost) {
+        if (s_keyScales.empty() || !estCost) return;
+        s_mtaskScales[id] = static_cast<double>(guidedCost) / estCost;
+    }
+    static uint32_t finalCost(uint32_t id, uint32_t estCost) {
+        IdScaleMap::const_iterator it = s_mtaskScales.find(id);
+        if (it == s_mtaskScales.end()) return estCost;
+        double cost = estCost * it->second;
+        if (cost > 0x7fffffff) return 0x7fffffff;
+        return (estCost && cost < 1) ? 1 : static_cast<uint32_t>(cost);
+    }
+    static void writeMap(const V3Graph* mtasksp);
+};
+
+PartProfile::KeyScaleMap PartProfile::s_keyScales;
+PartProfile::IdScaleMap PartProfile::s_mtaskScales;
+
 //######################################################################
 // LogicMTask
 
@@ -465,6 +613,8 @@ private:
     // Cost estimate for this LogicMTask, derived from V3InstrCount.
     // In abstract time units.
     uint32_t m_cost;
+    // Same as m_cost, but excluding --profile-guided-threads scaling
+    uint32_t m_estCost;
 
     // Cost of critical paths going FORWARD from graph-start to the start
     // of this vertex, and also going REVERSE from the end of the graph to
@@ -494,12 +644,15 @@ public:
     LogicMTask(V3Graph* graphp, MTaskMoveVertex* mtmvVxp)
         : AbstractLogicMTask(graphp)
         , m_cost(0)
+        , m_estCost(0)
         , m_generation(0) {
         for (int i=0; i<GraphWay::NUM_WAYS; ++i) m_critPathCost[i] = 0;
         if (mtmvVxp) {  // Else null for test
             m_vertices.push_back(mtmvVxp);
             if (OrderLogicVertex* olvp = mtmvVxp->logicp()) {
-                m_cost += V3InstrCount::count(olvp->nodep(), true);
+                uint32_t estCost = V3InstrCount::count(olvp->nodep(), true);
+                m_estCost += estCost;
+                m_cost += PartProfile::guidedCost(olvp, estCost);
             }
         }
         // Start at 1, so that 0 indicates no mtask ID.
@@ -513,6 +666,7 @@ public:
         // splice() is constant time
         m_vertices.splice(m_vertices.end(), otherp->m_vertices);
         m_cost += otherp->m_cost;
+        m_estCost += otherp->m_estCost;
     }
     virtual const VxList* vertexListp() const {
         return &m_vertices;
@@ -530,7 +684,8 @@ public:
     void id(uint32_t id) { m_serialId = id; }
     // Abstract cost of every logic mtask
     virtual uint32_t cost() const { return m_cost; }
-    void setCost(uint32_t cost) { m_cost = cost; }  // For tests only
+    uint32_t estCost() const { return m_estCost; }
+    void setCost(uint32_t cost) { m_cost = cost; m_estCost = cost; }  // For tests only
     uint32_t stepCost() const { return stepCost(m_cost); }
     static uint32_t stepCost(uint32_t cost) {
 #if PART_STEPPED_COST
@@ -1138,23 +1293,78 @@ private:
     uint32_t m_scoreLimit;  // Sloppy score allowed when picking merges
     uint32_t m_scoreLimitBeforeRescore;  // Next score rescore at
     unsigned m_mergesSinceRescore;  // Merges since last rescore
+    unsigned m_mtaskCount;  // Number of mtasks in the graph
     bool m_slowAsserts;  // Take extra time to validate algorithm
+    bool m_fast;  // --threads-fast-contract: merge chains first, bound sibling updates
     V3Scoreboard<MergeCandidate, uint32_t> m_sb;  // Scoreboard
     SibSet m_pairs;  // Storage for each SiblingMC
     MTask2Sibs m_mtask2sibs;  // SiblingMC set for each mtask
+    // Statistics
+    VDouble0 m_statChainMerges;  // Chain links merged before contraction
+    VDouble0 m_statEdgeMerges;  // Edges contracted
+    VDouble0 m_statSiblingMerges;  // Siblings contracted
+    VDouble0 m_statCycleRejects;  // Candidates rejected as would create a cycle
+    VDouble0 m_statRescores;  // Scoreboard rescores
+    VDouble0 m_statCpUpdates;  // Critical paths updated by propagation
 
 public:
     // CONSTRUCTORS
-    PartContraction(V3Graph* mtasksp, uint32_t scoreLimit, bool slowAsserts)
+    PartContraction(V3Graph* mtasksp, uint32_t scoreLimit, bool slowAsserts,
+                    bool fast = false)
         : m_mtasksp(mtasksp)
         , m_scoreLimit(scoreLimit)
         , m_scoreLimitBeforeRescore(0xffffffff)
         , m_mergesSinceRescore(0)
+        , m_mtaskCount(0)
         , m_slowAsserts(slowAsserts)
+        , m_fast(fast)
         , m_sb(&mergeCandidateScore, slowAsserts) { }
 
     // METHODS
     void go() {
+        vluint64_t startUsecs = V3Os::timeUsecs();
+        contractAll();
+        double elapsed = (V3Os::timeUsecs() - startUsecs) / 1.0e6;
+        UINFO(4, "Contraction done: mtasks="<<m_mtaskCount
+              <<" merges="<<(m_statEdgeMerges + m_statSiblingMerges)
+              <<" rescores="<<m_statRescores<<" secs="<<elapsed<<endl);
+        V3Stats::addStat("MTask contraction, chain merges", m_statChainMerges);
+        V3Stats::addStat("MTask contraction, edge merges", m_statEdgeMerges);
+        V3Stats::addStat("MTask contraction, sibling merges", m_statSiblingMerges);
+        V3Stats::addStat("MTask contraction, cycle rejects", m_statCycleRejects);
+        V3Stats::addStat("MTask contraction, rescores", m_statRescores);
+        V3Stats::addStat("MTask contraction, critical path updates", m_statCpUpdates);
+        V3Stats::addStatPerf("MTask contraction, Elapsed time (sec)", elapsed);
+    }
+
+private:
+    void contractChains() {
+        // Merge each mtask with exactly one successor, that has exactly
+        // one predecessor, into that successor, without scoring.  Nothing
+        // else can run between them, so this doesn't lengthen the
+        // critical path, and can't create a cycle.  Critical paths are
+        // then computed once, rather than propagated for each merge.
+        for (V3GraphVertex* vxp = m_mtasksp->verticesBeginp();
+             vxp; vxp = vxp->verticesNextp()) {
+            LogicMTask* recipientp = dynamic_cast<LogicMTask*>(vxp);
+            while (V3GraphEdge* edgep = recipientp->outBeginp()) {
+                if (edgep->outNextp()) break;  // Not exactly one successor
+                LogicMTask* donorp = dynamic_cast<LogicMTask*>(edgep->top());
+                if (donorp->inBeginp()->inNextp()) break;  // Not exactly one predecessor
+                // Remove the connecting edge, then merge as PartFixDataHazards does
+                VL_DO_DANGLING(edgep->unlinkDelete(), edgep);
+                recipientp->moveAllVerticesFrom(donorp);
+                partMergeEdgesFrom(m_mtasksp, recipientp, donorp, NULL);
+                VL_DO_DANGLING(donorp->unlinkDelete(m_mtasksp), donorp);
+                ++m_statChainMerges;
+            }
+        }
+        partInitCriticalPaths(m_mtasksp);
+        if (m_slowAsserts) partCheckCriticalPaths(m_mtasksp);
+        UINFO(4, "Contraction merged chain links: "<<m_statChainMerges<<endl);
+    }
+
+    void contractAll() {
         unsigned maxMTasks = v3Global.opt.threadsMaxMTasks();
         if (maxMTasks == 0) {  // Unspecified so estimate
             if (v3Global.opt.threads() > 1) {
@@ -1175,8 +1385,11 @@ public:
         //  - Merge the best pair.
         //  - Incrementally recompute critical paths near the merged mtask.
 
+        if (m_fast) contractChains();
+
         for (V3GraphVertex* itp = m_mtasksp->verticesBeginp(); itp;
              itp = itp->verticesNextp()) {
+            ++m_mtaskCount;
             vl_unordered_set<const V3GraphVertex*> neighbors;
             for (V3GraphEdge* edgep = itp->outBeginp(); edgep;
                  edgep=edgep->outNextp()) {
@@ -1233,12 +1446,7 @@ public:
 
                     // Except, if we have too many mtasks, raise the score
                     // limit and keep going...
-                    unsigned mtaskCount = 0;
-                    for (V3GraphVertex* vxp = m_mtasksp->verticesBeginp();
-                         vxp; vxp = vxp->verticesNextp()) {
-                        ++mtaskCount;
-                    }
-                    if (mtaskCount > maxMTasks) {
+                    if (m_mtaskCount > maxMTasks) {
                         uint32_t oldLimit = m_scoreLimit;
                         m_scoreLimit = (m_scoreLimit * 120) / 100;
                         v3Global.rootp()->fileline()->v3warn(
@@ -1272,6 +1480,7 @@ public:
                 // reconsidering it on every loop.
                 m_sb.removeElem(mergeCanp);
                 mergeCanp->removedFromSb(true);
+                ++m_statCycleRejects;
                 continue;
             }
 
@@ -1450,6 +1659,7 @@ private:
         }
         forwardPropagator.go();
         reversePropagator.go();
+        m_statCpUpdates += forwardPropagator.updates() + reversePropagator.updates();
 
         // Remove all SiblingMCs that include donorp. This Includes the one
         // we're merging, if we're merging a SiblingMC.
@@ -1466,6 +1676,9 @@ private:
         VL_DO_CLEAR(donorp->unlinkDelete(m_mtasksp), donorp = NULL);
 
         m_mergesSinceRescore++;
+        --m_mtaskCount;
+        if (mergeSibsp) ++m_statSiblingMerges;
+        else ++m_statEdgeMerges;
 
         // Do an expensive check, confirm we haven't botched the CP
         // updates.
@@ -1478,13 +1691,15 @@ private:
         // Note that this depends on the updated critical paths (above).
         siblingPairFromRelatives(GraphWay::REVERSE, recipientp, true);
         siblingPairFromRelatives(GraphWay::FORWARD, recipientp, true);
+        const unsigned edgeLimit = m_fast ? PART_FAST_SIBLING_EDGE_LIMIT
+            : PART_SIBLING_EDGE_LIMIT;
         unsigned edges = 0;
         for (V3GraphEdge* edgep = recipientp->outBeginp();
              edgep; edgep = edgep->outNextp()) {
             LogicMTask* postreqp = dynamic_cast<LogicMTask*>(edgep->top());
             siblingPairFromRelatives(GraphWay::REVERSE, postreqp, false);
             edges++;
-            if (edges > PART_SIBLING_EDGE_LIMIT) break;
+            if (edges > edgeLimit) break;
         }
         edges = 0;
         for (V3GraphEdge* edgep = recipientp->inBeginp();
@@ -1492,7 +1707,7 @@ private:
             LogicMTask* prereqp = dynamic_cast<LogicMTask*>(edgep->fromp());
             siblingPairFromRelatives(GraphWay::FORWARD, prereqp, false);
             edges++;
-            if (edges > PART_SIBLING_EDGE_LIMIT) break;
+            if (edges > edgeLimit) break;
         }
     }
 
@@ -1503,8 +1718,13 @@ private:
         // behave identically without the caching (just slower)
 
         m_sb.rescore();
+        ++m_statRescores;
         UINFO(6, "Did rescore. Merges since previous = "
               << m_mergesSinceRescore << endl);
+        // Progress indicator for slow partitions
+        UINFO(4, "Contraction progress: mtasks="<<m_mtaskCount
+              <<" scoreLimitBeforeRescore="<<m_scoreLimitBeforeRescore
+              <<" scoreLimit="<<m_scoreLimit<<endl);
 
         m_mergesSinceRescore = 0;
         m_scoreLimitBeforeRescore = 0xffffffff;
@@ -1737,10 +1957,32 @@ private:
         UASSERT_SELFTEST(uint32_t, check.vertexCount(), 14);
         UASSERT_SELFTEST(uint32_t, check.edgeCount(), 13);
     }
+    static void selfTestFastChain() {
+        // With --threads-fast-contract, a chain merges before scoring
+        V3Graph mtasks;
+        LogicMTask* lastp = NULL;
+        for (unsigned i=0; i<100; ++i) {
+            LogicMTask* mtp = new LogicMTask(&mtasks, NULL);
+            mtp->setCost(1);
+            if (lastp) new MTaskEdge(&mtasks, lastp, mtp, 1);
+            lastp = mtp;
+        }
+        partInitCriticalPaths(&mtasks);
+        PartContraction ec(&mtasks, 20, true, true);
+        ec.go();
+
+        PartParallelismEst check(&mtasks);
+        check.traverse();
+        UASSERT_SELFTEST(uint32_t, check.vertexCount(), 1);
+        UASSERT_SELFTEST(uint32_t, check.totalGraphCost(), 100);
+        UASSERT_SELFTEST(uint32_t, ec.m_statChainMerges, 99);
+        UASSERT_SELFTEST(uint32_t, ec.m_statEdgeMerges + ec.m_statSiblingMerges, 0);
+    }
 public:
     static void selfTest() {
         selfTestX();
         selfTestChain();
+        selfTestFastChain();
     }
 
 private:
@@ -2514,10 +2756,32 @@ void V3Partition::setupMTaskDeps(V3Graph* mtasksp, const Vx2MTaskMap* vx2mtaskp)
     }
 }
 
+void PartProfile::writeMap(const V3Graph* mtasksp) {
+    const vl_unique_ptr<std::ofstream> ofp(V3File::new_ofstream(mapFilename()));
+    if (ofp->fail()) v3fatal("Can't write " << mapFilename());
+    *ofp << "# Verilator mtask logic map, for --profile-guided-threads\n";
+    *ofp << "# logic <mtask id> <estimated cost> <logic key>\n";
+    for (const V3GraphVertex* vxp = mtasksp->verticesBeginp(); vxp;
+         vxp = vxp->verticesNextp()) {
+        const LogicMTask* mtaskp = dynamic_cast<const LogicMTask*>(vxp);
+        for (LogicMTask::VxList::const_iterator it = mtaskp->vertexListp()->begin();
+             it != mtaskp->vertexListp()->end(); ++it) {
+            if (const OrderLogicVertex* logicp = (*it)->logicp()) {
+                *ofp << "logic " << mtaskp->id() << " "
+                     << V3InstrCount::count(logicp->nodep(), false) << " "
+                     << logicKey(logicp) << "\n";
+            }
+        }
+    }
+}
+
 void V3Partition::go(V3Graph* mtasksp) {
     // Called by V3Order
     hashGraphDebug(m_fineDepsGraphp, "v3partition initial fine-grained deps");
 
+    // Must read any profile before the LogicMTasks compute their costs
+    PartProfile::readProfile();
+
     // Create the first MTasks. Initially, each MTask just wraps one
     // MTaskMoveVertex. Over time, we'll merge MTasks together and
     // eventually each MTask will wrap a large number of MTaskMoveVertices
@@ -2602,7 +2866,8 @@ void V3Partition::go(V3Graph* mtasksp) {
         PartContraction(mtasksp, cpLimit,
                         // --debugPartition is used by tests
                         // to enable slow assertions.
-                        v3Global.opt.debugPartition()).go();
+                        v3Global.opt.debugPartition(),
+                        v3Global.opt.threadsFastContract()).go();
         V3Partition::debugMTaskGraphStats(mtasksp, "contraction");
     }
     {
@@ -2646,7 +2911,12 @@ void V3Partition::go(V3Graph* mtasksp) {
             MTaskMoveVertex* mvertexp = *it;
             mvertexp->color(mtaskp->id());
         }
+        PartProfile::mtaskScale(mtaskp->id(), mtaskp->cost(), mtaskp->estCost());
     }
+
+    // The mtask ids are now final; record what they contain for a future
+    // --profile-guided-threads
+    if (v3Global.opt.profThreads()) PartProfile::writeMap(mtasksp);
 }
 
 void V3Partition::finalizeCosts(V3Graph* execMTaskGraphp) {
@@ -2654,7 +2924,8 @@ void V3Partition::finalizeCosts(V3Graph* execMTaskGraphp) {
 
     while (const V3GraphVertex* vxp = ser.nextp()) {
         ExecMTask* mtp = dynamic_cast<ExecMTask*>(const_cast<V3GraphVertex*>(vxp));
-        uint32_t costCount = V3InstrCount::count(mtp->bodyp(), false);
+        uint32_t costCount
+            = PartProfile::finalCost(mtp->id(), V3InstrCount::count(mtp->bodyp(), false));
         mtp->cost(costCount);
         mtp->priority(costCount);
 
@@ -28,6 +28,7 @@
 
 #include <cstdarg>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <stack>
 #include <vector>
@@ -105,12 +106,16 @@ public:
     // TYPES
     typedef std::map<string,VDefine> DefinesMap;
     typedef VInFilter::StrList StrList;
+    typedef std::map<string,string> IncludeGuardMap;
 
     // debug() -> see V3PreShellImp::debug; use --debugi-V3PreShell
 
     // Defines list
     DefinesMap m_defines;  ///< Map of defines
 
+    // Include guards
+    IncludeGuardMap m_includeGuards;  ///< Filename to define guarding whole file, "" if none
+
     // STATE
     V3PreProc* m_preprocp;  ///< Object we're holding data for
     V3PreLex* m_lexp;  ///< Current lexer state (NULL = closed)
@@ -180,6 +185,8 @@ private:
     // Internal methods
     void endOfOneFile();
     string defineSubst(VDefineRef* refp);
+    static string includeGuard(const char* cp, const char* ep);
+    static bool commentIsPlain(const string& text);
 
     bool defExists(const string& name);
     string defValue(const string& name);
@@ -762,14 +769,37 @@ void V3PreProcImp::openFile(FileLine* fl, VInFilter* filterp, const string& file
     if (m_incError) return;
     V3File::addSrcDepend(filename);
 
-    // Read a list<string> with the whole file.
-    StrList wholefile;
-    bool ok = filterp->readWholefile(filename, wholefile/*ref*/);
-    if (!ok) {
-        error("File not found: "+filename+"\n");
+    // If every line of the file is under an `ifndef of a define that is now
+    // defined, including it again would produce nothing, so don't even read
+    // it.  Not with -E, as that would drop the blank lines kept for it.
+    IncludeGuardMap::iterator guardIt = m_includeGuards.find(filename);
+    bool findGuard = !v3Global.opt.preprocOnly() && guardIt == m_includeGuards.end();
+    if (!m_preprocp->isEof() && guardIt != m_includeGuards.end()
+        && !guardIt->second.empty() && defExists(guardIt->second)) {
+        UINFO(4,"Include "<<filename<<" skipped, guarded by `"<<guardIt->second<<endl);
         return;
     }
 
+    // Lex large files straight from memory mapped pages, rather than
+    // copying them, unless they have DOS CR's or NULs to filter (below).
+    const char* mappedp = NULL;
+    size_t mappedSize = 0;
+    if (filterp->mapWholefile(filename, mappedp/*ref*/, mappedSize/*ref*/)
+        && (memchr(mappedp, '\r', mappedSize) || memchr(mappedp, '\0', mappedSize))) {
+        filterp->unmapWholefile(filename);
+        mappedp = NULL;
+    }
+
+    // Else read a list<string> with the whole file.
+    StrList wholefile;
+    if (!mappedp) {
+        bool ok = filterp->readWholefile(filename, wholefile/*ref*/);
+        if (!ok) {
+            error("File not found: "+filename+"\n");
+            return;
+        }
+    }
+
     if (!m_preprocp->isEof()) {  // IE not the first file.
         // We allow the same include file twice, because occasionally it pops
         // up, with guards preventing a real recursion.
@@ -788,6 +818,7 @@ void V3PreProcImp::openFile(FileLine* fl, VInFilter* filterp, const string& file
     FileLine* flsp = new FileLine(filename);
     flsp->lineno(1);
     flsp->newContent();
+    if (mappedp) flsp->contentp()->pushMapped(mappedp, mappedSize);
     for (StrList::iterator it=wholefile.begin(); it!=wholefile.end(); ++it) {
         flsp->contentp()->pushText(*it);
     }
@@ -796,6 +827,17 @@ void V3PreProcImp::openFile(FileLine* fl, VInFilter* filterp, const string& file
     m_lexp->scanNewFile(flsp);
     addLineComment(1);  // Enter
 
+    if (mappedp) {
+        m_lexp->scanMappedBack(mappedp, mappedSize);
+        if (findGuard) {
+            m_includeGuards.insert(make_pair(filename,
+                                             includeGuard(mappedp, mappedp + mappedSize)));
+        }
+        return;
+    }
+
+    string guardText;  // Contents to find include guard in
+
     // Filter all DOS CR's en-mass.  This avoids bugs with lexing CRs in the wrong places.
     // This will also strip them from strings, but strings aren't supposed
     // to be multi-line without a "\"
@@ -822,9 +864,93 @@ void V3PreProcImp::openFile(FileLine* fl, VInFilter* filterp, const string& file
 
         // Push the data to an internal buffer.
         m_lexp->scanBytesBack(*it);
+        if (findGuard) guardText += *it;
         // Reclaim memory; the push saved the string contents for us
         *it = "";
     }
+    if (findGuard) {
+        m_includeGuards.insert(make_pair(filename, includeGuard(guardText.data(),
+                                                                guardText.data()
+                                                                + guardText.size())));
+    }
+}
+
+string V3PreProcImp::includeGuard(const char* cp, const char* ep) {
+    // Return the define NAME if the text from cp to ep is all inside an
+    //     `ifndef NAME ... `endif
+    // with only whitespace and plain comments outside it, else "".
+    // This is a conservative scan; anything unusual means no guard.
+    string guard;
+    int depth = 0;  // `ifdef nesting, 0 = outside the guard
+    bool ended = false;  // Found the guard's `endif
+    while (cp < ep) {
+        if (isspace(*cp)) { ++cp; continue; }
+        if (cp[0]=='/' && (cp+1) < ep && (cp[1]=='/' || cp[1]=='*')) {
+            const char* startp = cp;
+            if (cp[1]=='/') {
+                while (cp < ep && *cp != '\n') ++cp;
+            } else {
+                cp += 2;
+                while ((cp+1) < ep && !(cp[0]=='*' && cp[1]=='/')) ++cp;
+                if ((cp+1) >= ep) return "";  // Unterminated
+                cp += 2;
+            }
+            // Comments outside the guard go to the parser even when the
+            // guard is defined, so they must not be metacomments
+            if (!depth && !commentIsPlain(string(startp, cp))) return "";
+            continue;
+        }
+        if (*cp == '`') {
+            const char* namep = ++cp;
+            while (cp < ep && (isalnum(*cp) || *cp=='_')) ++cp;
+            string directive (namep, cp);
+            if (!depth) {
+                if (directive != "ifndef" || ended) return "";  // Directive outside guard
+                while (cp < ep && isspace(*cp)) ++cp;
+                namep = cp;
+                while (cp < ep && (isalnum(*cp) || *cp=='_' || *cp=='$')) ++cp;
+                guard = string(namep, cp);
+                if (guard.empty()) return "";  // E.g. `ifndef `MACRO
+                depth = 1;
+            } else if (directive == "ifdef" || directive == "ifndef") {
+                ++depth;
+            } else if (directive == "endif") {
+                if (--depth == 0) ended = true;
+            } else if (directive == "else" || directive == "elsif") {
+                if (depth == 1) return "";  // Guard has an else part
+            } else if (directive == "define") {
+                // Skip the value, which may be continued with backslashes
+                while (cp < ep && *cp != '\n') {
+                    if (*cp == '\\' && (cp+1) < ep) ++cp;
+                    ++cp;
+                }
+            } else if (directive == "protected") {
+                return "";  // May not be text we understand
+            }
+            continue;
+        }
+        if (!depth) return "";  // Text outside guard
+        if (*cp == '"') {
+            for (++cp; cp < ep && *cp != '"'; ++cp) {
+                if (*cp == '\\') ++cp;
+            }
+        }
+        ++cp;
+    }
+    if (!ended) return "";
+    return guard;
+}
+
+bool V3PreProcImp::commentIsPlain(const string& text) {
+    // Return true if comment isn't a metacomment, see V3PreProcImp::comment
+    const char* cp = text.c_str() + 2;  // Skip // or /*
+    while (isspace(*cp)) cp++;
+    if ((cp[0]=='v' || cp[0]=='V') && 0==strncmp(cp+1, "erilator", 8)) return false;
+    static const char* const metas[] = {"synopsys", "cadence", "pragma", "ambit", NULL};
+    for (const char* const* metap = metas; *metap; ++metap) {
+        if (0==strncmp(cp, *metap, strlen(*metap))) return false;
+    }
+    return true;
 }
 
 void V3PreProcImp::insertUnreadbackAtBol(const string& text) {
@@ -36,6 +36,7 @@
 #include "V3Reloop.h"
 #include "V3Stats.h"
 #include "V3Ast.h"
+#include "V3ParallelCFunc.h"
 
 #include <algorithm>
 #include <cstdarg>
@@ -51,11 +52,13 @@ private:
 
     // NODE STATE
     // AstCFunc::user1p      -> Var* for temp var, 0=not set yet
-    AstUser1InUse       m_inuser1;
+    // AstUser1InUse is held by V3Reloop::reloopAll, as visitors run in parallel
 
+public:
     // STATE
     VDouble0            m_statReloops;  // Statistic tracking
     VDouble0            m_statReItems;  // Statistic tracking
+private:
     AstCFunc*           m_cfuncp;       // Current block
 
     AssVec              m_mgAssignps;   // List of assignments merging
@@ -147,6 +150,7 @@ private:
     virtual void visit(AstCFunc* nodep) VL_OVERRIDE {
         m_cfuncp = nodep;
         iterateChildren(nodep);
+        mergeEnd();  // Functions are visited separately, so can't merge into the next
         m_cfuncp = NULL;
     }
     virtual void visit(AstNodeAssign* nodep) VL_OVERRIDE {
@@ -231,7 +235,7 @@ private:
 
 public:
     // CONSTRUCTORS
-    explicit ReloopVisitor(AstNetlist* nodep) {
+    explicit ReloopVisitor(AstCFunc* nodep) {
         m_cfuncp = NULL;
         m_mgCfuncp = NULL;
         m_mgNextp = NULL;
@@ -244,9 +248,38 @@ public:
         m_mgIndexHi = 0;
         iterate(nodep);
     }
-    virtual ~ReloopVisitor() {
-        V3Stats::addStat("Optimizations, Reloops", m_statReloops);
-        V3Stats::addStat("Optimizations, Reloop iterations", m_statReItems);
+    virtual ~ReloopVisitor() {}
+};
+
+class ReloopJobs {
+    // Reloop each function as a V3ParallelCFunc job
+    std::vector<VDouble0> m_statReloops;  // Statistic tracking, per function
+    std::vector<VDouble0> m_statReItems;  // Statistic tracking, per function
+    static void reloopFunc(void* userp, AstCFunc* funcp, int index) {
+        ReloopJobs* jobsp = static_cast<ReloopJobs*>(userp);
+        ReloopVisitor visitor (funcp);
+        // Each job has its own slot, so no lock needed
+        jobsp->m_statReloops[index] = visitor.m_statReloops;
+        jobsp->m_statReItems[index] = visitor.m_statReItems;
+    }
+public:
+    // CONSTRUCTORS
+    explicit ReloopJobs(AstNetlist* nodep) {
+        AstUser1InUse inuser1;  // For ReloopVisitor
+        V3ParallelCFunc funcs (nodep);
+        m_statReloops.resize(funcs.size());
+        m_statReItems.resize(funcs.size());
+        funcs.forEach(&ReloopJobs::reloopFunc, this);
+    }
+    ~ReloopJobs() {
+        VDouble0 reloops;
+        VDouble0 reItems;
+        for (size_t i = 0; i < m_statReloops.size(); ++i) {
+            reloops += m_statReloops[i];
+            reItems += m_statReItems[i];
+        }
+        V3Stats::addStat("Optimizations, Reloops", reloops);
+        V3Stats::addStat("Optimizations, Reloop iterations", reItems);
     }
 };
 
@@ -256,7 +289,7 @@ public:
 void V3Reloop::reloopAll(AstNetlist* nodep) {
     UINFO(2,__FUNCTION__<<": "<<endl);
     {
-        ReloopVisitor visitor(nodep);
+        ReloopJobs jobs (nodep);
     }  // Destruct before checking
     V3Global::dumpCheckGlobalTree("reloop", 0, v3Global.opt.dumpTreeLevel(__FILE__) >= 6);
 }
@@ -47,8 +47,6 @@
 // Support classes
 
 namespace V3TSP {
-    static unsigned edgeIdNext = 0;
-
     static void selfTestStates();
     static void selfTestString();
 
@@ -80,9 +78,10 @@ public:
     // MEMBERS
     typedef vl_unordered_map<T_Key, Vertex*> VMap;
     VMap m_vertices;  // T_Key to Vertex lookup map
+    unsigned m_edgeIdNext;  // Last edge ID assigned
 
     // CONSTRUCTORS
-    TspGraphTmpl() : V3Graph() {}
+    TspGraphTmpl() : V3Graph(), m_edgeIdNext(0) {}
     virtual ~TspGraphTmpl() {}
 
     // METHODS
@@ -106,7 +105,7 @@ public:
         // The only time we may create duplicate edges is when
         // combining the MST with the perfect-matched pairs,
         // and in that case, we want to permit duplicate edges.
-        unsigned edgeId = ++V3TSP::edgeIdNext;
+        unsigned edgeId = ++m_edgeIdNext;
 
         // Record the 'id' which identifies a single bidir edge
         // in the user field of each V3GraphEdge:
@@ -18,6 +18,9 @@
 //      Count # of input bits and # of output bits, and # of statements
 //      If high # of statements relative to inpbits*outbits,
 //      replace with lookup table
+//      If a table indexed by all inputs is too large, try a two-level
+//      table where the upper input bits select a row, and identical
+//      rows are stored once
 //
 //*************************************************************************
 
@@ -33,15 +36,18 @@
 #include <cmath>
 #include <cstdarg>
 #include <deque>
+#include <map>
+#include <vector>
 
 //######################################################################
 // Table class functions
 
 // CONFIG
-static const double TABLE_MAX_BYTES = 1*1024*1024;  // 1MB is max table size (better be lots of instructs to be worth it!)
 static const double TABLE_TOTAL_BYTES = 64*1024*1024;  // 64MB is close to max memory of some systems (256MB or so), so don't get out of control
 static const double TABLE_SPACE_TIME_MULT = 8;  // Worth 8 bytes of data to replace a instruction
-static const int TABLE_MIN_NODE_COUNT = 32;  // If < 32 instructions, not worth the effort
+static const double TABLE_CACHE_BYTES = 256*1024;  // Larger tables probably miss in the L2 cache
+static const int TABLE_MISS_INSTRS = 64;  // A cache miss costs about this many instructions
+static const int TABLE_MAX_INPUTS = 24;  // Simulating 2^24 input values is already slow
 
 //######################################################################
 
@@ -66,12 +72,16 @@ public:
 
 class TableVisitor : public AstNVisitor {
 private:
+    // TYPES
+    typedef std::vector<AstConst*> TableEntry;  // Value of each output, then the change mask
+
     // NODE STATE
     // Cleared on each always/assignw
 
     // STATE
     double      m_totalBytes;           // Total bytes in tables created
     VDouble0    m_statTablesCre;        // Statistic tracking
+    VDouble0    m_statTablesSplit;      // Statistic tracking
 
     //  State cleared on each module
     AstNodeModule*      m_modp;         // Current MODULE
@@ -86,20 +96,45 @@ private:
     bool        m_assignDly;            // Consists of delayed assignments instead of normal assignments
     int         m_inWidth;              // Input table width
     int         m_outWidth;             // Output table width
+    int         m_instrCount;           // Instructions the table would replace
+    double      m_time;                 // Cost of the instructions the table would replace
+    bool        m_splitTable;           // Flat table too large, try a two-level table
     std::deque<AstVarScope*> m_inVarps;  // Input variable list
     std::deque<AstVarScope*> m_outVarps;        // Output variable list
     std::deque<bool>    m_outNotSet;            // True if output variable is not set at some point
 
+    // When simulating a table
+    std::vector<TableEntry> m_entries;  // Each distinct table entry
+    std::vector<uint32_t> m_entryIds;   // Entry number for each input value
+    int         m_splitLo;              // Input bits indexing within a row, 0 = flat table
+    int         m_splitWidth;           // Width of the second level index
+    std::vector<uint32_t> m_rowValues;  // Second level index base for each row, empty if one row
+    std::vector<uint32_t> m_slotEntries;  // Entry number for each table element
+    double      m_tableBytes;           // Bytes in the chosen tables
+
     // When creating a table
     std::deque<AstVarScope*> m_tableVarps;      // Table being created
 
     // METHODS
     VL_DEBUG_FUNC;  // Declare debug()
 
+    double entryBytes() const {
+        size_t chgWidth = m_outVarps.size();  // Width of one change-it-vector
+        if (chgWidth<8) chgWidth = 8;
+        return static_cast<double>(m_outWidth + chgWidth);
+    }
+    const char* tableCostProblem(double space) const {
+        // Return why a table of this size isn't worth it, or NULL if it is
+        if (space > v3Global.opt.tableMaxBytes()) return "Table takes too much space";
+        if (space > m_time * TABLE_SPACE_TIME_MULT) return "Table has bad tradeoff";
+        return NULL;
+    }
+
     bool treeTest(AstAlways* nodep) {
         // Process alw/assign tree
         m_inWidth = 0;
         m_outWidth = 0;
+        m_splitTable = false;
         m_inVarps.clear();
         m_outVarps.clear();
         m_outNotSet.clear();
@@ -114,22 +149,23 @@ private:
         // Also sets m_outVarps
 
         // Calc data storage in bytes
-        size_t chgWidth = m_outVarps.size();  // Width of one change-it-vector
-        if (chgWidth<8) chgWidth = 8;
-        double space = (pow(static_cast<double>(2.0), static_cast<double>(m_inWidth))
-                        * static_cast<double>(m_outWidth + chgWidth));
+        double space = pow(static_cast<double>(2.0), static_cast<double>(m_inWidth)) * entryBytes();
         // Instruction count bytes (ok, it's space also not time :)
         double bytesPerInst = 4;
-        double time = ((chkvis.instrCount()*bytesPerInst + chkvis.dataCount())
-                       + 1);  // +1 so won't div by zero
-        if (chkvis.instrCount() < TABLE_MIN_NODE_COUNT) {
+        m_instrCount = chkvis.instrCount();
+        m_time = ((chkvis.instrCount()*bytesPerInst + chkvis.dataCount())
+                  + 1);  // +1 so won't div by zero
+        if (chkvis.instrCount() < v3Global.opt.tableMinNodes()) {
             chkvis.clearOptimizable(nodep, "Table has too few nodes involved");
         }
-        if (space > TABLE_MAX_BYTES) {
-            chkvis.clearOptimizable(nodep, "Table takes too much space");
-        }
-        if (space > time * TABLE_SPACE_TIME_MULT) {
-            chkvis.clearOptimizable(nodep, "Table has bad tradeoff");
+        if (m_inWidth > TABLE_MAX_INPUTS) {
+            chkvis.clearOptimizable(nodep, "Table has too many inputs");
+        } else if (space > v3Global.opt.tableMaxBytes()
+                   && m_inWidth <= v3Global.opt.tableSplitInputs()) {
+            // Size of a two-level table isn't known until simulated
+            m_splitTable = true;
+        } else if (const char* whyp = tableCostProblem(space)) {
+            chkvis.clearOptimizable(nodep, whyp);
         }
         if (m_totalBytes > TABLE_TOTAL_BYTES) {
             chkvis.clearOptimizable(nodep, "Table out of memory");
@@ -140,11 +176,11 @@ private:
         UINFO(4, "  Test: Opt="<<(chkvis.optimizable()?"OK":"NO")
               <<", Instrs="<<chkvis.instrCount()<<" Data="<<chkvis.dataCount()
               <<" inw="<<m_inWidth<<" outw="<<m_outWidth
-              <<" Spacetime="<<(space/time)<<"("<<space<<"/"<<time<<")"
+              <<" Spacetime="<<(space/m_time)<<"("<<space<<"/"<<m_time<<")"
+              <<(m_splitTable?" split":"")
               <<": "<<nodep<<endl);
         if (chkvis.optimizable()) {
-            UINFO(3, " Table Optimize spacetime="<<(space/time)<<" "<<nodep<<endl);
-            m_totalBytes += space;
+            UINFO(3, " Table Optimize spacetime="<<(space/m_time)<<" "<<nodep<<endl);
         }
         return chkvis.optimizable();
     }
@@ -166,18 +202,227 @@ public:
     }
 
 private:
+    bool simulateTable(AstAlways* nodep) {
+        // Simulate every input value, and pick the table layout.
+        // Return false if no layout is worth it.
+        simulateEntries(nodep);
+
+        double flatBytes = static_cast<double>(m_entryIds.size()) * entryBytes();
+        int bestLo = 0;
+        double bestBytes = flatBytes;
+        if (m_splitTable) {
+            for (int lo = 1; lo < m_inWidth; ++lo) {
+                double bytes = splitLayout(lo, false);
+                UINFO(8, "   Split lo="<<lo<<" bytes="<<bytes<<endl);
+                if (bytes < bestBytes) {
+                    bestLo = lo;
+                    bestBytes = bytes;
+                }
+            }
+            const char* whyp = tableCostProblem(bestBytes);
+            // A table too big for the cache may miss on every read,
+            // including the row lookup
+            size_t reads = m_outVarps.size() + (bestLo ? 2 : 1);
+            if (!whyp && bestBytes > TABLE_CACHE_BYTES
+                && m_instrCount < static_cast<int>(TABLE_MISS_INSTRS * reads)) {
+                whyp = "Table too large to stay in cache";
+            }
+            if (whyp) {
+                UINFO(4, "  Split table abandoned: "<<whyp<<" lo="<<bestLo
+                      <<" ("<<bestBytes<<"/"<<m_time<<"): "<<nodep<<endl);
+                return false;
+            }
+            UINFO(3, " Table Optimize split lo="<<bestLo<<" bytes="<<bestBytes
+                  <<" flat="<<flatBytes<<" "<<nodep<<endl);
+        }
+        m_splitLo = bestLo;
+        m_tableBytes = bestBytes;
+        if (m_splitLo) {
+            splitLayout(m_splitLo, true);
+        } else {
+            m_splitWidth = 0;
+            m_rowValues.clear();
+            m_slotEntries = m_entryIds;
+        }
+        return true;
+    }
+
+    void simulateEntries(AstAlways* nodep) {
+        // Simulate each input value, and record which entry it produces.
+        // There may be a simulation path by which the output doesn't change value.
+        // We could bail on these cases, or we can have a "change it" boolean.
+        // We've chosen the latter route, since recirc is common in large FSMs.
+        for (std::deque<AstVarScope*>::iterator it = m_outVarps.begin();
+             it != m_outVarps.end(); ++it) {
+            m_outNotSet.push_back(false);
+        }
+        typedef std::map<string,uint32_t> EntryMap;
+        EntryMap entryMap;  // Key is the output values
+        TableSimulateVisitor simvis (this);
+        for (uint32_t inValue=0; inValue <= VL_MASK_I(m_inWidth); inValue++) {
+            // Make a new simulation structure so we can set new input values
+            UINFO(8," Simulating "<<std::hex<<inValue<<endl);
+
+            // Above simulateVisitor clears user 3, so
+            // all outputs default to NULL to mean 'recirculating'.
+            simvis.clear();
+
+            // Set all inputs to the constant
+            uint32_t shift = 0;
+            for (std::deque<AstVarScope*>::iterator it = m_inVarps.begin();
+                 it != m_inVarps.end(); ++it) {
+                AstVarScope* invscp = *it;
+                // LSB is first variable, so extract it that way
+                AstConst cnst(invscp->fileline(), AstConst::WidthedValue(), invscp->width(),
+                              VL_MASK_I(invscp->width()) & (inValue>>shift));
+                simvis.newValue(invscp, &cnst);
+                shift += invscp->width();
+                // We're just using32 bit arithmetic, because there's no
+                // way the input table can be 2^32 bytes!
+                UASSERT_OBJ(shift <= 32, nodep, "shift overflow");
+                UINFO(8,"   Input "<<invscp->name()<<" = "<<cnst.name()<<endl);
+            }
+
+            // Simulate
+            simvis.mainTableEmulate(nodep);
+            UASSERT_OBJ(simvis.optimizable(), simvis.whyNotNodep(),
+                        "Optimizable cleared, even though earlier test run said not: "
+                        <<simvis.whyNotMessage());
+
+            // Find the output values
+            std::vector<V3Number*> outnumps;
+            string key;
+            int outnum = 0;
+            for (std::deque<AstVarScope*>::iterator it = m_outVarps.begin();
+                 it != m_outVarps.end(); ++it) {
+                AstVarScope* outvscp = *it;
+                V3Number* outnump = simvis.fetchOutNumberNull(outvscp);
+                if (!outnump) {
+                    UINFO(8,"   Output "<<outvscp->name()<<" never set\n");
+                    m_outNotSet[outnum] = true;
+                    key += "-";
+                } else {
+                    UINFO(8,"   Output "<<outvscp->name()<<" = "<<*outnump<<endl);
+                    key += outnump->ascii();
+                }
+                key += ",";
+                outnumps.push_back(outnump);
+                outnum++;
+            }
+
+            // Many input values produce the same entry, so only keep each once
+            EntryMap::iterator eit = entryMap.find(key);
+            if (eit != entryMap.end()) {
+                m_entryIds.push_back(eit->second);
+                continue;
+            }
+            uint32_t entryId = m_entries.size();
+            entryMap.insert(make_pair(key, entryId));
+            m_entryIds.push_back(entryId);
+
+            // If a output changed, add it to table
+            TableEntry entry;
+            outnum = 0;
+            V3Number outputChgMask (nodep, m_outVarps.size(), 0);
+            for (std::deque<AstVarScope*>::iterator it = m_outVarps.begin();
+                 it != m_outVarps.end(); ++it) {
+                AstVarScope* outvscp = *it;
+                V3Number* outnump = outnumps[outnum];
+                if (!outnump) {
+                    // Value in table is arbitrary, but we need something
+                    entry.push_back(new AstConst(outvscp->fileline(),
+                                                 AstConst::WidthedValue(), outvscp->width(), 0));
+                } else {
+                    // Mark changed bit, too
+                    outputChgMask.setBit(outnum, 1);
+                    entry.push_back(new AstConst(outnump->fileline(), *outnump));
+                }
+                outnum++;
+            }
+            entry.push_back(new AstConst(nodep->fileline(), outputChgMask));
+            m_entries.push_back(entry);
+        }  // each value
+        UINFO(4, "  Table entries "<<m_entries.size()<<" for "<<m_entryIds.size()
+              <<" input values"<<endl);
+    }
+
+    double splitLayout(int lo, bool create) {
+        // Two-level table: the input bits above 'lo' select a row, and
+        // rows with identical entries share storage.  Return bytes needed.
+        typedef std::map<std::vector<uint32_t>,uint32_t> RowMap;
+        RowMap rowMap;  // Class number of each distinct row
+        std::vector<uint32_t> rowClasses;  // Class number for each row
+        std::vector<uint32_t> classRows;  // First row of each class
+        uint32_t rowEntries = 1U << lo;
+        uint32_t rows = static_cast<uint32_t>(m_entryIds.size()) >> lo;
+        for (uint32_t row = 0; row < rows; ++row) {
+            std::vector<uint32_t> key (m_entryIds.begin() + (row << lo),
+                                       m_entryIds.begin() + ((row + 1) << lo));
+            std::pair<RowMap::iterator,bool> ins
+                = rowMap.insert(make_pair(key, static_cast<uint32_t>(classRows.size())));
+            if (ins.second) classRows.push_back(row);
+            rowClasses.push_back(ins.first->second);
+        }
+        uint32_t classes = classRows.size();
+        int classWidth = 0;
+        while ((1U << classWidth) < classes) ++classWidth;
+        int width = classWidth + lo;
+        double bytes = static_cast<double>(classes) * rowEntries * entryBytes();
+        if (classes > 1) {
+            // Row table elements are char, 16 or 32 bits, as with outputs
+            double rowBytes = width <= 8 ? 1 : width <= 16 ? 2 : 4;
+            bytes += rows * rowBytes;
+        }
+        if (create) {
+            m_splitWidth = width;
+            m_rowValues.clear();
+            if (classes > 1) {
+                for (uint32_t row = 0; row < rows; ++row) {
+                    m_rowValues.push_back(rowClasses[row] << lo);
+                }
+            }
+            m_slotEntries.clear();
+            for (uint32_t cls = 0; cls < classes; ++cls) {
+                for (uint32_t ent = 0; ent < rowEntries; ++ent) {
+                    m_slotEntries.push_back(m_entryIds[(classRows[cls] << lo) | ent]);
+                }
+            }
+        }
+        return bytes;
+    }
+
+    void clearEntries() {
+        for (std::vector<TableEntry>::iterator it = m_entries.begin();
+             it != m_entries.end(); ++it) {
+            for (TableEntry::iterator cit = it->begin(); cit != it->end(); ++cit) {
+                VL_DO_DANGLING((*cit)->deleteTree(), *cit);
+            }
+        }
+        m_entries.clear();
+        m_entryIds.clear();
+        m_rowValues.clear();
+        m_slotEntries.clear();
+    }
+
+    AstVarScope* createIndexVar(AstNode* nodep, const string& name, int width) {
+        AstVar* indexVarp = new AstVar(nodep->fileline(), AstVarType::BLOCKTEMP,
+                                       name, VFlagBitPacked(), width);
+        m_modp->addStmtp(indexVarp);
+        AstVarScope* indexVscp = new AstVarScope(indexVarp->fileline(), m_scopep, indexVarp);
+        m_scopep->addVarp(indexVscp);
+        return indexVscp;
+    }
+
     void createTable(AstAlways* nodep) {
         // We've determined this table of nodes is optimizable, do it.
         ++m_modTables;
         ++m_statTablesCre;
+        if (m_splitLo) ++m_statTablesSplit;
+        m_totalBytes += m_tableBytes;
 
         // Index into our table
-        AstVar* indexVarp = new AstVar(nodep->fileline(), AstVarType::BLOCKTEMP,
-                                       "__Vtableidx" + cvtToStr(m_modTables),
-                                       VFlagBitPacked(), m_inWidth);
-        m_modp->addStmtp(indexVarp);
-        AstVarScope* indexVscp = new AstVarScope(indexVarp->fileline(), m_scopep, indexVarp);
-        m_scopep->addVarp(indexVscp);
+        AstVarScope* indexVscp = createIndexVar(nodep, "__Vtableidx" + cvtToStr(m_modTables),
+                                                m_inWidth);
 
         // Change it variable
         FileLine* fl = nodep->fileline();
@@ -185,7 +430,7 @@ private:
             = new AstUnpackArrayDType(fl,
                                       nodep->findBitDType(m_outVarps.size(),
                                                           m_outVarps.size(), AstNumeric::UNSIGNED),
-                                      new AstRange(fl, VL_MASK_I(m_inWidth), 0));
+                                      new AstRange(fl, m_slotEntries.size() - 1, 0));
         v3Global.rootp()->typeTablep()->addTypesp(dtypep);
         AstVar* chgVarp
             = new AstVar(fl, AstVarType::MODULETEMP,
@@ -199,6 +444,7 @@ private:
 
         createTableVars(nodep);
         AstNode* stmtsp = createLookupInput(nodep, indexVscp);
+        if (m_splitLo) indexVscp = createLookupSplit(nodep, stmtsp, indexVscp);
         createTableValues(nodep, chgVscp);
 
         // Collapse duplicate tables
@@ -235,7 +481,7 @@ private:
             FileLine* fl = nodep->fileline();
             AstNodeArrayDType* dtypep
                 = new AstUnpackArrayDType(fl, outvarp->dtypep(),
-                                          new AstRange(fl, VL_MASK_I(m_inWidth), 0));
+                                          new AstRange(fl, m_slotEntries.size() - 1, 0));
             v3Global.rootp()->typeTablep()->addTypesp(dtypep);
             string name = "__Vtable"+cvtToStr(m_modTables)+"_"+outvarp->name();
             NameCounts::iterator nit = namecounts.find(name);
@@ -276,81 +522,60 @@ private:
         return stmtsp;
     }
 
-    void createTableValues(AstAlways* nodep, AstVarScope* chgVscp) {
-        // Create table
-        // There may be a simulation path by which the output doesn't change value.
-        // We could bail on these cases, or we can have a "change it" boolean.
-        // We've chosen the latter route, since recirc is common in large FSMs.
-        for (std::deque<AstVarScope*>::iterator it = m_outVarps.begin();
-             it != m_outVarps.end(); ++it) {
-            m_outNotSet.push_back(false);
-        }
-        uint32_t inValueNextInitArray = 0;
-        TableSimulateVisitor simvis (this);
-        for (uint32_t inValue=0; inValue <= VL_MASK_I(m_inWidth); inValue++) {
-            // Make a new simulation structure so we can set new input values
-            UINFO(8," Simulating "<<std::hex<<inValue<<endl);
-
-            // Above simulateVisitor clears user 3, so
-            // all outputs default to NULL to mean 'recirculating'.
-            simvis.clear();
-
-            // Set all inputs to the constant
-            uint32_t shift = 0;
-            for (std::deque<AstVarScope*>::iterator it = m_inVarps.begin();
-                 it != m_inVarps.end(); ++it) {
-                AstVarScope* invscp = *it;
-                // LSB is first variable, so extract it that way
-                AstConst cnst(invscp->fileline(), AstConst::WidthedValue(), invscp->width(),
-                              VL_MASK_I(invscp->width()) & (inValue>>shift));
-                simvis.newValue(invscp, &cnst);
-                shift += invscp->width();
-                // We're just using32 bit arithmetic, because there's no
-                // way the input table can be 2^32 bytes!
-                UASSERT_OBJ(shift <= 32, nodep, "shift overflow");
-                UINFO(8,"   Input "<<invscp->name()<<" = "<<cnst.name()<<endl);
-            }
-
-            // Simulate
-            simvis.mainTableEmulate(nodep);
-            UASSERT_OBJ(simvis.optimizable(), simvis.whyNotNodep(),
-                        "Optimizable cleared, even though earlier test run said not: "
-                        <<simvis.whyNotMessage());
-
-            // If a output changed, add it to table
-            int outnum = 0;
-            V3Number outputChgMask (nodep, m_outVarps.size(), 0);
-            for (std::deque<AstVarScope*>::iterator it = m_outVarps.begin();
-                 it != m_outVarps.end(); ++it) {
-                AstVarScope* outvscp = *it;
-                V3Number* outnump = simvis.fetchOutNumberNull(outvscp);
-                AstNode* setp;
-                if (!outnump) {
-                    UINFO(8,"   Output "<<outvscp->name()<<" never set\n");
-                    m_outNotSet[outnum] = true;
-                    // Value in table is arbitrary, but we need something
-                    setp = new AstConst(outvscp->fileline(),
-                                        AstConst::WidthedValue(), outvscp->width(), 0);
-                } else {
-                    UINFO(8,"   Output "<<outvscp->name()<<" = "<<*outnump<<endl);
-                    //  m_tableVarps[inValue] = num;
-                    // Mark changed bit, too
-                    outputChgMask.setBit(outnum, 1);
-                    setp = new AstConst(outnump->fileline(), *outnump);
-                }
-                // Note InitArray requires us to have the values in inValue order
-                VN_CAST(m_tableVarps[outnum]->varp()->valuep(), InitArray)->addValuep(setp);
-                outnum++;
+    AstVarScope* createLookupSplit(AstNode* nodep, AstNode* stmtsp, AstVarScope* indexVscp) {
+        // Second level index: the high input bits look up where their row
+        // starts, and the low input bits select within the row
+        FileLine* fl = nodep->fileline();
+        AstVarScope* index2Vscp = createIndexVar(nodep, "__Vtableidx" + cvtToStr(m_modTables)
+                                                 + "_2", m_splitWidth);
+        AstNode* lop = new AstSel(fl, new AstVarRef(fl, indexVscp, false), 0, m_splitLo);
+        AstNode* rhsp = lop;
+        if (!m_rowValues.empty()) {
+            AstNodeArrayDType* dtypep
+                = new AstUnpackArrayDType(fl,
+                                          nodep->findBitDType(m_splitWidth, m_splitWidth,
+                                                              AstNumeric::UNSIGNED),
+                                          new AstRange(fl, m_rowValues.size() - 1, 0));
+            v3Global.rootp()->typeTablep()->addTypesp(dtypep);
+            AstVar* rowVarp = new AstVar(fl, AstVarType::MODULETEMP,
+                                         "__Vtable" + cvtToStr(m_modTables) + "_row", dtypep);
+            rowVarp->isConst(true);
+            rowVarp->isStatic(true);
+            AstInitArray* initp = new AstInitArray(fl, dtypep, NULL);
+            for (std::vector<uint32_t>::const_iterator it = m_rowValues.begin();
+                 it != m_rowValues.end(); ++it) {
+                initp->addValuep(new AstConst(fl, AstConst::WidthedValue(), m_splitWidth, *it));
             }
+            rowVarp->valuep(initp);
+            m_modp->addStmtp(rowVarp);
+            AstVarScope* rowVscp = new AstVarScope(rowVarp->fileline(), m_scopep, rowVarp);
+            m_scopep->addVarp(rowVscp);
+            rowVscp = findDuplicateTable(rowVscp);
+
+            AstNode* hip = new AstSel(fl, new AstVarRef(fl, indexVscp, false),
+                                      m_splitLo, m_inWidth - m_splitLo);
+            rhsp = new AstOr(fl,
+                             new AstArraySel(fl, new AstVarRef(fl, rowVscp, false), hip),
+                             new AstExtend(fl, lop, m_splitWidth));
+        }
+        stmtsp->addNext(new AstAssign(fl, new AstVarRef(fl, index2Vscp, true), rhsp));
+        return index2Vscp;
+    }
 
-            {   // Set changed table
-                UASSERT_OBJ(inValue == inValueNextInitArray, nodep,
-                            "InitArray requires us to have the values in inValue order");
-                inValueNextInitArray++;
-                AstNode* setp = new AstConst(nodep->fileline(), outputChgMask);
-                VN_CAST(chgVscp->varp()->valuep(), InitArray)->addValuep(setp);
+    void createTableValues(AstAlways* nodep, AstVarScope* chgVscp) {
+        // Fill in each table from the simulated entries.
+        // Note InitArray requires us to have the values in index order
+        for (std::vector<uint32_t>::const_iterator it = m_slotEntries.begin();
+             it != m_slotEntries.end(); ++it) {
+            const TableEntry& entry = m_entries[*it];
+            for (size_t outnum = 0; outnum < m_outVarps.size(); ++outnum) {
+                VN_CAST(m_tableVarps[outnum]->varp()->valuep(), InitArray)
+                    ->addValuep(entry[outnum]->cloneTree(false));
             }
-        }  // each value
+            // Set changed table
+            VN_CAST(chgVscp->varp()->valuep(), InitArray)
+                ->addValuep(entry[m_outVarps.size()]->cloneTree(false));
+        }
     }
 
     AstVarScope* findDuplicateTable(AstVarScope* vsc1p) {
@@ -445,10 +670,11 @@ private:
     }
     virtual void visit(AstAlways* nodep) VL_OVERRIDE {
         UINFO(4,"  ALWAYS  "<<nodep<<endl);
-        if (treeTest(nodep)) {
+        if (treeTest(nodep) && simulateTable(nodep)) {
             // Well, then, I'll be a memory hog.
             VL_DO_DANGLING(createTable(nodep), nodep);
         }
+        clearEntries();
     }
     virtual void visit(AstAssignAlias* nodep) VL_OVERRIDE {}
     virtual void visit(AstAssignW* nodep) VL_OVERRIDE {
@@ -469,11 +695,18 @@ public:
         m_assignDly = 0;
         m_inWidth = 0;
         m_outWidth = 0;
+        m_instrCount = 0;
+        m_time = 0;
+        m_splitTable = false;
+        m_splitLo = 0;
+        m_splitWidth = 0;
+        m_tableBytes = 0;
         m_totalBytes = 0;
         iterate(nodep);
     }
     virtual ~TableVisitor() {
         V3Stats::addStat("Optimizations, Tables created", m_statTablesCre);
+        V3Stats::addStat("Optimizations, Tables created two-level", m_statTablesSplit);
     }
 };
 
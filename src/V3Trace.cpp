@@ -39,6 +39,8 @@
 //      Assign trace codes:
 //              If from a VARSCOPE, record the trace->varscope map
 //              Else, assign trace codes to each variable
+//      With --threads and VCD, if large enough
+//              Split the change function's statements into a group per thread
 //
 //*************************************************************************
 
@@ -52,6 +54,7 @@
 #include "V3Hashed.h"
 #include "V3Stats.h"
 
+#include <algorithm>
 #include <cstdarg>
 #include <map>
 #include <set>
@@ -178,6 +181,7 @@ private:
     AstCFunc*           m_chgSubFuncp;  // Trace function we add statements to (under full)
     AstNode*            m_chgSubParentp;// Which node has call to m_chgSubFuncp
     int                 m_chgSubStmts;  // Statements under function being built
+    std::map<const AstCFunc*, int> m_chgSubCosts;  // Statements under each chg sub function
     AstVarScope*        m_activityVscp; // Activity variable
     uint32_t            m_activityNumber;  // Count of fields in activity variable
     uint32_t            m_code;         // Trace ident code# being assigned
@@ -189,6 +193,7 @@ private:
     VDouble0 m_statChgSigs;  // Statistic tracking
     VDouble0 m_statUniqSigs;  // Statistic tracking
     VDouble0 m_statUniqCodes;  // Statistic tracking
+    VDouble0 m_statChgGroups;  // Statistic tracking
 
     // METHODS
     VL_DEBUG_FUNC;  // Declare debug()
@@ -413,7 +418,56 @@ private:
             m_chgSubStmts = 0;
         }
         m_chgSubFuncp->addStmtsp(stmtsp);
-        m_chgSubStmts += EmitCBaseCounterVisitor(stmtsp).count();
+        int count = EmitCBaseCounterVisitor(stmtsp).count();
+        m_chgSubStmts += count;
+        m_chgSubCosts[m_chgSubFuncp] += count;
+    }
+
+    int chgStmtCost(AstNode* stmtp) {
+        // Statements a top-level statement of m_chgFuncp will execute
+        if (AstCCall* callp = VN_CAST(stmtp, CCall)) return m_chgSubCosts[callp->funcp()];
+        int cost = 0;
+        if (AstIf* ifp = VN_CAST(stmtp, If)) {
+            for (AstNode* nodep = ifp->ifsp(); nodep; nodep = nodep->nextp()) {
+                if (AstCCall* callp = VN_CAST(nodep, CCall)) {
+                    cost += m_chgSubCosts[callp->funcp()];
+                }
+            }
+        }
+        return cost;
+    }
+    void groupChgForThreads() {
+        // Split the change function's statements into contiguous groups of
+        // similar cost, one per thread. As trace codes were assigned in
+        // statement order, each group dumps a disjoint, ascending range of
+        // codes, which V3EmitC collects in parallel then merges in order.
+        int total = 0;
+        for (AstNode* stmtp = m_chgFuncp->stmtsp(); stmtp; stmtp = stmtp->nextp()) {
+            total += chgStmtCost(stmtp);
+        }
+        int groups = std::min(v3Global.opt.threads(),
+                              total / v3Global.opt.traceParallelStmts());
+        if (groups < 2) return;
+        UINFO(4, "  Trace change groups: "<<groups<<" over "<<total<<" statements"<<endl);
+        AstNode* stmtsp = m_chgFuncp->stmtsp()->unlinkFrBackWithNext();
+        AstCFunc* groupp = NULL;
+        int group = 0;
+        int cost = 0;
+        for (AstNode* nextp, *stmtp = stmtsp; stmtp; stmtp = nextp) {
+            nextp = stmtp->nextp();
+            if (nextp) nextp->unlinkFrBackWithNext();
+            if (!groupp || (cost >= (total * (group + 1)) / groups && group + 1 < groups)) {
+                if (groupp) ++group;
+                groupp = newCFunc(AstCFuncType::TRACE_CHANGE_GROUP,
+                                  m_chgFuncp->name()+"__Vgroup"+cvtToStr(group), m_chgFuncp);
+                AstCCall* callp = new AstCCall(groupp->fileline(), groupp);
+                callp->argTypes("vlSymsp, vcdp, code");
+                m_chgFuncp->addStmtsp(callp);
+            }
+            cost += chgStmtCost(stmtp);
+            groupp->addStmtsp(stmtp);
+        }
+        m_statChgGroups += group + 1;
     }
 
     void putTracesIntoTree() {
@@ -634,6 +688,10 @@ private:
         // Create new TRACEINCs
         assignActivity();
         putTracesIntoTree();
+        if (v3Global.opt.mtasks() && v3Global.opt.traceFormat().vcdFlavor()
+            && v3Global.opt.traceParallelStmts() > 0 && m_chgFuncp->stmtsp()) {
+            groupChgForThreads();
+        }
     }
     virtual void visit(AstNodeModule* nodep) VL_OVERRIDE {
         if (nodep->isTop()) m_topModp = nodep;
@@ -757,6 +815,7 @@ public:
         V3Stats::addStat("Tracing, Unique changing signals", m_statChgSigs);
         V3Stats::addStat("Tracing, Unique traced signals", m_statUniqSigs);
         V3Stats::addStat("Tracing, Unique trace codes", m_statUniqCodes);
+        V3Stats::addStat("Tracing, Parallel change groups", m_statChgGroups);
     }
 };
 
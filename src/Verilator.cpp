@@ -50,6 +50,7 @@
 #include "V3Gate.h"
 #include "V3GenClk.h"
 #include "V3Graph.h"
+#include "V3HierBlock.h"
 #include "V3Inline.h"
 #include "V3Inst.h"
 #include "V3Life.h"
@@ -131,6 +132,18 @@ static void process() {
     V3Dead::deadifyModules(v3Global.rootp());
     v3Global.checkTree();
 
+    // Verilate hier blocks separately, then the rest of the design using them
+    if (v3Global.opt.hierarchical()
+        && !v3Global.opt.lintOnly()
+        && !v3Global.opt.xmlOnly()
+        && !v3Global.opt.dpiHdrOnly()
+        && !v3Global.opt.cdc()
+        && V3HierBlock::verilate(v3Global.rootp())) {
+        // Child runs made all output files; nothing more for this run to do
+        V3Error::abortIfWarnings();
+        exit(0);
+    }
+
     // Calculate and check widths, edit tree to TRUNC/EXTRACT any width mismatches
     V3Width::width(v3Global.rootp());
 
@@ -559,31 +572,41 @@ int main(int argc, char** argv, char** env) {
         exit(0);
     }
 
-    //--FRONTEND------------------
-
-    // Cleanup
-    V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.tree");
-    V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.dot");
-    V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.txt");
-
-    // Internal tests (after option parsing as need debug() setting,
-    // and after removing files as may make debug output)
-    AstBasicDTypeKwd::selfTest();
-    if (v3Global.opt.debugSelfTest()) {
-        VHashSha256::selfTest();
-        VSpellCheck::selfTest();
-        V3Graph::selfTest();
-        V3TSP::selfTest();
-        V3ScoreboardBase::selfTest();
-        V3Partition::selfTest();
-    }
+    // Can we reuse output files from the cache?
+    // Not with -E or --lint-only, as their output is the messages
+    const bool useCache = !v3Global.opt.cacheDir().empty()
+        && !v3Global.opt.preprocOnly()
+        && !v3Global.opt.lintOnly();
+    const bool fromCache = useCache && V3File::readCache(v3Global.opt.cacheDir(), argString);
+    if (fromCache) {
+        UINFO(1,"--cache-dir: Restored output files from cache\n");
+    } else {
+        //--FRONTEND------------------
 
-    // Read first filename
-    v3Global.readFiles();
+        // Cleanup
+        V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.tree");
+        V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.dot");
+        V3Os::unlinkRegexp(v3Global.opt.makeDir(), v3Global.opt.prefix()+"_*.txt");
+
+        // Internal tests (after option parsing as need debug() setting,
+        // and after removing files as may make debug output)
+        AstBasicDTypeKwd::selfTest();
+        if (v3Global.opt.debugSelfTest()) {
+            VHashSha256::selfTest();
+            VSpellCheck::selfTest();
+            V3Graph::selfTest();
+            V3TSP::selfTest();
+            V3ScoreboardBase::selfTest();
+            V3Partition::selfTest();
+        }
+
+        // Read first filename
+        v3Global.readFiles();
 
-    // Link, etc, if needed
-    if (!v3Global.opt.preprocOnly()) {
-        process();
+        // Link, etc, if needed
+        if (!v3Global.opt.preprocOnly()) {
+            process();
+        }
     }
 
     // Final steps
@@ -597,9 +620,12 @@ int main(int argc, char** argv, char** env) {
         V3File::writeTimes(v3Global.opt.makeDir()+"/"+v3Global.opt.prefix()
                            +"__verFiles.dat", argString);
     }
-    if (v3Global.opt.protectIds()) {
+    if (v3Global.opt.protectIds() && !fromCache) {
         VIdProtect::writeMapFile(v3Global.opt.makeDir()+"/"+v3Global.opt.prefix()+"__idmap.xml");
     }
+    if (useCache && !fromCache) {
+        V3File::writeCache(v3Global.opt.cacheDir(), argString);
+    }
 
     // Final writing shouldn't throw warnings, but...
     V3Error::abortIfWarnings();
@@ -20,6 +20,8 @@
 #include "config_build.h"
 #include "verilatedos.h"
 
+#include <algorithm>
+
 //********************************************************************
 // VlcBuckets - Container of all coverage point hits for a given test
 // This is a bitmap array - we store a single bit to indicate a test
@@ -34,7 +36,18 @@ private:
 
 private:
     static inline vluint64_t covBit(vluint64_t point) { return 1ULL << (point & 63); }
+    static inline vluint64_t countOnes(vluint64_t word) {
+#ifdef __GNUC__
+        return __builtin_popcountll(word);
+#else
+        word = word - ((word >> 1) & 0x5555555555555555ULL);
+        word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+        word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        return (word * 0x0101010101010101ULL) >> 56;
+#endif
+    }
     inline vluint64_t allocSize() const { return sizeof(vluint64_t) * m_dataSize / 64; }
+    inline vluint64_t words() const { return m_dataSize / 64; }
     void allocate(vluint64_t point) {
         vluint64_t oldsize = m_dataSize;
         if (m_dataSize < point) m_dataSize = (point + 64) & ~63ULL;  // Keep power of two
@@ -98,24 +111,23 @@ public:
             return (m_datap[point / 64] & covBit(point)) ? 1 : 0;
         }
     }
+    // Whole words at a time, as these are the inner loops of ranking
     vluint64_t popCount() const {
         vluint64_t pop = 0;
-        for (vluint64_t i = 0; i < m_dataSize; i++) {
-            if (hits(i)) pop++;
-        }
+        for (vluint64_t w = 0; w < words(); w++) pop += countOnes(m_datap[w]);
         return pop;
     }
-    vluint64_t dataPopCount(const VlcBuckets& remaining) {
+    // Number of points hit both here and in remaining
+    vluint64_t dataPopCount(const VlcBuckets& remaining) const {
         vluint64_t pop = 0;
-        for (vluint64_t i = 0; i < m_dataSize; i++) {
-            if (hits(i) && remaining.hits(i)) pop++;
-        }
+        vluint64_t n = std::min(words(), remaining.words());
+        for (vluint64_t w = 0; w < n; w++) pop += countOnes(m_datap[w] & remaining.m_datap[w]);
         return pop;
     }
+    // Clear points that are hit in ordata
     void orData(const VlcBuckets& ordata) {
-        for (vluint64_t i = 0; i < m_dataSize; i++) {
-            if (hits(i) && ordata.hits(i)) clearHits(i);
-        }
+        vluint64_t n = std::min(words(), ordata.words());
+        for (vluint64_t w = 0; w < n; w++) m_datap[w] &= ~ordata.m_datap[w];
     }
 
     void dump() const {
@@ -92,6 +92,10 @@ void VlcOptions::parseOptsList(int argc, char** argv) {
             } else if (!strcmp(sw, "-annotate") && (i + 1) < argc) {
                 shift;
                 m_annotateOut = argv[i];
+            } else if (!strcmp(sw, "-jobs") && (i + 1) < argc) {
+                shift;
+                m_jobs = atoi(argv[i]);
+                if (m_jobs < 0) v3fatal("--jobs must be >= 0: " << argv[i]);
             } else if (!strcmp(sw, "-debug")) {
                 V3Error::debugDefault(3);
             } else if (!strcmp(sw, "-debugi") && (i + 1) < argc) {
@@ -106,6 +110,9 @@ void VlcOptions::parseOptsList(int argc, char** argv) {
             } else if (!strcmp(sw, "-write") && (i + 1) < argc) {
                 shift;
                 m_writeFile = argv[i];
+            } else if (!strcmp(sw, "-write-binary") && (i + 1) < argc) {
+                shift;
+                m_writeBinaryFile = argv[i];
             } else {
                 v3fatal("Invalid option: " << argv[i]);
             }
@@ -150,13 +157,7 @@ int main(int argc, char** argv, char** env) {
 
     if (top.opt.readFiles().empty()) top.opt.addReadFile("vlt_coverage.dat");
 
-    {
-        const VlStringSet& readFiles = top.opt.readFiles();
-        for (VlStringSet::const_iterator it = readFiles.begin(); it != readFiles.end(); ++it) {
-            string filename = *it;
-            top.readCoverage(filename);
-        }
-    }
+    top.readCoverages(top.opt.readFiles());
 
     if (debug() >= 9) {
         top.tests().dump(true);
@@ -171,8 +172,11 @@ int main(int argc, char** argv, char** env) {
         top.tests().dump(false);
     }
 
-    if (!top.opt.writeFile().empty()) {
-        top.writeCoverage(top.opt.writeFile());
+    if (!top.opt.writeFile().empty() || !top.opt.writeBinaryFile().empty()) {
+        if (!top.opt.writeFile().empty()) top.writeCoverage(top.opt.writeFile());
+        if (!top.opt.writeBinaryFile().empty()) {
+            top.writeCoverageBinary(top.opt.writeBinaryFile());
+        }
         V3Error::abortIfWarnings();
         if (top.opt.unlink()) {
             const VlStringSet& readFiles = top.opt.readFiles();
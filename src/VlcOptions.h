@@ -37,10 +37,12 @@ class VlcOptions {
     string m_annotateOut;       // main switch: --annotate I<output_directory>
     bool m_annotateAll;         // main switch: --annotate-all
     int m_annotateMin;          // main switch: --annotate-min I<count>
+    int m_jobs;                 // main switch: --jobs I<count>
     VlStringSet m_readFiles;    // main switch: --read
     bool m_rank;                // main switch: --rank
     bool m_unlink;              // main switch: --unlink
     string m_writeFile;         // main switch: --write
+    string m_writeBinaryFile;   // main switch: --write-binary
 
 private:
     // METHODS
@@ -52,6 +54,7 @@ public:
     VlcOptions() {
         m_annotateAll = false;
         m_annotateMin = 10;
+        m_jobs = 1;
         m_rank = false;
         m_unlink = false;
     }
@@ -67,9 +70,11 @@ public:
     string annotateOut() const { return m_annotateOut; }
     bool annotateAll() const { return m_annotateAll; }
     int annotateMin() const { return m_annotateMin; }
+    int jobs() const { return m_jobs; }
     bool rank() const { return m_rank; }
     bool unlink() const { return m_unlink; }
     string writeFile() const { return m_writeFile; }
+    string writeBinaryFile() const { return m_writeBinaryFile; }
 
     // METHODS (from main)
     static string version();
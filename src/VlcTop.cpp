@@ -21,22 +21,96 @@
 
 #include <algorithm>
 #include <fstream>
+#include <queue>
+#include <sstream>
 #include <sys/stat.h>
+#ifdef VL_PARALLEL_THREADS
+# include <thread>
+#endif
 
 //######################################################################
 
-void VlcTop::readCoverage(const string& filename, bool nonfatal) {
-    UINFO(2, "readCoverage " << filename << endl);
+//######################################################################
+// VlcCoverageFile - Contents of one coverage file, read before merging
 
-    std::ifstream is(filename.c_str());
+class VlcCoverageFile {
+public:
+    // MEMBERS
+    VlcTest* m_testp;  //< Test to add the file's hits to
+    bool m_binary;  //< Read from the binary format
+    string m_names;  //< Binary: name table, NUL terminated names
+    vluint32_t m_namesCount;  //< Binary: number of names in m_names
+    std::vector<vluint32_t> m_nameIndexes;  //< Binary: name index of each point
+    std::vector<string> m_pointNames;  //< Text: name of each point
+    std::vector<vluint64_t> m_counts;  //< Count of each point
+    // CONSTRUCTORS
+    VlcCoverageFile() : m_testp(NULL), m_binary(false), m_namesCount(0) {}
+};
+
+static vluint64_t vlcGetBinary(const char* cp, int bytes) {
+    vluint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(cp[i]);
+    }
+    return value;
+}
+
+static void vlcPutBinary(std::ostream& os, vluint64_t value, int bytes) {
+    char buf[8];
+    for (int i = 0; i < bytes; ++i) buf[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    os.write(buf, bytes);
+}
+
+bool VlcTop::readCoverageFile(const string& filename, VlcCoverageFile& cfile,
+                              string& errMsg) {
+    // Read the file into cfile, without touching shared state, so may be
+    // called on multiple threads.  Return false and set errMsg on error.
+    std::ifstream is(filename.c_str(), std::ios::in | std::ios::binary);
     if (!is) {
-        if (!nonfatal) v3fatal("Can't read " << filename);
-        return;
+        errMsg = "Can't read " + filename;
+        return false;
     }
 
-    // Testrun and computrons argument unsupported as yet
-    VlcTest* testp = tests().newTest(filename, 0, 0);
+    char magic[VL_COV_BIN_MAGIC_BYTES];
+    is.read(magic, VL_COV_BIN_MAGIC_BYTES);
+    if (is.gcount() == VL_COV_BIN_MAGIC_BYTES
+        && 0 == memcmp(magic, VL_COV_BIN_MAGIC, VL_COV_BIN_MAGIC_BYTES)) {
+        cfile.m_binary = true;
+        std::ostringstream ss;
+        ss << is.rdbuf();
+        const string data = ss.str();
+        const size_t headerBytes = VL_COV_BIN_HEADER_BYTES - VL_COV_BIN_MAGIC_BYTES;
+        if (data.size() < headerBytes) {
+            errMsg = "Corrupt coverage file: " + filename;
+            return false;
+        }
+        cfile.m_namesCount = vlcGetBinary(data.data(), 4);
+        vluint64_t points = vlcGetBinary(data.data() + 4, 4);
+        vluint64_t namesBytes = vlcGetBinary(data.data() + 8, 8);
+        if ((data.size() - headerBytes) < namesBytes
+            || (data.size() - headerBytes - namesBytes) != points * VL_COV_BIN_POINT_BYTES
+            || (namesBytes && data[headerBytes + namesBytes - 1] != '\0')) {
+            errMsg = "Corrupt coverage file: " + filename;
+            return false;
+        }
+        cfile.m_names = data.substr(headerBytes, namesBytes);
+        cfile.m_nameIndexes.reserve(points);
+        cfile.m_counts.reserve(points);
+        for (const char* cp = data.data() + headerBytes + namesBytes;
+             cp < data.data() + data.size(); cp += VL_COV_BIN_POINT_BYTES) {
+            vluint32_t nameIndex = vlcGetBinary(cp, 4);
+            if (nameIndex >= cfile.m_namesCount) {
+                errMsg = "Corrupt coverage file: " + filename;
+                return false;
+            }
+            cfile.m_nameIndexes.push_back(nameIndex);
+            cfile.m_counts.push_back(vlcGetBinary(cp + 8, 8));
+        }
+        return true;
+    }
 
+    is.clear();
+    is.seekg(0);
     while (!is.eof()) {
         string line = V3Os::getline(is);
         // UINFO(9," got "<<line<<endl);
@@ -48,19 +122,136 @@ void VlcTop::readCoverage(const string& filename, bool nonfatal) {
             string point = line.substr(3, secspace - 3);
             vluint64_t hits = atoll(line.c_str() + secspace + 1);
             // UINFO(9,"   point '"<<point<<"'"<<" "<<hits<<endl);
+            cfile.m_pointNames.push_back(point);
+            cfile.m_counts.push_back(hits);
+        }
+    }
+    return true;
+}
 
-            vluint64_t pointnum = points().findAddPoint(point, hits);
-            if (pointnum) {}  // Prevent unused
-            if (opt.rank()) {  // Only if ranking - uses a lot of memory
-                if (hits >= VlcBuckets::sufficient()) {
-                    points().pointNumber(pointnum).testsCoveringInc();
-                    testp->buckets().addData(pointnum, hits);
-                }
+void VlcTop::addTestHits(VlcTest* testp, vluint64_t pointnum, vluint64_t hits) {
+    if (opt.rank()) {  // Only if ranking - uses a lot of memory
+        if (hits >= VlcBuckets::sufficient()) {
+            points().pointNumber(pointnum).testsCoveringInc();
+            testp->buckets().addData(pointnum, hits);
+        }
+    }
+}
+
+void VlcTop::mergeCoverage(const VlcCoverageFile& cfile) {
+    if (cfile.m_binary) {
+        NameTableMap::iterator it = m_nameTables.find(cfile.m_names);
+        if (it == m_nameTables.end()) {
+            std::vector<vluint64_t> pointnums;
+            pointnums.reserve(cfile.m_namesCount);
+            const char* cp = cfile.m_names.data();
+            const char* ep = cp + cfile.m_names.size();
+            for (; cp < ep; cp += strlen(cp) + 1) {
+                pointnums.push_back(points().findAddPoint(cp, 0));
+            }
+            // A short table is caught here, rather than when read, as
+            // only the first file with a given table needs splitting
+            if (pointnums.size() != cfile.m_namesCount) {
+                v3fatal("Corrupt coverage file: " << cfile.m_testp->name());
             }
+            it = m_nameTables.insert(make_pair(cfile.m_names, pointnums)).first;
+        }
+        const std::vector<vluint64_t>& pointnums = it->second;
+        for (size_t i = 0; i < cfile.m_counts.size(); ++i) {
+            vluint64_t pointnum = pointnums[cfile.m_nameIndexes[i]];
+            points().pointNumber(pointnum).countInc(cfile.m_counts[i]);
+            addTestHits(cfile.m_testp, pointnum, cfile.m_counts[i]);
+        }
+    } else {
+        for (size_t i = 0; i < cfile.m_counts.size(); ++i) {
+            vluint64_t pointnum = points().findAddPoint(cfile.m_pointNames[i],
+                                                        cfile.m_counts[i]);
+            addTestHits(cfile.m_testp, pointnum, cfile.m_counts[i]);
+        }
+    }
+}
+
+void VlcTop::readCoverage(const string& filename, bool nonfatal) {
+    UINFO(2, "readCoverage " << filename << endl);
+
+    VlcCoverageFile cfile;
+    string errMsg;
+    if (!readCoverageFile(filename, cfile /*ref*/, errMsg /*ref*/)) {
+        if (!nonfatal) v3fatal(errMsg);
+        return;
+    }
+
+    // Testrun and computrons argument unsupported as yet
+    cfile.m_testp = tests().newTest(filename, 0, 0);
+    mergeCoverage(cfile);
+}
+
+//********************************************************************
+// Reading many files in parallel.  Each thread reads whole files, then
+// merges them under m_mutex; merging binary files from the same model is
+// only summing counts, so reading and parsing is most of the work.
+
+struct VlcReadWork {
+    std::vector<VlcTest*> m_tests;  // Test of each file, created in file order
+    size_t m_next;  // Next file to read, guarded by the VlcTop mutex
+    string m_errMsg;  // First error, guarded by the VlcTop mutex
+    VlcReadWork() : m_next(0) {}
+};
+
+void VlcTop::readCoveragesWorker(VlcTop* topp, void* workp) {
+    VlcReadWork* workerp = static_cast<VlcReadWork*>(workp);
+    while (1) {
+        size_t index;
+        {
+            V3LockGuard lock(topp->m_mutex);
+            if (workerp->m_next >= workerp->m_tests.size() || !workerp->m_errMsg.empty()) break;
+            index = workerp->m_next++;
+        }
+        VlcCoverageFile cfile;
+        cfile.m_testp = workerp->m_tests[index];
+        string errMsg;
+        bool ok = topp->readCoverageFile(cfile.m_testp->name(), cfile /*ref*/, errMsg /*ref*/);
+        V3LockGuard lock(topp->m_mutex);
+        if (!ok) {
+            if (workerp->m_errMsg.empty()) workerp->m_errMsg = errMsg;
+        } else {
+            topp->mergeCoverage(cfile);
         }
     }
 }
 
+void VlcTop::readCoverages(const VlStringSet& filenames) {
+    int jobs = opt.jobs();
+#ifdef VL_PARALLEL_THREADS
+    if (!jobs) jobs = std::thread::hardware_concurrency();
+#else
+    jobs = 1;
+#endif
+    jobs = std::max(1, std::min(jobs, static_cast<int>(filenames.size())));
+    if (jobs <= 1) {
+        for (VlStringSet::const_iterator it = filenames.begin(); it != filenames.end(); ++it) {
+            readCoverage(*it);
+        }
+        return;
+    }
+#ifdef VL_PARALLEL_THREADS
+    UINFO(2, "readCoverages " << filenames.size() << " files on " << jobs << " threads\n");
+    VlcReadWork work;
+    for (VlStringSet::const_iterator it = filenames.begin(); it != filenames.end(); ++it) {
+        work.m_tests.push_back(tests().newTest(*it, 0, 0));
+    }
+    std::vector<std::thread> workers;
+    for (int i = 1; i < jobs; ++i) {
+        workers.push_back(std::thread(readCoveragesWorker, this, &work));
+    }
+    readCoveragesWorker(this, &work);  // This thread works too
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    if (!work.m_errMsg.empty()) v3fatal(work.m_errMsg);
+#endif
+}
+
 void VlcTop::writeCoverage(const string& filename) {
     UINFO(2, "writeCoverage " << filename << endl);
 
@@ -77,6 +268,34 @@ void VlcTop::writeCoverage(const string& filename) {
     }
 }
 
+void VlcTop::writeCoverageBinary(const string& filename) {
+    UINFO(2, "writeCoverageBinary " << filename << endl);
+
+    std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!os) {
+        v3fatal("Can't write " << filename);
+        return;
+    }
+
+    string names;
+    for (VlcPoints::ByName::const_iterator it = m_points.begin(); it != m_points.end(); ++it) {
+        names += it->first;
+        names += '\0';
+    }
+    os.write(VL_COV_BIN_MAGIC, VL_COV_BIN_MAGIC_BYTES);
+    vlcPutBinary(os, m_points.size(), 4);
+    vlcPutBinary(os, m_points.size(), 4);
+    vlcPutBinary(os, names.size(), 8);
+    os.write(names.data(), names.size());
+    vluint32_t index = 0;
+    for (VlcPoints::ByName::const_iterator it = m_points.begin(); it != m_points.end(); ++it) {
+        const VlcPoint& point = m_points.pointNumber(it->second);
+        vlcPutBinary(os, index++, 4);
+        vlcPutBinary(os, 0, 4);
+        vlcPutBinary(os, point.count(), 8);
+    }
+}
+
 //********************************************************************
 
 struct CmpComputrons {
@@ -88,6 +307,18 @@ struct CmpComputrons {
     }
 };
 
+struct VlcRankWork {
+    const std::vector<VlcTest*>* m_testsp;  // Tests to score
+    const VlcBuckets* m_remainingp;  // Points not yet covered
+    std::vector<vluint64_t> m_scores;  // Points each test would newly cover
+};
+
+static void vlcRankScoreWorker(VlcRankWork* workp, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        workp->m_scores[i] = (*workp->m_testsp)[i]->buckets().dataPopCount(*workp->m_remainingp);
+    }
+}
+
 void VlcTop::rank() {
     UINFO(2, "rank...\n");
     vluint64_t nextrank = 1;
@@ -109,31 +340,57 @@ void VlcTop::rank() {
         if (pointp->testsCovering()) remaining.addData(pointp->pointNum(), 1);
     }
 
-    // Additional Greedy algorithm
-    // O(n^2) Ouch.  Probably the thing to do is randomize the order of data
-    // then hierarchically solve a small subset of tests, and take resulting
-    // solution and move up to larger subset of tests.  (Aka quick sort.)
-    while (1) {
+    // Score every test, splitting the tests across threads
+    VlcRankWork work;
+    work.m_testsp = &bytime;
+    work.m_remainingp = &remaining;
+    work.m_scores.resize(bytime.size());
+    int jobs = 1;
+#ifdef VL_PARALLEL_THREADS
+    jobs = opt.jobs() ? opt.jobs() : std::thread::hardware_concurrency();
+    jobs = std::max(1, std::min(jobs, static_cast<int>(bytime.size())));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < jobs; ++i) {
+        workers.push_back(std::thread(vlcRankScoreWorker, &work,
+                                      bytime.size() * i / jobs,
+                                      bytime.size() * (i + 1) / jobs));
+    }
+#endif
+    vlcRankScoreWorker(&work, 0, bytime.size() / jobs);  // This thread works too
+#ifdef VL_PARALLEL_THREADS
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+#endif
+
+    // Greedy algorithm: repeatedly pick the test covering the most
+    // remaining points, the earliest in bytime on a tie.  A test's score
+    // can only fall as points are covered, so a queue of possibly stale
+    // scores gives an upper bound for each test.  When the best test's
+    // rescore still beats every other bound it is the true best, so most
+    // tests are rescored only a few times rather than once per pick.
+    typedef std::pair<vluint64_t, size_t> ScoreIndex;  // Score, and ~index for ties
+    std::priority_queue<ScoreIndex> queue;
+    for (size_t i = 0; i < bytime.size(); ++i) {
+        if (work.m_scores[i]) queue.push(std::make_pair(work.m_scores[i], ~i));
+    }
+    while (!queue.empty()) {
         if (debug()) { UINFO(9, "Left on iter" << nextrank << ": "); remaining.dump(); }
-        VlcTest* bestTestp = NULL;
-        vluint64_t bestRemain = 0;
-        for (std::vector<VlcTest*>::iterator it = bytime.begin(); it != bytime.end(); ++it) {
-            VlcTest* testp = *it;
-            if (!testp->rank()) {
-                vluint64_t remain = testp->buckets().dataPopCount(remaining);
-                if (remain > bestRemain) {
-                    bestTestp = testp;
-                    bestRemain = remain;
-                }
+        ScoreIndex top = queue.top();
+        queue.pop();
+        VlcTest* testp = bytime[~top.second];
+        vluint64_t remain = testp->buckets().dataPopCount(remaining);
+        if (!remain) continue;  // Now covers nothing more
+        if (remain < top.first) {
+            ScoreIndex rescored = std::make_pair(remain, top.second);
+            if (!queue.empty() && rescored < queue.top()) {
+                queue.push(rescored);  // Another test may now be better
+                continue;
             }
         }
-        if (VlcTest* testp = bestTestp) {
-            testp->rank(nextrank++);
-            testp->rankPoints(bestRemain);
-            remaining.orData(bestTestp->buckets());
-        } else {
-            break;  // No test covering more stuff found
-        }
+        testp->rank(nextrank++);
+        testp->rankPoints(remain);
+        remaining.orData(testp->buckets());
     }
 }
 
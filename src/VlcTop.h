@@ -24,6 +24,12 @@
 #include "VlcTest.h"
 #include "VlcPoint.h"
 #include "VlcSource.h"
+#include "V3Parallel.h"
+
+#include <map>
+#include <vector>
+
+class VlcCoverageFile;
 
 //######################################################################
 // VlcTop - Top level options container
@@ -37,8 +43,17 @@ private:
     VlcTests m_tests;  //< List of all tests (all coverage files)
     VlcPoints m_points;  //< List of all points
     VlcSources m_sources;  //< List of all source files to annotate
+    // Point numbers of each binary file name table read, so files from the
+    // same model need not look up their names again
+    typedef std::map<string, std::vector<vluint64_t> > NameTableMap;
+    NameTableMap m_nameTables;
+    V3Mutex m_mutex;  //< Guards merging of files read in parallel
 
     // METHODS
+    bool readCoverageFile(const string& filename, VlcCoverageFile& cfile, string& errMsg);
+    void mergeCoverage(const VlcCoverageFile& cfile);
+    void addTestHits(VlcTest* testp, vluint64_t pointnum, vluint64_t hits);
+    static void readCoveragesWorker(VlcTop* topp, void* workp);
     void createDir(const string& dirname);
     void annotateCalc();
     void annotateCalcNeeded();
@@ -57,7 +72,10 @@ public:
     // METHODS
     void annotate(const string& dirname);
     void readCoverage(const string& filename, bool nonfatal = false);
+    // Read and sum all files, on opt.jobs() threads
+    void readCoverages(const VlStringSet& filenames);
     void writeCoverage(const string& filename);
+    void writeCoverageBinary(const string& filename);
 
     void rank();
 };
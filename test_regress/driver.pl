@@ -823,8 +823,11 @@ sub compile_vlt_flags {
     $self->{sc} = 1 if ($checkflags =~ /-sc\b/);
     $self->{trace} = ($opt_trace || $checkflags =~ /-trace\b/
                       || $checkflags =~ /-trace-fst\b/
-                      || $checkflags =~ /-trace-fst-thread\b/);
+                      || $checkflags =~ /-trace-fst-thread\b/
+                      || $checkflags =~ /-trace-vcd-thread\b/
+                      || $checkflags =~ /-trace-raw\b/);
     $self->{trace_format} = (($checkflags =~ /-trace-fst/ && 'fst-c')
+                             || ($checkflags =~ /-trace-raw/ && 'raw-c')
                              || ($self->{sc} && 'vcd-sc')
                              || (!$self->{sc} && 'vcd-c'));
     $self->{savable} = 1 if ($checkflags =~ /-savable\b/);
@@ -1388,6 +1391,7 @@ sub cmake_version {
 sub trace_filename {
     my $self = shift;
     return "$self->{obj_dir}/simx.fst" if $self->{trace_format} =~ /^fst/;
+    return "$self->{obj_dir}/simx.raw" if $self->{trace_format} =~ /^raw/;
     return "$self->{obj_dir}/simx.vcd";
 }
 
@@ -1617,6 +1621,7 @@ sub _make_main {
     print $fh "#include \"systemc.h\"\n" if $self->sc;
     print $fh "#include \"verilated_fst_c.h\"\n" if $self->{trace} && $self->{trace_format} eq 'fst-c';
     print $fh "#include \"verilated_vcd_c.h\"\n" if $self->{trace} && $self->{trace_format} eq 'vcd-c';
+    print $fh "#include \"verilated_raw_c.h\"\n" if $self->{trace} && $self->{trace_format} eq 'raw-c';
     print $fh "#include \"verilated_vcd_sc.h\"\n" if $self->{trace} && $self->{trace_format} eq 'vcd-sc';
     print $fh "#include \"verilated_save.h\"\n" if $self->{savable};
 
@@ -1681,6 +1686,7 @@ sub _make_main {
         $fh->print("    Verilated::traceEverOn(true);\n");
         $fh->print("    VerilatedFstC* tfp = new VerilatedFstC;\n") if $self->{trace_format} eq 'fst-c';
         $fh->print("    VerilatedVcdC* tfp = new VerilatedVcdC;\n") if $self->{trace_format} eq 'vcd-c';
+        $fh->print("    VerilatedRawC* tfp = new VerilatedRawC;\n") if $self->{trace_format} eq 'raw-c';
         $fh->print("    VerilatedVcdSc* tfp = new VerilatedVcdSc;\n") if $self->{trace_format} eq 'vcd-sc';
         $fh->print("    topp->trace(tfp, 99);\n");
         $fh->print("    tfp->open(\"".$self->trace_filename."\");\n");
@@ -0,0 +1,60 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(vlt => 1);
+
+# Use a copy of the source, so it can be changed
+my $source = "$Self->{obj_dir}/t_flag_cache_dir.v";
+write_wholefile($source, file_contents("t/t_EXAMPLE.v"));
+my $out = "$Self->{obj_dir}/out";
+
+sub verilate {
+    my $log = shift;
+    run(logfile => $log,
+        cmd => ["perl",
+                "$ENV{VERILATOR_ROOT}/bin/verilator",
+                "--prefix", $Self->{VM_PREFIX},
+                "-cc", "-Mdir", $out,
+                "--cache-dir", "$Self->{obj_dir}/cache",
+                "--debugi-V3File", "1",
+                $source]);
+}
+
+verilate("$Self->{obj_dir}/vlt_first.log");
+file_grep_not("$Self->{obj_dir}/vlt_first.log", qr/--cache-dir: Restoring/);
+file_grep("$Self->{obj_dir}/vlt_first.log", qr/--cache-dir: Stored/);
+my $cppFilename = "$out/$Self->{VM_PREFIX}.cpp";
+my $cpp = slurp($cppFilename);
+
+# Source touched but unchanged; restored, even though the output was deleted
+utime(undef, undef, $source);
+unlink($cppFilename);
+verilate("$Self->{obj_dir}/vlt_touched.log");
+file_grep("$Self->{obj_dir}/vlt_touched.log", qr/--cache-dir: Restoring/);
+slurp($cppFilename) eq $cpp or $Self->error("Restored file differs: $cppFilename");
+
+# Source changed; Verilated again
+write_wholefile($source, file_contents("t/t_EXAMPLE.v")."// Changed\n");
+verilate("$Self->{obj_dir}/vlt_changed.log");
+file_grep_not("$Self->{obj_dir}/vlt_changed.log", qr/--cache-dir: Restoring/);
+
+ok(1);
+
+sub slurp {
+    # Not file_contents, as that caches the contents
+    my $filename = shift;
+    my $fh = IO::File->new("<$filename") or return "";
+    local $/; undef $/;
+    my $wholefile = <$fh>;
+    $fh->close;
+    return $wholefile;
+}
+
+1;
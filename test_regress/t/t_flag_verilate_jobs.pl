@@ -0,0 +1,44 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(vlt_all => 1);
+
+top_filename("t/t_flag_csplit.v");
+
+compile(
+    verilator_flags2 => ["--output-split 1 --verilate-jobs 4"],
+    );
+
+execute(
+    check_finished => 1,
+    );
+
+# Files written must not depend on the number of jobs
+foreach my $jobs (1, 4) {
+    my $dir = "$Self->{obj_dir}/jobs$jobs";
+    mkdir $dir;
+    run(logfile => "$dir/vlt_compile.log",
+        cmd => ["perl",
+                "$ENV{VERILATOR_ROOT}/bin/verilator",
+                "--prefix", $Self->{VM_PREFIX},
+                "-cc", "--output-split 1",
+                "--verilate-jobs", $jobs,
+                "-Mdir", $dir,
+                $Self->{top_filename}]);
+}
+foreach my $file (glob("$Self->{obj_dir}/jobs1/*.cpp"),
+                  glob("$Self->{obj_dir}/jobs1/*.h"),
+                  glob("$Self->{obj_dir}/jobs1/*_classes.mk")) {
+    (my $other = $file) =~ s!/jobs1/!/jobs4/!;
+    files_identical($other, $file);
+}
+
+ok(1);
+1;
@@ -0,0 +1,31 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(vlt => 1);
+
+compile(
+    verilator_flags2 => ["--hierarchical --verilate-jobs 2"],
+    );
+
+execute(
+    check_finished => 1,
+    );
+
+# Each hier block was Verilated into its own library
+file_grep("$Self->{obj_dir}/$Self->{VM_PREFIX}__hier.mk", qr/hier_sub2/);
+foreach my $block ("sub0", "sub1", "sub2") {
+    my $lib = "$Self->{obj_dir}/V$block/lib${block}_Vhier.a";
+    -r $lib or $Self->error("Missing hier block library: $lib");
+}
+# The top doesn't contain the blocks' logic
+file_grep_not("$Self->{obj_dir}/$Self->{VM_PREFIX}.h", qr/i_sub2/);
+
+ok(1);
+1;
@@ -0,0 +1,63 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed into the Public Domain, for any use,
+// without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+module t (/*AUTOARG*/
+   // Inputs
+   clk
+   );
+   input clk;
+
+   integer cyc = 0;
+   logic [7:0] in;
+   wire [7:0]  out0;
+   wire [7:0]  out1;
+   wire [7:0]  out2;
+
+   sub0 i_sub0a (.clk(clk), .in(in), .out(out0));
+   sub0 i_sub0b (.clk(clk), .in(out0), .out(out1));
+   sub1 i_sub1 (.clk(clk), .in(in), .out(out2));
+
+   always @(posedge clk) begin
+      cyc <= cyc + 1;
+      in <= cyc[7:0];
+      if (cyc > 4) begin
+         // in increments each cycle; two sub0's add 2, sub1 and sub2 add 3,
+         // each two cycles later
+         if (out1 != in) $stop;
+         if (out2 != in + 8'd1) $stop;
+      end
+      if (cyc == 10) begin
+         $write("*-* All Finished *-*\n");
+         $finish;
+      end
+   end
+endmodule
+
+module sub0 (
+   input clk,
+   input [7:0] in,
+   output logic [7:0] out);
+   /*verilator hier_block*/
+   always_ff @(posedge clk) out <= in + 8'd1;
+endmodule
+
+module sub1 (
+   input clk,
+   input [7:0] in,
+   output logic [7:0] out);
+   /*verilator hier_block*/
+   logic [7:0] mid;
+   sub2 i_sub2 (.clk(clk), .in(in), .out(mid));
+   always_ff @(posedge clk) out <= mid + 8'd1;
+endmodule
+
+module sub2 (
+   input clk,
+   input [7:0] in,
+   output logic [7:0] out);
+   /*verilator hier_block*/
+   always_ff @(posedge clk) out <= in + 8'd2;
+endmodule
@@ -0,0 +1,29 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(simulator => 1);
+
+compile(
+    verilator_flags2 => ["--debugi-V3PreShell 4"],
+    );
+
+execute(
+    check_finished => 1,
+    );
+
+if ($Self->{vlt_all}) {
+    # Only the fully guarded file is skipped, once
+    my $log = "$Self->{obj_dir}/vlt_compile.log";
+    file_grep($log, qr/t_preproc_include_guard.vh skipped, guarded by `T_PREPROC_INCLUDE_GUARD_VH/);
+    file_grep_not($log, qr/t_preproc_include_guard_(else|after).vh skipped/);
+}
+
+ok(1);
+1;
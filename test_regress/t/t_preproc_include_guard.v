@@ -0,0 +1,41 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+module t (/*AUTOARG*/);
+   integer num_else;
+   integer num_after;
+   initial begin
+      num_else = 0;
+      num_after = 0;
+
+      // Guarded, so second include may be skipped
+`include "t_preproc_include_guard.vh"
+`include "t_preproc_include_guard.vh"
+      if (`GUARD_VALUE != 5) $stop;
+
+      // Guard is no longer defined, so must include again
+`undef T_PREPROC_INCLUDE_GUARD_VH
+`undef GUARD_VALUE
+`include "t_preproc_include_guard.vh"
+`ifndef GUARD_VALUE
+      $stop;
+`endif
+
+      // Has an `else part, so not guarded
+`include "t_preproc_include_guard_else.vh"
+`include "t_preproc_include_guard_else.vh"
+`include "t_preproc_include_guard_else.vh"
+      if (num_else != 2) $stop;
+
+      // Has text after the `endif, so not guarded
+`include "t_preproc_include_guard_after.vh"
+`include "t_preproc_include_guard_after.vh"
+      if (num_after != 2) $stop;
+
+      $write("*-* All Finished *-*\n");
+      $finish;
+   end
+endmodule
@@ -0,0 +1,15 @@
+// DESCRIPTION: Verilator: Verilog Test include file
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+`ifndef T_PREPROC_INCLUDE_GUARD_VH
+ `define T_PREPROC_INCLUDE_GUARD_VH
+ `define GUARD_VALUE 5
+ `ifdef NEVER
+  "`endif"
+ `endif
+ `define GUARD_CONT(a) \
+  `endif
+`endif  // T_PREPROC_INCLUDE_GUARD_VH
@@ -0,0 +1,11 @@
+// DESCRIPTION: Verilator: Verilog Test include file
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+`ifndef T_PREPROC_INCLUDE_GUARD_ELSE_VH
+ `define T_PREPROC_INCLUDE_GUARD_ELSE_VH
+`else
+      num_else = num_else + 1;
+`endif
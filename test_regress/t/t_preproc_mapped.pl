@@ -0,0 +1,55 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+use IO::File;
+
+scenarios(vlt => 1);
+
+sub gen {
+    my $filename = shift;
+    my $n = shift;
+
+    # Large enough that it's memory mapped rather than read
+    my $fh = IO::File->new(">$filename");
+    $fh->print("// Generated by t_preproc_mapped.pl\n");
+    $fh->print("`define VALUE 1\n");
+    for (my $i=0; $i<$n; ++$i) {
+        $fh->print("// Padding line $i, so the file is large\n");
+    }
+    $fh->print("`define VALUE 2\n");
+    $fh->print("module t;\n");
+    $fh->print("  initial begin\n");
+    $fh->print("    if (`VALUE != 2) \$stop;\n");
+    $fh->print('    $write("*-* All Finished *-*\n");',"\n");
+    $fh->print('    $finish;',"\n");
+    $fh->print("  end\n");
+    $fh->print("endmodule\n");
+}
+
+top_filename("$Self->{obj_dir}/t_preproc_mapped.v");
+
+gen($Self->{top_filename}, 5000);
+
+compile(
+    verilator_flags2 => ["-Wno-fatal --debugi-V3File 4"],
+    );
+
+execute(
+    check_finished => 1,
+    );
+
+my $log = "$Self->{obj_dir}/vlt_compile.log";
+file_grep($log, qr/Mapped \d+ bytes of .*t_preproc_mapped.v/);
+# Warning context comes from the mapped file
+file_grep($log, qr/Redefining existing define: 'VALUE'/);
+file_grep($log, qr/\n`define VALUE 2\n/);
+file_grep($log, qr/\n`define VALUE 1\n/);
+
+ok(1);
+1;
@@ -0,0 +1,29 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(vlt_all => 1);
+
+top_filename("t/t_order_clkinst.v");
+
+compile(
+    verilator_flags2 => ["--prof-settle --stats"],
+    );
+
+file_grep($Self->{stats}, qr/Optimizations, Change detects\s+(\d+)/i);
+
+execute(
+    check_finished => 1,
+    );
+
+# Combinational loops in this design need several passes
+file_grep($Self->{run_log_filename}, qr/Settle loop: \d+ evals, \d+ passes, [\d.]+ passes average, [2-9]\d* passes maximum/);
+
+ok(1);
+1;
@@ -0,0 +1,50 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(vlt_all => 1);
+
+top_filename("t/t_reloop_cam.v");
+
+compile(
+    verilator_flags2 => ["-unroll-count 1024",
+                         $Self->wno_unopthreads_for_few_cores(),
+                         "--verilate-jobs 4 --stats"],
+    );
+
+execute(
+    check_finished => 1,
+    );
+
+# Functions are expanded and relooped in parallel, with the same results
+file_grep($Self->{stats}, qr/Optimizations, Reloop iterations\s+(\d+)/i,
+          768);
+file_grep($Self->{stats}, qr/Optimizations, Reloops\s+(\d+)/i,
+          3);
+
+foreach my $jobs (1, 4) {
+    my $dir = "$Self->{obj_dir}/jobs$jobs";
+    mkdir $dir;
+    run(logfile => "$dir/vlt_compile.log",
+        cmd => ["perl",
+                "$ENV{VERILATOR_ROOT}/bin/verilator",
+                "--prefix", $Self->{VM_PREFIX},
+                "-cc", "-unroll-count 1024",
+                "--verilate-jobs", $jobs,
+                "-Mdir", $dir,
+                $Self->{top_filename}]);
+}
+foreach my $file (glob("$Self->{obj_dir}/jobs1/*.cpp"),
+                  glob("$Self->{obj_dir}/jobs1/*.h")) {
+    (my $other = $file) =~ s!/jobs1/!/jobs4/!;
+    files_identical($other, $file);
+}
+
+ok(1);
+1;
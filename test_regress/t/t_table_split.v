@@ -0,0 +1,63 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+module t (/*AUTOARG*/
+   // Inputs
+   clk
+   );
+   input clk;
+
+   integer cyc = 0;
+   reg [9:0] instr;
+
+   // Decoder ignores instr[5:3], so a two-level table shares those rows
+   function [12:0] decode(input [9:0] i);
+      reg [2:0] fn;
+      begin
+         fn = i[2:0];
+         case (i[9:6])
+           4'h0: decode = {8'h01, 1'b0, fn, 1'b1};
+           4'h1: decode = {8'h02, fn, 1'b0, fn[0]};
+           4'h2: decode = {8'h04, ~fn, 1'b1, 1'b0};
+           4'h3: decode = {5'h08, fn, 4'h3, fn[1]};
+           4'h4: decode = {8'h10, fn[1:0], fn[2:1], 1'b1};
+           4'h5: decode = {8'h20, 4'h5, fn[2]};
+           4'h6: decode = {fn, 5'h0c, ~fn[0], fn, 1'b0};
+           4'h7: decode = {8'h40, fn + 3'd1, 1'b1, 1'b1};
+           4'h8: decode = {8'h80, fn ^ 3'h5, 1'b0, 1'b0};
+           4'h9: decode = {fn, fn, 2'h1, ~fn, 1'b1, fn[0]};
+           4'ha: decode = {8'h03, fn - 3'd2, fn[2], fn[1]};
+           4'hb: decode = {8'h05, fn & 3'h6, 1'b1, fn[0]};
+           4'hc: decode = {8'h09, fn | 3'h1, 1'b0, fn[2]};
+           4'hd: decode = {fn[0], 7'h11, 4'ha, 1'b0};
+           4'he: decode = {8'h21, fn[2:1], fn[0], fn[0], fn[1]};
+           default: decode = {8'hff, fn, 1'b1, 1'b1};
+         endcase
+      end
+   endfunction
+
+   reg [12:0] dec;
+   always @(/*AS*/instr) begin
+      dec = decode(instr);
+   end
+
+   wire [12:0] expect_dec = decode(instr);
+
+   always @ (posedge clk) begin
+      cyc <= cyc + 1;
+      instr <= cyc[9:0];
+      if (cyc > 1) begin
+         if (dec !== expect_dec) begin
+            $write("%%Error: instr=%x dec=%x exp=%x\n", instr, dec, expect_dec);
+            $stop;
+         end
+      end
+      if (cyc == 1030) begin
+         $write("*-* All Finished *-*\n");
+         $finish;
+      end
+   end
+endmodule
@@ -0,0 +1,48 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2020 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+#include <verilated.h>
+#include <verilated_threads.h>
+#include VM_PREFIX_INCLUDE
+
+#include <thread>
+
+double sc_time_stamp() { return 0; }
+
+// Each model runs past its $finish; gotFinish is global so is ignored
+static void run(VM_PREFIX* topp) {
+    topp->clk = 0;
+    topp->eval();
+    for (int cyc = 0; cyc < 100; ++cyc) {
+        topp->clk = !topp->clk;
+        topp->eval();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Verilated::debug(0);
+
+    // One pool for all models, allowing two concurrent dynamic evals
+    VlThreadPool* poolp = new VlThreadPool(3, false, 1024, 2);
+    VlThreadPool::shared(poolp);
+
+    VM_PREFIX* ap = new VM_PREFIX("a");
+    VM_PREFIX* bp = new VM_PREFIX("b");
+    std::thread at(run, ap);
+    std::thread bt(run, bp);
+    at.join();
+    bt.join();
+    ap->final();
+    bp->final();
+    VL_DO_DANGLING(delete ap, ap);
+    VL_DO_DANGLING(delete bp, bp);
+
+    VlThreadPool::shared(NULL);
+    VL_DO_DANGLING(delete poolp, poolp);
+    return 0;
+}
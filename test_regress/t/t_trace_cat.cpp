@@ -38,7 +38,7 @@ int main(int argc, char** argv, char** env) {
         top->eval();
 
         if ((main_time % 100) == 0) {
-#if defined(T_TRACE_CAT)
+#if defined(T_TRACE_CAT) || defined(T_TRACE_CAT_VCD_THREAD)
             tfp->openNext(true);
 #elif defined(T_TRACE_CAT_REOPEN)
             tfp->close();
@@ -0,0 +1,37 @@
+#!/usr/bin/perl
+if (!$::Driver) { use FindBin; exec("$FindBin::Bin/bootstrap.pl", @ARGV, $0); die; }
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2020 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+scenarios(dist => 1);
+
+run(cmd => ["../bin/verilator_coverage",
+            "--jobs 2",
+            "--write-binary", "$Self->{obj_dir}/coverage.bin",
+            "t/t_vlcov_data_a.dat",
+            "t/t_vlcov_data_b.dat",
+            "t/t_vlcov_data_c.dat",
+            "t/t_vlcov_data_d.dat",
+    ]);
+
+# Read back the binary file, which must sum to the same as a text merge
+run(cmd => ["../bin/verilator_coverage",
+            "--write", "$Self->{obj_dir}/coverage.dat",
+            "$Self->{obj_dir}/coverage.bin",
+    ]);
+
+$ENV{LC_ALL} = "C";
+run(cmd => ["sort",
+            "$Self->{obj_dir}/coverage.dat",
+            "> $Self->{obj_dir}/coverage-sort.dat",
+    ]);
+
+files_identical("$Self->{obj_dir}/coverage-sort.dat", "t/t_vlcov_merge.out");
+
+ok(1);
+1;